@@ -0,0 +1,194 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "gif.hpp"
+
+using namespace std;
+
+namespace
+{
+  uint32_t readWord(const uint8_t *qword, unsigned int word)
+  {
+    uint32_t value;
+    memcpy(&value, qword + word * 4, sizeof(value));
+    return value;
+  }
+
+  uint64_t readDoubleword(const uint8_t *data)
+  {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  size_t dataQwords(const GIFTag &tag)
+  {
+    switch (tag.flg)
+    {
+      case GIF_FLG_PACKED:
+        return static_cast<size_t>(tag.nloop) * tag.nreg;
+      case GIF_FLG_REGLIST:
+        return (static_cast<size_t>(tag.nloop) * tag.nreg + 1) / 2;
+      default:
+        return tag.nloop;
+    }
+  }
+}
+
+GIFTag decodeGIFTag(const uint8_t *qword)
+{
+  uint64_t low = readDoubleword(qword);
+  GIFTag tag;
+  tag.nloop = low & 0x7fff;
+  tag.eop = (low >> 15) & 1;
+  tag.pre = (low >> 46) & 1;
+  tag.prim = (low >> 47) & 0x7ff;
+  tag.flg = (low >> 58) & 3;
+  tag.nreg = (low >> 60) == 0 ? 16 : low >> 60;
+  tag.regs = readDoubleword(qword + 8);
+  return tag;
+}
+
+GIF::GIF(GIFPacketHandler *handler) : handler(handler)
+{
+}
+
+size_t GIF::processPacket(const uint8_t *data, size_t qwords)
+{
+  if (qwords == 0)
+  {
+    throw runtime_error("GIF packet exceeds its buffer.");
+  }
+
+  GIFTag tag = decodeGIFTag(data);
+  size_t size = dataQwords(tag);
+  if (size > qwords - 1)
+  {
+    throw runtime_error("GIF packet exceeds its buffer.");
+  }
+
+  handler->gifTag(tag);
+  const uint8_t *payload = data + GIF_QWORD_BYTES;
+  switch (tag.flg)
+  {
+    case GIF_FLG_PACKED:
+      if (tag.pre)
+      {
+        handler->writeRegister(GIF_REG_PRIM, tag.prim);
+      }
+      processPacked(tag, payload);
+      break;
+    case GIF_FLG_REGLIST:
+      processRegList(tag, payload);
+      break;
+    default:
+      if (size > 0)
+      {
+        handler->writeImage(payload, size);
+      }
+      break;
+  }
+  return size + 1;
+}
+
+size_t GIF::processPacketChain(const uint8_t *data, size_t qwords)
+{
+  size_t consumed = 0;
+  while (true)
+  {
+    const uint8_t *packet = data + consumed * GIF_QWORD_BYTES;
+    bool endOfPacket = consumed < qwords && decodeGIFTag(packet).eop;
+    consumed += processPacket(packet, qwords - consumed);
+    if (endOfPacket)
+    {
+      return consumed;
+    }
+  }
+}
+
+// Q is latched by ST and reset to 1.0 by every tag, as on the GIF.
+void GIF::processPacked(const GIFTag &tag, const uint8_t *data)
+{
+  uint8_t regs[16];
+  for (unsigned int index = 0; index < tag.nreg; index++)
+  {
+    regs[index] = tag.reg(index);
+  }
+
+  uint32_t q = GIF_Q_ONE;
+  for (unsigned int loop = 0; loop < tag.nloop; loop++)
+  {
+    for (unsigned int index = 0; index < tag.nreg; index++, data += GIF_QWORD_BYTES)
+    {
+      uint8_t reg = regs[index];
+      switch (reg)
+      {
+        case GIF_REG_PRIM:
+          handler->writeRegister(reg, readWord(data, 0) & 0x7ff);
+          break;
+        case GIF_REG_RGBAQ:
+          handler->writeRegister(reg,
+            (readWord(data, 0) & 0xff) |
+            (readWord(data, 1) & 0xff) << 8 |
+            (readWord(data, 2) & 0xff) << 16 |
+            static_cast<uint64_t>(readWord(data, 3) & 0xff) << 24 |
+            static_cast<uint64_t>(q) << 32);
+          break;
+        case GIF_REG_ST:
+          q = readWord(data, 2);
+          handler->writeRegister(reg, readDoubleword(data));
+          break;
+        case GIF_REG_UV:
+          handler->writeRegister(reg, (readWord(data, 0) & 0x3fff) | (readWord(data, 1) & 0x3fff) << 16);
+          break;
+        case GIF_REG_XYZF2:
+        {
+          bool disableDrawing = (readWord(data, 3) >> 15) & 1;
+          handler->writeRegister(disableDrawing ? GS_REG_XYZF3 : GIF_REG_XYZF2,
+            (readWord(data, 0) & 0xffff) |
+            (readWord(data, 1) & 0xffff) << 16 |
+            static_cast<uint64_t>((readWord(data, 2) >> 4) & 0xffffff) << 32 |
+            static_cast<uint64_t>((readWord(data, 3) >> 4) & 0xff) << 56);
+          break;
+        }
+        case GIF_REG_XYZ2:
+        {
+          bool disableDrawing = (readWord(data, 3) >> 15) & 1;
+          handler->writeRegister(disableDrawing ? GS_REG_XYZ3 : GIF_REG_XYZ2,
+            (readWord(data, 0) & 0xffff) |
+            (readWord(data, 1) & 0xffff) << 16 |
+            static_cast<uint64_t>(readWord(data, 2)) << 32);
+          break;
+        }
+        case GIF_REG_FOG:
+          handler->writeRegister(reg, static_cast<uint64_t>((readWord(data, 3) >> 4) & 0xff) << 56);
+          break;
+        case GIF_REG_AD:
+          handler->writeRegister(data[8], readDoubleword(data));
+          break;
+        case GIF_REG_NOP:
+          break;
+        default:
+          handler->writeRegister(reg, readDoubleword(data));
+          break;
+      }
+    }
+  }
+}
+
+// REGLIST data is one doubleword per register; A+D and NOP output nothing
+// and an odd count leaves the last doubleword as padding.
+void GIF::processRegList(const GIFTag &tag, const uint8_t *data)
+{
+  for (unsigned int loop = 0; loop < tag.nloop; loop++)
+  {
+    for (unsigned int index = 0; index < tag.nreg; index++, data += 8)
+    {
+      uint8_t reg = tag.reg(index);
+      if (reg != GIF_REG_AD && reg != GIF_REG_NOP)
+      {
+        handler->writeRegister(reg, readDoubleword(data));
+      }
+    }
+  }
+}
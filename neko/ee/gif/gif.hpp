@@ -0,0 +1,73 @@
+#ifndef GIF_H
+#define GIF_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define GIF_QWORD_BYTES 16
+#define GIF_FLG_PACKED 0
+#define GIF_FLG_REGLIST 1
+#define GIF_FLG_IMAGE 2
+#define GIF_REG_PRIM 0x0
+#define GIF_REG_RGBAQ 0x1
+#define GIF_REG_ST 0x2
+#define GIF_REG_UV 0x3
+#define GIF_REG_XYZF2 0x4
+#define GIF_REG_XYZ2 0x5
+#define GIF_REG_FOG 0xa
+#define GIF_REG_AD 0xe
+#define GIF_REG_NOP 0xf
+#define GS_REG_XYZF3 0x0c
+#define GS_REG_XYZ3 0x0d
+#define GIF_Q_ONE 0x3f800000
+
+struct GIFTag
+{
+  std::uint16_t nloop = 0;
+  bool eop = false;
+  bool pre = false;
+  std::uint16_t prim = 0;
+  std::uint8_t flg = GIF_FLG_PACKED;
+  std::uint8_t nreg = 16;
+  std::uint64_t regs = 0;
+
+  std::uint8_t reg(unsigned int index) const
+  {
+    return (regs >> (index * 4)) & 0xf;
+  }
+};
+
+GIFTag decodeGIFTag(const std::uint8_t *qword);
+
+// Receives decoded GIF output; a GS model implements this. Image data points
+// into the buffer being processed and is only valid during the call.
+class GIFPacketHandler
+{
+  public:
+    virtual ~GIFPacketHandler() {}
+    virtual void gifTag(const GIFTag &tag) = 0;
+    virtual void writeRegister(std::uint8_t address, std::uint64_t value) = 0;
+    virtual void writeImage(const std::uint8_t *data, std::size_t qwords) = 0;
+};
+
+// Parses GIF packets in place from a caller-owned qword buffer, such as VU1
+// data memory or a DMA source. PACKED data is converted to GS register
+// writes, REGLIST data is passed through and IMAGE data is handed over
+// without copying.
+class GIF
+{
+  public:
+    explicit GIF(GIFPacketHandler *handler);
+    // Processes one GIFtag and its data; returns the qwords consumed.
+    std::size_t processPacket(const std::uint8_t *data, std::size_t qwords);
+    // Processes tags until one with EOP set; returns the qwords consumed.
+    std::size_t processPacketChain(const std::uint8_t *data, std::size_t qwords);
+
+  private:
+    GIFPacketHandler *handler;
+
+    void processPacked(const GIFTag &tag, const std::uint8_t *data);
+    void processRegList(const GIFTag &tag, const std::uint8_t *data);
+};
+
+#endif
@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "vif.hpp"
+
+using namespace std;
+
+VIF::VIF(VPU *vpu) : vpu(vpu)
+{
+  reset();
+}
+
+void VIF::reset()
+{
+  registers = VIFUnpackRegisters();
+  cl = 0;
+  wl = 0;
+  baseRegister = 0;
+  offsetRegister = 0;
+  topsRegister = 0;
+  topRegister = 0;
+  itopsRegister = 0;
+  itopRegister = 0;
+  markRegister = 0;
+  doubleBufferFlag = false;
+  waiting = false;
+  command = VIF_CMD_NOP;
+  commandCode = 0;
+  payloadWords = 0;
+  payloadIndex = 0;
+  unpackCarryBytes = 0;
+}
+
+size_t VIF::write(const uint32_t *words, size_t count)
+{
+  waiting = false;
+  size_t consumed = 0;
+  while (consumed < count)
+  {
+    if (payloadIndex < payloadWords)
+    {
+      consumed += continueCommand(words + consumed, count - consumed);
+      continue;
+    }
+
+    if (!beginCommand(words[consumed]))
+    {
+      waiting = true;
+      break;
+    }
+    consumed++;
+  }
+  return consumed;
+}
+
+bool VIF::waitingForVU() const
+{
+  return waiting;
+}
+
+bool VIF::isVIF1() const
+{
+  return vpu->unitType() == VPUType::VU1;
+}
+
+uint8_t VIF::cycleLength() const
+{
+  return cl;
+}
+
+uint8_t VIF::writeLength() const
+{
+  return wl;
+}
+
+const VIFUnpackRegisters &VIF::unpackRegisters() const
+{
+  return registers;
+}
+
+uint16_t VIF::base() const
+{
+  return baseRegister;
+}
+
+uint16_t VIF::offset() const
+{
+  return offsetRegister;
+}
+
+uint16_t VIF::tops() const
+{
+  return topsRegister;
+}
+
+uint16_t VIF::top() const
+{
+  return topRegister;
+}
+
+uint16_t VIF::itops() const
+{
+  return itopsRegister;
+}
+
+uint16_t VIF::itop() const
+{
+  return itopRegister;
+}
+
+uint16_t VIF::mark() const
+{
+  return markRegister;
+}
+
+// Returns false without consuming the code when it has to wait for the VU.
+bool VIF::beginCommand(uint32_t code)
+{
+  uint16_t immediate = code & 0xffff;
+  uint8_t num = (code >> 16) & 0xff;
+  uint8_t cmd = (code >> 24) & 0x7f;
+  bool vuRunning = vpu->getState() == VPU_STATE_RUN;
+
+  if ((cmd & VIF_CMD_UNPACK) == VIF_CMD_UNPACK)
+  {
+    beginUnpack(code);
+    return true;
+  }
+
+  bool vif1Only = cmd == VIF_CMD_OFFSET || cmd == VIF_CMD_BASE || cmd == VIF_CMD_FLUSH || cmd == VIF_CMD_FLUSHA;
+  if (vif1Only && !isVIF1())
+  {
+    throw runtime_error("Unsupported VIF command.");
+  }
+
+  size_t words = 0;
+  switch (cmd)
+  {
+    case VIF_CMD_NOP:
+      break;
+    case VIF_CMD_STCYCL:
+      cl = immediate & 0xff;
+      wl = immediate >> 8;
+      break;
+    case VIF_CMD_OFFSET:
+      offsetRegister = immediate & 0x3ff;
+      doubleBufferFlag = false;
+      topsRegister = baseRegister;
+      break;
+    case VIF_CMD_BASE:
+      baseRegister = immediate & 0x3ff;
+      break;
+    case VIF_CMD_ITOP:
+      itopsRegister = immediate & 0x3ff;
+      break;
+    case VIF_CMD_STMOD:
+      registers.mode = immediate & 3;
+      break;
+    case VIF_CMD_MARK:
+      markRegister = immediate;
+      break;
+    case VIF_CMD_FLUSHE:
+    case VIF_CMD_FLUSH:
+    case VIF_CMD_FLUSHA:
+      if (vuRunning)
+      {
+        return false;
+      }
+      break;
+    case VIF_CMD_MSCAL:
+    case VIF_CMD_MSCALF:
+      if (vuRunning)
+      {
+        return false;
+      }
+      startMicroprogram(immediate);
+      break;
+    case VIF_CMD_STMASK:
+      words = 1;
+      break;
+    case VIF_CMD_STROW:
+    case VIF_CMD_STCOL:
+      words = 4;
+      break;
+    case VIF_CMD_MPG:
+      if (vuRunning)
+      {
+        return false;
+      }
+      words = (num == 0 ? 256 : num) * 2;
+      microProgram.resize(words * 4);
+      break;
+    default:
+      throw runtime_error("Unsupported VIF command.");
+  }
+
+  command = cmd;
+  commandCode = code;
+  payloadWords = words;
+  payloadIndex = 0;
+  return true;
+}
+
+size_t VIF::continueCommand(const uint32_t *words, size_t count)
+{
+  switch (command)
+  {
+    case VIF_CMD_STMASK:
+      registers.mask = words[0];
+      payloadIndex++;
+      return 1;
+    case VIF_CMD_STROW:
+      registers.row[payloadIndex++] = words[0];
+      return 1;
+    case VIF_CMD_STCOL:
+      registers.column[payloadIndex++] = words[0];
+      return 1;
+    case VIF_CMD_MPG:
+    {
+      size_t take = min(count, payloadWords - payloadIndex);
+      memcpy(microProgram.data() + payloadIndex * 4, words, take * 4);
+      payloadIndex += take;
+      if (payloadIndex == payloadWords)
+      {
+        vpu->writeMicroMemory(((commandCode & 0xffff) * 8) & (vpu->microMemorySize() - 1), microProgram);
+      }
+      return take;
+    }
+    default:
+      return continueUnpack(words, count);
+  }
+}
+
+// VIF1 latches TOPS into TOP and flips the double buffer on every start.
+void VIF::startMicroprogram(uint16_t immediate)
+{
+  if (isVIF1())
+  {
+    topRegister = topsRegister;
+    doubleBufferFlag = !doubleBufferFlag;
+    topsRegister = baseRegister + (doubleBufferFlag ? offsetRegister : 0);
+  }
+  itopRegister = itopsRegister;
+  vpu->startMicroMode(static_cast<uint16_t>((immediate * 8) & (vpu->microMemorySize() - 1)));
+}
+
+void VIF::beginUnpack(uint32_t code)
+{
+  uint16_t immediate = code & 0xffff;
+  uint8_t num = (code >> 16) & 0xff;
+  uint8_t cmd = (code >> 24) & 0x7f;
+  uint8_t formatBits = cmd & 0xf;
+  if (!isVIFUnpackFormat(formatBits))
+  {
+    throw runtime_error("Unsupported VIF UNPACK format.");
+  }
+  if (wl == 0)
+  {
+    throw logic_error("VIF UNPACK needs a nonzero write cycle length.");
+  }
+
+  unpackFormat = static_cast<VIFUnpackFormat>(formatBits);
+  unpackElementBytes = vifUnpackElementBytes(unpackFormat);
+  unpackMasked = (cmd & VIF_UNPACK_MASK_BIT) != 0;
+  unpackZeroExtend = (immediate & VIF_UNPACK_UNSIGNED_BIT) != 0;
+  unpackAddress = immediate & 0x3ff;
+  if (isVIF1() && (immediate & VIF_UNPACK_TOPS_BIT) != 0)
+  {
+    unpackAddress += topsRegister;
+  }
+  unpackWrites = num == 0 ? 256 : num;
+  unpackWriteIndex = 0;
+  unpackCarryBytes = 0;
+
+  // Skipping writes (CL >= WL) take data for every write; filling writes only
+  // for the first CL of every WL.
+  unpackElementsRemaining = unpackWrites;
+  if (cl < wl)
+  {
+    unpackElementsRemaining = unpackWrites / wl * cl + min<size_t>(unpackWrites % wl, cl);
+  }
+
+  command = VIF_CMD_UNPACK;
+  commandCode = code;
+  payloadWords = (unpackElementsRemaining * unpackElementBytes + 3) / 4;
+  payloadIndex = 0;
+  if (payloadWords == 0)
+  {
+    fillUnpackWrites();
+  }
+}
+
+// Whole elements go straight to the kernels; an element split across calls
+// is completed in the carry buffer first. Bytes past the last element are
+// padding.
+size_t VIF::continueUnpack(const uint32_t *words, size_t count)
+{
+  size_t take = min(count, payloadWords - payloadIndex);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(words);
+  size_t byteCount = take * 4;
+  size_t position = 0;
+
+  if (unpackCarryBytes > 0)
+  {
+    position = min(unpackElementBytes - unpackCarryBytes, byteCount);
+    memcpy(unpackCarry + unpackCarryBytes, bytes, position);
+    unpackCarryBytes += position;
+    if (unpackCarryBytes == unpackElementBytes)
+    {
+      unpackElements(unpackCarry, 1);
+      unpackCarryBytes = 0;
+    }
+  }
+
+  size_t whole = min((byteCount - position) / unpackElementBytes, unpackElementsRemaining);
+  unpackElements(bytes + position, whole);
+  position += whole * unpackElementBytes;
+  if (unpackElementsRemaining > 0 && position < byteCount)
+  {
+    unpackCarryBytes = byteCount - position;
+    memcpy(unpackCarry, bytes + position, unpackCarryBytes);
+  }
+
+  payloadIndex += take;
+  if (payloadIndex == payloadWords)
+  {
+    fillUnpackWrites();
+  }
+  return take;
+}
+
+// Writes runs of data slots that are contiguous in VU memory with one kernel
+// call each. Unmasked normal-mode runs expand straight into VU memory.
+void VIF::unpackElements(const uint8_t *source, size_t count)
+{
+  size_t memoryQwords = vpu->dataMemorySize() / VIF_UNPACK_QWORD_BYTES;
+  unpackElementsRemaining -= count;
+  while (count > 0)
+  {
+    fillUnpackWrites();
+
+    size_t address = unpackQwordAddress(unpackWriteIndex);
+    size_t position = unpackWriteIndex % wl;
+    size_t run = min(count, memoryQwords - address);
+    if (cl != wl)
+    {
+      run = min(run, min(cl, wl) - position);
+    }
+
+    uint8_t *destination = vpu->dataMemory() + address * VIF_UNPACK_QWORD_BYTES;
+    if (!unpackMasked && registers.mode == VIF_MODE_NORMAL)
+    {
+      vifUnpackElements(unpackFormat, unpackZeroExtend, source, destination, run);
+    }
+    else
+    {
+      uint8_t expanded[VIF_UNPACK_BATCH_QWORDS * VIF_UNPACK_QWORD_BYTES];
+      for (size_t done = 0; done < run; done += VIF_UNPACK_BATCH_QWORDS)
+      {
+        size_t batch = min<size_t>(run - done, VIF_UNPACK_BATCH_QWORDS);
+        vifUnpackElements(unpackFormat, unpackZeroExtend, source + done * unpackElementBytes, expanded, batch);
+        vifWriteUnpacked(&registers, unpackMasked, expanded, destination + done * VIF_UNPACK_QWORD_BYTES, batch, (position + done) % wl, wl);
+      }
+    }
+
+    source += run * unpackElementBytes;
+    count -= run;
+    unpackWriteIndex += run;
+  }
+}
+
+void VIF::fillUnpackWrites()
+{
+  while (unpackWriteIndex < unpackWrites && isFillWrite(unpackWriteIndex))
+  {
+    uint8_t *destination = vpu->dataMemory() + unpackQwordAddress(unpackWriteIndex) * VIF_UNPACK_QWORD_BYTES;
+    vifWriteUnpacked(&registers, unpackMasked, nullptr, destination, 1, unpackWriteIndex % wl, wl);
+    unpackWriteIndex++;
+  }
+}
+
+bool VIF::isFillWrite(size_t writeIndex) const
+{
+  return cl < wl && writeIndex % wl >= cl;
+}
+
+size_t VIF::unpackQwordAddress(size_t writeIndex) const
+{
+  size_t address = unpackAddress + writeIndex;
+  if (cl >= wl)
+  {
+    address = unpackAddress + writeIndex / wl * cl + writeIndex % wl;
+  }
+  return address & (vpu->dataMemorySize() / VIF_UNPACK_QWORD_BYTES - 1);
+}
@@ -1,8 +1,102 @@
 #ifndef VIF_H
 #define VIF_H
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vif_unpack.hpp"
+#include "vpu.hpp"
+
+#define VIF_CMD_NOP 0x00
+#define VIF_CMD_STCYCL 0x01
+#define VIF_CMD_OFFSET 0x02
+#define VIF_CMD_BASE 0x03
+#define VIF_CMD_ITOP 0x04
+#define VIF_CMD_STMOD 0x05
+#define VIF_CMD_MARK 0x07
+#define VIF_CMD_FLUSHE 0x10
+#define VIF_CMD_FLUSH 0x11
+#define VIF_CMD_FLUSHA 0x13
+#define VIF_CMD_MSCAL 0x14
+#define VIF_CMD_MSCALF 0x15
+#define VIF_CMD_STMASK 0x20
+#define VIF_CMD_STROW 0x30
+#define VIF_CMD_STCOL 0x31
+#define VIF_CMD_MPG 0x4a
+#define VIF_CMD_UNPACK 0x60
+#define VIF_UNPACK_MASK_BIT 0x10
+#define VIF_UNPACK_UNSIGNED_BIT 0x4000
+#define VIF_UNPACK_TOPS_BIT 0x8000
+#define VIF_UNPACK_BATCH_QWORDS 128
+
+// Decodes a VIFcode stream into a VPU's data and micro memory. VIF1 is the
+// VIF attached to a VU1 and adds double buffering (BASE, OFFSET, TOPS) and
+// the FLUSH commands. Interrupt bits are ignored and the GIF-side commands
+// are rejected until the GIF exists.
 class VIF
 {
+  public:
+    explicit VIF(VPU *vpu);
+    void reset();
+    // Consumes words until the stream ends or a command has to wait for the
+    // VU to finish its microprogram; returns the number of words consumed.
+    // Commands may be split across calls.
+    size_t write(const uint32_t *words, size_t count);
+    bool waitingForVU() const;
+    bool isVIF1() const;
+    uint8_t cycleLength() const;
+    uint8_t writeLength() const;
+    const VIFUnpackRegisters &unpackRegisters() const;
+    uint16_t base() const;
+    uint16_t offset() const;
+    uint16_t tops() const;
+    uint16_t top() const;
+    uint16_t itops() const;
+    uint16_t itop() const;
+    uint16_t mark() const;
+
+  private:
+    VPU *vpu;
+    VIFUnpackRegisters registers;
+    uint8_t cl = 0;
+    uint8_t wl = 0;
+    uint16_t baseRegister = 0;
+    uint16_t offsetRegister = 0;
+    uint16_t topsRegister = 0;
+    uint16_t topRegister = 0;
+    uint16_t itopsRegister = 0;
+    uint16_t itopRegister = 0;
+    uint16_t markRegister = 0;
+    bool doubleBufferFlag = false;
+    bool waiting = false;
+
+    uint8_t command = VIF_CMD_NOP;
+    uint32_t commandCode = 0;
+    size_t payloadWords = 0;
+    size_t payloadIndex = 0;
+    vector<uint8_t> microProgram;
+
+    VIFUnpackFormat unpackFormat = VIFUnpackFormat::S32;
+    size_t unpackElementBytes = 0;
+    size_t unpackAddress = 0;
+    size_t unpackWrites = 0;
+    size_t unpackWriteIndex = 0;
+    size_t unpackElementsRemaining = 0;
+    bool unpackMasked = false;
+    bool unpackZeroExtend = false;
+    uint8_t unpackCarry[VIF_UNPACK_QWORD_BYTES] = {};
+    size_t unpackCarryBytes = 0;
+
+    bool beginCommand(uint32_t code);
+    size_t continueCommand(const uint32_t *words, size_t count);
+    void startMicroprogram(uint16_t immediate);
+    void beginUnpack(uint32_t code);
+    size_t continueUnpack(const uint32_t *words, size_t count);
+    void unpackElements(const uint8_t *source, size_t count);
+    void fillUnpackWrites();
+    bool isFillWrite(size_t writeIndex) const;
+    size_t unpackQwordAddress(size_t writeIndex) const;
 };
 
 #endif
@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <cstring>
+
+#include "vif_unpack.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIF_UNPACK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+  typedef void (*UnpackKernel)(bool zeroExtend, const uint8_t *source, uint8_t *destination, size_t count);
+
+  unsigned int formatComponents(VIFUnpackFormat format)
+  {
+    return (static_cast<unsigned int>(format) >> 2) + 1;
+  }
+
+  unsigned int formatBits(VIFUnpackFormat format)
+  {
+    return 32 >> (static_cast<unsigned int>(format) & 3);
+  }
+
+  unsigned int maskRow(unsigned int cycle)
+  {
+    return min(cycle, 3u);
+  }
+
+  unsigned int nextCycle(unsigned int cycle, unsigned int writeLength)
+  {
+    return cycle + 1 >= writeLength ? 0 : cycle + 1;
+  }
+
+  template <unsigned int Bits>
+  uint32_t readComponent(const uint8_t *source, bool zeroExtend)
+  {
+    if (Bits == 32)
+    {
+      uint32_t value;
+      memcpy(&value, source, sizeof(value));
+      return value;
+    }
+    if (Bits == 16)
+    {
+      uint16_t value;
+      memcpy(&value, source, sizeof(value));
+      return zeroExtend ? value : static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(value)));
+    }
+    return zeroExtend ? source[0] : static_cast<uint32_t>(static_cast<int32_t>(static_cast<int8_t>(source[0])));
+  }
+
+  template <unsigned int Components, unsigned int Bits>
+  void unpackScalar(bool zeroExtend, const uint8_t *source, uint8_t *destination, size_t count)
+  {
+    const size_t elementBytes = Components * Bits / 8;
+    for (size_t element = 0; element < count; element++)
+    {
+      uint32_t value[4];
+      for (unsigned int lane = 0; lane < Components; lane++)
+      {
+        value[lane] = readComponent<Bits>(source + lane * Bits / 8, zeroExtend);
+      }
+
+      uint32_t lanes[4];
+      for (unsigned int lane = 0; lane < 4; lane++)
+      {
+        if (Components == 1)
+        {
+          lanes[lane] = value[0];
+        }
+        else if (Components == 2)
+        {
+          lanes[lane] = value[lane & 1];
+        }
+        else
+        {
+          lanes[lane] = lane < Components ? value[lane] : 0;
+        }
+      }
+      memcpy(destination, lanes, sizeof(lanes));
+      source += elementBytes;
+      destination += VIF_UNPACK_QWORD_BYTES;
+    }
+  }
+
+  void unpackScalarV45(bool, const uint8_t *source, uint8_t *destination, size_t count)
+  {
+    for (size_t element = 0; element < count; element++)
+    {
+      uint32_t color = source[0] | (source[1] << 8);
+      uint32_t lanes[4] = {
+        (color & 0x1f) << 3,
+        ((color >> 5) & 0x1f) << 3,
+        ((color >> 10) & 0x1f) << 3,
+        (color >> 15) << 7
+      };
+      memcpy(destination, lanes, sizeof(lanes));
+      source += 2;
+      destination += VIF_UNPACK_QWORD_BYTES;
+    }
+  }
+
+  const UnpackKernel scalarKernels[16] = {
+    unpackScalar<1, 32>, unpackScalar<1, 16>, unpackScalar<1, 8>, nullptr,
+    unpackScalar<2, 32>, unpackScalar<2, 16>, unpackScalar<2, 8>, nullptr,
+    unpackScalar<3, 32>, unpackScalar<3, 16>, unpackScalar<3, 8>, nullptr,
+    unpackScalar<4, 32>, unpackScalar<4, 16>, unpackScalar<4, 8>, unpackScalarV45
+  };
+
+  uint32_t laneValue(const VIFUnpackRegisters &registers, bool masked, unsigned int cycle, unsigned int lane)
+  {
+    return masked ? (registers.mask >> (maskRow(cycle) * 8 + lane * 2)) & 3 : VIF_MASK_DATA;
+  }
+
+#ifdef VIF_UNPACK_SSE2
+  __m128i loadQword(const uint8_t *source)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(source));
+  }
+
+  void storeQword(uint8_t *destination, __m128i value)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(destination), value);
+  }
+
+  __m128i loadBytes(const uint8_t *source, size_t byteCount)
+  {
+    uint8_t buffer[VIF_UNPACK_QWORD_BYTES] = {};
+    memcpy(buffer, source, byteCount);
+    return loadQword(buffer);
+  }
+
+  // Widens the low four halfwords or bytes of value to 32-bit lanes.
+  __m128i widen16(__m128i value, bool zeroExtend)
+  {
+    return zeroExtend ?
+      _mm_unpacklo_epi16(value, _mm_setzero_si128()) :
+      _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+  }
+
+  __m128i widen8(__m128i value, bool zeroExtend)
+  {
+    if (zeroExtend)
+    {
+      __m128i zero = _mm_setzero_si128();
+      return _mm_unpacklo_epi16(_mm_unpacklo_epi8(value, zero), zero);
+    }
+    __m128i bytes = _mm_unpacklo_epi8(value, value);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(bytes, bytes), 24);
+  }
+
+  template <unsigned int Bits>
+  __m128i widen(__m128i value, bool zeroExtend)
+  {
+    return Bits == 32 ? value : Bits == 16 ? widen16(value, zeroExtend) : widen8(value, zeroExtend);
+  }
+
+  __m128i loadWidth(const uint8_t *source, size_t width)
+  {
+    if (width == 4)
+    {
+      return _mm_cvtsi32_si128(static_cast<int>(readComponent<32>(source, true)));
+    }
+    if (width == 8)
+    {
+      return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(source));
+    }
+    return loadQword(source);
+  }
+
+  // Scalar formats widen four elements at a time and broadcast each lane.
+  template <unsigned int Bits>
+  void unpackSSE2S(bool zeroExtend, const uint8_t *source, uint8_t *destination, size_t count)
+  {
+    const size_t elementBytes = Bits / 8;
+    size_t element = 0;
+    for (; element + 4 <= count; element += 4)
+    {
+      __m128i values = widen<Bits>(loadWidth(source + element * elementBytes, 4 * elementBytes), zeroExtend);
+      uint8_t *target = destination + element * VIF_UNPACK_QWORD_BYTES;
+      storeQword(target, _mm_shuffle_epi32(values, _MM_SHUFFLE(0, 0, 0, 0)));
+      storeQword(target + 16, _mm_shuffle_epi32(values, _MM_SHUFFLE(1, 1, 1, 1)));
+      storeQword(target + 32, _mm_shuffle_epi32(values, _MM_SHUFFLE(2, 2, 2, 2)));
+      storeQword(target + 48, _mm_shuffle_epi32(values, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    for (; element < count; element++)
+    {
+      uint32_t value = readComponent<Bits>(source + element * elementBytes, zeroExtend);
+      storeQword(destination + element * VIF_UNPACK_QWORD_BYTES, _mm_set1_epi32(static_cast<int>(value)));
+    }
+  }
+
+  // Vector formats read each element with one 4, 8 or 16 byte load. Elements
+  // before the last may over-read into the next one; V3 drops that lane.
+  template <unsigned int Components, unsigned int Bits>
+  void unpackSSE2V(bool zeroExtend, const uint8_t *source, uint8_t *destination, size_t count)
+  {
+    const size_t elementBytes = Components * Bits / 8;
+    const size_t width = elementBytes <= 4 ? 4 : elementBytes <= 8 ? 8 : 16;
+    const __m128i dropW = _mm_set_epi32(0, -1, -1, -1);
+    for (size_t element = 0; element < count; element++)
+    {
+      const uint8_t *packed = source + element * elementBytes;
+      __m128i raw = width == elementBytes || element + 1 < count ?
+        loadWidth(packed, width) :
+        loadBytes(packed, elementBytes);
+
+      __m128i value = widen<Bits>(raw, zeroExtend);
+      if (Components == 2)
+      {
+        value = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 1, 0));
+      }
+      else if (Components == 3)
+      {
+        value = _mm_and_si128(value, dropW);
+      }
+      storeQword(destination + element * VIF_UNPACK_QWORD_BYTES, value);
+    }
+  }
+
+  void unpackSSE2V432(bool, const uint8_t *source, uint8_t *destination, size_t count)
+  {
+    memcpy(destination, source, count * VIF_UNPACK_QWORD_BYTES);
+  }
+
+  void unpackSSE2V45(bool, const uint8_t *source, uint8_t *destination, size_t count)
+  {
+    const __m128i redMask = _mm_set_epi32(0, 0, 0, 0xf8);
+    const __m128i greenMask = _mm_set_epi32(0, 0, 0xf8, 0);
+    const __m128i blueMask = _mm_set_epi32(0, 0xf8, 0, 0);
+    const __m128i alphaMask = _mm_set_epi32(0x80, 0, 0, 0);
+    for (size_t element = 0; element < count; element++)
+    {
+      __m128i color = _mm_set1_epi32(source[element * 2] | (source[element * 2 + 1] << 8));
+      __m128i value = _mm_or_si128(
+        _mm_or_si128(
+          _mm_and_si128(_mm_slli_epi32(color, 3), redMask),
+          _mm_and_si128(_mm_srli_epi32(color, 2), greenMask)),
+        _mm_or_si128(
+          _mm_and_si128(_mm_srli_epi32(color, 7), blueMask),
+          _mm_and_si128(_mm_srli_epi32(color, 8), alphaMask)));
+      storeQword(destination + element * VIF_UNPACK_QWORD_BYTES, value);
+    }
+  }
+
+  const UnpackKernel simdKernels[16] = {
+    unpackSSE2S<32>, unpackSSE2S<16>, unpackSSE2S<8>, nullptr,
+    unpackSSE2V<2, 32>, unpackSSE2V<2, 16>, unpackSSE2V<2, 8>, nullptr,
+    unpackSSE2V<3, 32>, unpackSSE2V<3, 16>, unpackSSE2V<3, 8>, nullptr,
+    unpackSSE2V432, unpackSSE2V<4, 16>, unpackSSE2V<4, 8>, unpackSSE2V45
+  };
+
+  // Lane selects for one mask row: data, row, column and write-protect.
+  struct MaskRowSelects
+  {
+    __m128i lanes[4];
+    __m128i column;
+  };
+
+  void writeUnpackedSSE2(VIFUnpackRegisters *registers, bool masked, const uint8_t *expanded, uint8_t *destination, size_t count, unsigned int cycle, unsigned int writeLength)
+  {
+    MaskRowSelects selects[4];
+    for (unsigned int row = 0; row < 4; row++)
+    {
+      int32_t lanes[4][4] = {};
+      for (unsigned int lane = 0; lane < 4; lane++)
+      {
+        lanes[laneValue(*registers, masked, row, lane)][lane] = -1;
+      }
+      for (unsigned int kind = 0; kind < 4; kind++)
+      {
+        selects[row].lanes[kind] = _mm_set_epi32(lanes[kind][3], lanes[kind][2], lanes[kind][1], lanes[kind][0]);
+      }
+      selects[row].column = _mm_set1_epi32(static_cast<int>(registers->column[row]));
+    }
+
+    const uint8_t mode = registers->mode;
+    __m128i row = loadQword(reinterpret_cast<const uint8_t *>(registers->row));
+    for (size_t index = 0; index < count; index++)
+    {
+      const MaskRowSelects &select = selects[maskRow(cycle)];
+      __m128i data = row;
+      if (expanded != nullptr)
+      {
+        data = loadQword(expanded + index * VIF_UNPACK_QWORD_BYTES);
+        if (mode == VIF_MODE_OFFSET)
+        {
+          data = _mm_add_epi32(data, row);
+        }
+        else if (mode == VIF_MODE_DIFFERENCE)
+        {
+          __m128i sum = _mm_add_epi32(data, row);
+          row = _mm_or_si128(_mm_and_si128(select.lanes[VIF_MASK_DATA], sum), _mm_andnot_si128(select.lanes[VIF_MASK_DATA], row));
+          data = row;
+        }
+      }
+
+      uint8_t *target = destination + index * VIF_UNPACK_QWORD_BYTES;
+      __m128i value = _mm_or_si128(
+        _mm_or_si128(
+          _mm_and_si128(data, select.lanes[VIF_MASK_DATA]),
+          _mm_and_si128(row, select.lanes[VIF_MASK_ROW])),
+        _mm_or_si128(
+          _mm_and_si128(select.column, select.lanes[VIF_MASK_COLUMN]),
+          _mm_and_si128(loadQword(target), select.lanes[VIF_MASK_PROTECT])));
+      storeQword(target, value);
+      cycle = nextCycle(cycle, writeLength);
+    }
+    storeQword(reinterpret_cast<uint8_t *>(registers->row), row);
+  }
+#endif
+}
+
+bool isVIFUnpackFormat(uint8_t formatBits)
+{
+  return formatBits < 16 && scalarKernels[formatBits] != nullptr;
+}
+
+size_t vifUnpackElementBytes(VIFUnpackFormat format)
+{
+  if (format == VIFUnpackFormat::V4_5)
+  {
+    return 2;
+  }
+  return formatComponents(format) * formatBits(format) / 8;
+}
+
+void vifUnpackElements(VIFUnpackFormat format, bool zeroExtend, const uint8_t *source, uint8_t *destination, size_t count)
+{
+#ifdef VIF_UNPACK_SSE2
+  simdKernels[static_cast<uint8_t>(format)](zeroExtend, source, destination, count);
+#else
+  vifUnpackElementsScalar(format, zeroExtend, source, destination, count);
+#endif
+}
+
+void vifWriteUnpacked(VIFUnpackRegisters *registers, bool masked, const uint8_t *expanded, uint8_t *destination, size_t count, unsigned int cycle, unsigned int writeLength)
+{
+#ifdef VIF_UNPACK_SSE2
+  writeUnpackedSSE2(registers, masked, expanded, destination, count, cycle, writeLength);
+#else
+  vifWriteUnpackedScalar(registers, masked, expanded, destination, count, cycle, writeLength);
+#endif
+}
+
+void vifUnpackElementsScalar(VIFUnpackFormat format, bool zeroExtend, const uint8_t *source, uint8_t *destination, size_t count)
+{
+  scalarKernels[static_cast<uint8_t>(format)](zeroExtend, source, destination, count);
+}
+
+void vifWriteUnpackedScalar(VIFUnpackRegisters *registers, bool masked, const uint8_t *expanded, uint8_t *destination, size_t count, unsigned int cycle, unsigned int writeLength)
+{
+  for (size_t index = 0; index < count; index++)
+  {
+    uint32_t data[4];
+    uint32_t target[4];
+    memcpy(data, expanded != nullptr ? expanded + index * VIF_UNPACK_QWORD_BYTES : reinterpret_cast<const uint8_t *>(registers->row), sizeof(data));
+    memcpy(target, destination + index * VIF_UNPACK_QWORD_BYTES, sizeof(target));
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+      switch (laneValue(*registers, masked, cycle, lane))
+      {
+        case VIF_MASK_DATA:
+          if (expanded != nullptr && registers->mode == VIF_MODE_OFFSET)
+          {
+            data[lane] += registers->row[lane];
+          }
+          else if (expanded != nullptr && registers->mode == VIF_MODE_DIFFERENCE)
+          {
+            registers->row[lane] += data[lane];
+            data[lane] = registers->row[lane];
+          }
+          target[lane] = data[lane];
+          break;
+        case VIF_MASK_ROW:
+          target[lane] = registers->row[lane];
+          break;
+        case VIF_MASK_COLUMN:
+          target[lane] = registers->column[maskRow(cycle)];
+          break;
+        case VIF_MASK_PROTECT:
+          break;
+      }
+    }
+
+    memcpy(destination + index * VIF_UNPACK_QWORD_BYTES, target, sizeof(target));
+    cycle = nextCycle(cycle, writeLength);
+  }
+}
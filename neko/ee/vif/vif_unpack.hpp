@@ -0,0 +1,86 @@
+#ifndef VIF_UNPACK_H
+#define VIF_UNPACK_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define VIF_UNPACK_QWORD_BYTES 16
+#define VIF_MODE_NORMAL 0
+#define VIF_MODE_OFFSET 1
+#define VIF_MODE_DIFFERENCE 2
+#define VIF_MASK_DATA 0
+#define VIF_MASK_ROW 1
+#define VIF_MASK_COLUMN 2
+#define VIF_MASK_PROTECT 3
+
+// Values are the VN and VL bits of the UNPACK command, (vn << 2) | vl.
+enum class VIFUnpackFormat : std::uint8_t
+{
+  S32 = 0x0,
+  S16 = 0x1,
+  S8 = 0x2,
+  V2_32 = 0x4,
+  V2_16 = 0x5,
+  V2_8 = 0x6,
+  V3_32 = 0x8,
+  V3_16 = 0x9,
+  V3_8 = 0xa,
+  V4_32 = 0xc,
+  V4_16 = 0xd,
+  V4_8 = 0xe,
+  V4_5 = 0xf
+};
+
+// Registers shared by every UNPACK: STMASK, STROW, STCOL and STMOD.
+struct VIFUnpackRegisters
+{
+  std::uint32_t mask = 0;
+  std::uint32_t row[4] = {};
+  std::uint32_t column[4] = {};
+  std::uint8_t mode = VIF_MODE_NORMAL;
+};
+
+bool isVIFUnpackFormat(std::uint8_t formatBits);
+std::size_t vifUnpackElementBytes(VIFUnpackFormat format);
+
+// Expands count packed elements into count qwords. S formats broadcast their
+// value, V2 repeats XY into ZW and V3 writes zero to W. Neither pointer needs
+// any alignment.
+void vifUnpackElements(
+  VIFUnpackFormat format,
+  bool zeroExtend,
+  const std::uint8_t *source,
+  std::uint8_t *destination,
+  std::size_t count);
+
+// Applies the add mode and, when masked, the write mask to count expanded
+// qwords and stores them. A null expanded pointer marks filling writes, which
+// take the row register as their data and skip the add mode. cycle is the
+// write-cycle position of the first qword; the mask row is min(cycle, 3).
+void vifWriteUnpacked(
+  VIFUnpackRegisters *registers,
+  bool masked,
+  const std::uint8_t *expanded,
+  std::uint8_t *destination,
+  std::size_t count,
+  unsigned int cycle,
+  unsigned int writeLength);
+
+// Portable references for the kernels above; the SIMD paths must match them
+// bit for bit.
+void vifUnpackElementsScalar(
+  VIFUnpackFormat format,
+  bool zeroExtend,
+  const std::uint8_t *source,
+  std::uint8_t *destination,
+  std::size_t count);
+void vifWriteUnpackedScalar(
+  VIFUnpackRegisters *registers,
+  bool masked,
+  const std::uint8_t *expanded,
+  std::uint8_t *destination,
+  std::size_t count,
+  unsigned int cycle,
+  unsigned int writeLength);
+
+#endif
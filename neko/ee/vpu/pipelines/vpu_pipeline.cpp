@@ -1,4 +1,7 @@
+#include <stdexcept>
+
 #include "vpu_pipeline.hpp"
+#include "vpu_register_ids.hpp"
 
 #define VU_PIPELINE_STAGES 6
 
@@ -52,3 +55,54 @@ bool Pipeline::isComplete()
 {
   return currentStage == (endStage - 1);
 }
+
+void Pipeline::saveState(SaveStateWriter * writer) const
+{
+  writer->writeU8(type);
+  writer->writeU16(opCode);
+  writer->writeU32(static_cast<uint32_t>(intResult));
+  fpResult.saveState(writer);
+  writer->writeU8(srcReg1);
+  writer->writeU8(srcReg2);
+  writer->writeU8(destReg);
+  writer->writeU8(destFieldMask);
+  writer->writeU8(srcReg1FieldMask);
+  writer->writeU8(srcReg2FieldMask);
+  writer->writeU16(instructionAddress);
+  writer->writeU16(memoryAddress);
+  writer->writeBool(discardWriteback);
+  writer->writeU8(currentStage);
+  writer->writeU8(endStage);
+}
+
+void Pipeline::loadState(SaveStateReader * reader)
+{
+  type = reader->readU8();
+  opCode = reader->readU16();
+  intResult = static_cast<int>(reader->readU32());
+  fpResult.loadState(reader);
+  srcReg1 = reader->readU8();
+  srcReg2 = reader->readU8();
+  destReg = reader->readU8();
+  destFieldMask = reader->readU8();
+  srcReg1FieldMask = reader->readU8();
+  srcReg2FieldMask = reader->readU8();
+  instructionAddress = reader->readU16();
+  memoryAddress = reader->readU16();
+  discardWriteback = reader->readBool();
+  currentStage = reader->readU8();
+  endStage = reader->readU8();
+
+  if ((type != VPU_PIPELINE_TYPE_FMAC &&
+       type != VPU_PIPELINE_TYPE_IALU &&
+       type != VPU_PIPELINE_TYPE_LSU) ||
+      srcReg1 > VPU_REGISTER_ACCUMULATOR ||
+      srcReg2 > VPU_REGISTER_ACCUMULATOR ||
+      destReg > VPU_REGISTER_ACCUMULATOR ||
+      endStage != VU_PIPELINE_STAGES ||
+      currentStage == 0 ||
+      currentStage >= endStage)
+  {
+    throw std::invalid_argument("Save state contains an invalid pipeline.");
+  }
+}
@@ -4,6 +4,7 @@
 #include <cstdint>
 
 #include "fp_register.hpp"
+#include "save_state.hpp"
 
 #define VPU_PIPELINE_TYPE_NONE 0
 #define VPU_PIPELINE_TYPE_FMAC 1
@@ -36,6 +37,8 @@ class Pipeline
     void setIntResult(int i);
     void execute();
     bool isComplete();
+    void saveState(SaveStateWriter * writer) const;
+    void loadState(SaveStateReader * reader);
   private:
     uint8_t currentStage;
     uint8_t endStage;
@@ -55,8 +55,7 @@ void PipelineOrchestrator::updateWaitingPipelines()
     return;
   }
 
-  waiting.erase(waiting.begin());
-  executing.push_back(p);
+  executing.splice(executing.end(), waiting, waiting.begin());
 
   if (pipelineHandler)
   {
@@ -114,8 +113,8 @@ void PipelineOrchestrator::updateExecutingPipelines()
         pipelineHandler->pipelineFinished(p);
       }
 
-      iter = executing.erase(iter);
-      pool.push_back(p);
+      list<Pipeline *>::iterator finished = iter++;
+      pool.splice(pool.end(), executing, finished);
     }
     else
     {
@@ -131,6 +130,11 @@ bool PipelineOrchestrator::hasNext()
 }
 
 bool PipelineOrchestrator::hasRegisterHazard(uint8_t srcReg1, uint8_t srcReg1FieldMask, uint8_t srcReg2, uint8_t srcReg2FieldMask) const
+{
+  return findRegisterHazard(srcReg1, srcReg1FieldMask, srcReg2, srcReg2FieldMask) != NULL;
+}
+
+const Pipeline *PipelineOrchestrator::findRegisterHazard(uint8_t srcReg1, uint8_t srcReg1FieldMask, uint8_t srcReg2, uint8_t srcReg2FieldMask) const
 {
   for (list<Pipeline *>::const_iterator iter = executing.begin(); iter != executing.end(); ++iter)
   {
@@ -157,16 +161,43 @@ bool PipelineOrchestrator::hasRegisterHazard(uint8_t srcReg1, uint8_t srcReg1Fie
 
     if (srcReg1Hazard || srcReg2Hazard)
     {
-      return true;
+      return pipeline;
     }
   }
 
-  return false;
+  return NULL;
+}
+
+const Pipeline *PipelineOrchestrator::findIntegerWriter(uint8_t registerID) const
+{
+  for (list<Pipeline *>::const_iterator iter = executing.begin(); iter != executing.end(); ++iter)
+  {
+    Pipeline *pipeline = *iter;
+    if (pipeline->type == VPU_PIPELINE_TYPE_LSU &&
+        (pipeline->opCode == VPU_ILW || pipeline->opCode == VPU_SQI) &&
+        pipeline->destReg == registerID)
+    {
+      return pipeline;
+    }
+  }
+
+  return NULL;
+}
+
+const Pipeline *PipelineOrchestrator::stalledPipeline() const
+{
+  if (!stalling || waiting.empty())
+  {
+    return NULL;
+  }
+
+  return waiting.front();
 }
 
 void PipelineOrchestrator::initPipeline(uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress)
 {
-  waiting.push_back(configurePipeline(
+  configurePipeline(
+    &waiting,
     pipelineType,
     opCode,
     srcReg1,
@@ -176,12 +207,13 @@ void PipelineOrchestrator::initPipeline(uint8_t pipelineType, uint16_t opCode, u
     srcReg1FieldMask,
     srcReg2FieldMask,
     instructionAddress,
-    false));
+    false);
 }
 
 void PipelineOrchestrator::startPipeline(uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress, bool discardWriteback)
 {
   Pipeline *pipeline = configurePipeline(
+    &executing,
     pipelineType,
     opCode,
     srcReg1,
@@ -192,7 +224,6 @@ void PipelineOrchestrator::startPipeline(uint8_t pipelineType, uint16_t opCode,
     srcReg2FieldMask,
     instructionAddress,
     discardWriteback);
-  executing.push_back(pipeline);
 
   if (pipelineHandler)
   {
@@ -200,7 +231,7 @@ void PipelineOrchestrator::startPipeline(uint8_t pipelineType, uint16_t opCode,
   }
 }
 
-Pipeline *PipelineOrchestrator::configurePipeline(uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress, bool discardWriteback)
+Pipeline *PipelineOrchestrator::configurePipeline(list<Pipeline *> *destination, uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress, bool discardWriteback)
 {
   if (pool.size() == 0)
   {
@@ -208,7 +239,7 @@ Pipeline *PipelineOrchestrator::configurePipeline(uint8_t pipelineType, uint16_t
   }
 
   Pipeline * pipeline = pool.front();
-  pool.pop_front();
+  destination->splice(destination->end(), pool, pool.begin());
 
   pipeline->configure(pipelineType, opCode, srcReg1, srcReg2, destReg, destFieldMask, srcReg1FieldMask, srcReg2FieldMask, instructionAddress, discardWriteback);
   return pipeline;
@@ -218,3 +249,45 @@ void PipelineOrchestrator::setPipelineHandler(PipelineHandler * handler)
 {
   pipelineHandler = handler;
 }
+
+void PipelineOrchestrator::saveState(SaveStateWriter * writer) const
+{
+  writer->writeBool(stalling);
+  saveList(writer, executing);
+  saveList(writer, waiting);
+}
+
+void PipelineOrchestrator::loadState(SaveStateReader * reader)
+{
+  reset();
+  stalling = reader->readBool();
+  loadList(reader, executing);
+  loadList(reader, waiting);
+}
+
+void PipelineOrchestrator::saveList(SaveStateWriter * writer, const list<Pipeline *> &pipelines) const
+{
+  writer->writeU8(static_cast<uint8_t>(pipelines.size()));
+
+  for (list<Pipeline *>::const_iterator iter = pipelines.begin(); iter != pipelines.end(); ++iter)
+  {
+    (*iter)->saveState(writer);
+  }
+}
+
+void PipelineOrchestrator::loadList(SaveStateReader * reader, list<Pipeline *> &pipelines)
+{
+  uint8_t count = reader->readU8();
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (pool.size() == 0)
+    {
+      throw std::invalid_argument("Save state contains more pipelines than the PipelineOrchestrator supports.");
+    }
+
+    Pipeline *pipeline = pool.front();
+    pipelines.splice(pipelines.end(), pool, pool.begin());
+    pipeline->loadState(reader);
+  }
+}
@@ -21,9 +21,14 @@ class PipelineOrchestrator
     void update();
     bool hasNext();
     bool hasRegisterHazard(uint8_t srcReg1, uint8_t srcReg1FieldMask, uint8_t srcReg2, uint8_t srcReg2FieldMask) const;
+    const Pipeline *findRegisterHazard(uint8_t srcReg1, uint8_t srcReg1FieldMask, uint8_t srcReg2, uint8_t srcReg2FieldMask) const;
+    const Pipeline *findIntegerWriter(uint8_t registerID) const;
+    const Pipeline *stalledPipeline() const;
     void initPipeline(uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress = 0);
     void startPipeline(uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress = 0, bool discardWriteback = false);
     void setPipelineHandler(PipelineHandler * handler);
+    void saveState(SaveStateWriter * writer) const;
+    void loadState(SaveStateReader * reader);
   private:
     list<Pipeline *> executing;
     list<Pipeline *> waiting;
@@ -32,7 +37,9 @@ class PipelineOrchestrator
     void updateExecutingPipelines();
     void updateWaitingPipelines();
     void detectStalls(Pipeline * pipeline);
-    Pipeline *configurePipeline(uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress, bool discardWriteback);
+    void saveList(SaveStateWriter * writer, const list<Pipeline *> &pipelines) const;
+    void loadList(SaveStateReader * reader, list<Pipeline *> &pipelines);
+    Pipeline *configurePipeline(list<Pipeline *> *destination, uint8_t pipelineType, uint16_t opCode, uint8_t srcReg1, uint8_t srcReg2, uint8_t destReg, uint8_t destFieldMask, uint8_t srcReg1FieldMask, uint8_t srcReg2FieldMask, uint16_t instructionAddress, bool discardWriteback);
 };
 
 #endif
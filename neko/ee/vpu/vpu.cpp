@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdexcept>
 #include "bit_ops.hpp"
 #include "floating_point_ops.hpp"
@@ -12,14 +13,93 @@
 #define NUM_FP_REGISTERS 32
 #define NUM_INT_REGISTERS 16
 
-#define NUM_TYPE1_OPCODES 52
-uint16_t type1OpCodeList[NUM_TYPE1_OPCODES] = {VPU_ADD, VPU_ADDi, VPU_ADDq, VPU_ADDx, VPU_ADDy, VPU_ADDz, VPU_ADDw, VPU_ADDAx, VPU_ADDAy, VPU_ADDAz, VPU_ADDAw, VPU_MADD, VPU_MADDi, VPU_MADDq, VPU_MADDx, VPU_MADDy, VPU_MADDz, VPU_MADDw, VPU_MAX, VPU_MAXi, VPU_MAXx, VPU_MAXy, VPU_MAXz, VPU_MAXw, VPU_MINI, VPU_MINIi, VPU_MINIx, VPU_MINIy, VPU_MINIz, VPU_MINIw, VPU_MSUB, VPU_MSUBi, VPU_MSUBq, VPU_MSUBx, VPU_MSUBy, VPU_MSUBz, VPU_MSUBw, VPU_MUL, VPU_MULi, VPU_MULq, VPU_MULx, VPU_MULy, VPU_MULz, VPU_MULw, VPU_OPMSUB, VPU_SUB, VPU_SUBi, VPU_SUBq, VPU_SUBx, VPU_SUBy, VPU_SUBz, VPU_SUBw};
+const uint16_t type1OpCodeList[NUM_TYPE1_OPCODES] = {VPU_ADD, VPU_ADDi, VPU_ADDq, VPU_ADDx, VPU_ADDy, VPU_ADDz, VPU_ADDw, VPU_ADDAx, VPU_ADDAy, VPU_ADDAz, VPU_ADDAw, VPU_MADD, VPU_MADDi, VPU_MADDq, VPU_MADDx, VPU_MADDy, VPU_MADDz, VPU_MADDw, VPU_MAX, VPU_MAXi, VPU_MAXx, VPU_MAXy, VPU_MAXz, VPU_MAXw, VPU_MINI, VPU_MINIi, VPU_MINIx, VPU_MINIy, VPU_MINIz, VPU_MINIw, VPU_MSUB, VPU_MSUBi, VPU_MSUBq, VPU_MSUBx, VPU_MSUBy, VPU_MSUBz, VPU_MSUBw, VPU_MUL, VPU_MULi, VPU_MULq, VPU_MULx, VPU_MULy, VPU_MULz, VPU_MULw, VPU_OPMSUB, VPU_SUB, VPU_SUBi, VPU_SUBq, VPU_SUBx, VPU_SUBy, VPU_SUBz, VPU_SUBw};
 
-#define NUM_TYPE3_OPCODES 43
-uint16_t type3OpCodeList[NUM_TYPE3_OPCODES] = {VPU_ABS, VPU_ADDA, VPU_ADDAi, VPU_ADDAq, VPU_CLIP, VPU_FTOI0, VPU_FTOI4, VPU_FTOI12, VPU_FTOI15, VPU_ITOF0, VPU_ITOF4, VPU_ITOF12, VPU_ITOF15, VPU_MADDA, VPU_MADDAi, VPU_MADDAq, VPU_MADDAx, VPU_MADDAy, VPU_MADDAz, VPU_MADDAw, VPU_MSUBA, VPU_MSUBAi, VPU_MSUBAq, VPU_MSUBAx, VPU_MSUBAy, VPU_MSUBAz, VPU_MSUBAw, VPU_MULA, VPU_MULAi, VPU_MULAq, VPU_MULAx, VPU_MULAy, VPU_MULAz, VPU_MULAw, VPU_NOP, VPU_OPMULA, VPU_SUBA, VPU_SUBAi, VPU_SUBAq, VPU_SUBAx, VPU_SUBAy, VPU_SUBAz, VPU_SUBAw};
+const uint16_t type3OpCodeList[NUM_TYPE3_OPCODES] = {VPU_ABS, VPU_ADDA, VPU_ADDAi, VPU_ADDAq, VPU_CLIP, VPU_FTOI0, VPU_FTOI4, VPU_FTOI12, VPU_FTOI15, VPU_ITOF0, VPU_ITOF4, VPU_ITOF12, VPU_ITOF15, VPU_MADDA, VPU_MADDAi, VPU_MADDAq, VPU_MADDAx, VPU_MADDAy, VPU_MADDAz, VPU_MADDAw, VPU_MSUBA, VPU_MSUBAi, VPU_MSUBAq, VPU_MSUBAx, VPU_MSUBAy, VPU_MSUBAz, VPU_MSUBAw, VPU_MULA, VPU_MULAi, VPU_MULAq, VPU_MULAx, VPU_MULAy, VPU_MULAz, VPU_MULAw, VPU_NOP, VPU_OPMULA, VPU_SUBA, VPU_SUBAi, VPU_SUBAq, VPU_SUBAx, VPU_SUBAy, VPU_SUBAz, VPU_SUBAw};
+
+#define VPU_SAVE_STATE_MAGIC 0x55564b4e
 
 using namespace std;
 
+namespace
+{
+  void saveLowerInstruction(SaveStateWriter *writer, const LowerInstruction &instruction)
+  {
+    writer->writeU8(static_cast<uint8_t>(instruction.unit));
+    writer->writeU32(instruction.opCode);
+    writer->writeU8(instruction.sourceRegister1);
+    writer->writeU8(instruction.sourceRegister2);
+    writer->writeU8(instruction.destinationRegister);
+    writer->writeU8(instruction.destinationFieldMask);
+    writer->writeU16(static_cast<uint16_t>(instruction.immediate));
+    writer->writeU32(instruction.immediateBits);
+  }
+
+  LowerInstruction loadLowerInstruction(SaveStateReader *reader)
+  {
+    LowerInstruction instruction;
+    uint8_t unit = reader->readU8();
+    if (unit > static_cast<uint8_t>(LowerExecutionUnit::Branch))
+    {
+      throw invalid_argument("VU save state contains an invalid lower execution unit.");
+    }
+
+    instruction.unit = static_cast<LowerExecutionUnit>(unit);
+    instruction.opCode = reader->readU32();
+    instruction.sourceRegister1 = reader->readU8();
+    instruction.sourceRegister2 = reader->readU8();
+    instruction.destinationRegister = reader->readU8();
+    instruction.destinationFieldMask = reader->readU8();
+    instruction.immediate = static_cast<int16_t>(reader->readU16());
+    instruction.immediateBits = reader->readU32();
+    return instruction;
+  }
+
+  template <size_t N>
+  void saveArray(SaveStateWriter *writer, const array<uint8_t, N> &values)
+  {
+    writer->writeBytes(values.data(), values.size());
+  }
+
+  template <size_t N>
+  void saveArray(SaveStateWriter *writer, const array<uint16_t, N> &values)
+  {
+    for (uint16_t value : values)
+    {
+      writer->writeU16(value);
+    }
+  }
+
+  template <size_t N>
+  void loadArray(SaveStateReader *reader, array<uint8_t, N> *values)
+  {
+    reader->readBytes(values->data(), values->size());
+  }
+
+  template <size_t N>
+  void loadArray(SaveStateReader *reader, array<uint16_t, N> *values)
+  {
+    for (uint16_t &value : *values)
+    {
+      value = reader->readU16();
+    }
+  }
+}
+
+VPUStallRegisterClass vpuWritebackRegisterClass(uint16_t opCode)
+{
+  switch (opCode)
+  {
+    case VPU_IADD:
+    case VPU_ISUBIU:
+    case VPU_ILW:
+    case VPU_SQI:
+      return VPUStallRegisterClass::Integer;
+    default:
+      return VPUStallRegisterClass::Float;
+  }
+}
+
 VPU::VPU(VPUType type) : type(type)
 {
   initMemory();
@@ -29,6 +109,79 @@ VPU::VPU(VPUType type) : type(type)
   initPipelineOrchestrator();
 }
 
+void VPU::reset(const VPUResetOptions &options)
+{
+  if (!options.keepMicroMemory)
+  {
+    clearMicroMemory();
+  }
+  if (!options.keepDataMemory)
+  {
+    fill(vuMem.begin(), vuMem.end(), 0);
+  }
+
+  for (FPRegister &reg : fpRegisters)
+  {
+    reg = FPRegister();
+  }
+  fpRegisters[0].w = 1.0f;
+  fill(intRegisters.begin(), intRegisters.end(), 0);
+  accumulator = FPRegister();
+  virtualDestRegister = FPRegister();
+  clippingFlags = 0;
+  iRegister = VUFloat();
+  qRegister = 0;
+  pRegister = 0;
+  rRegister = 0;
+  MACFlags = 0;
+  statusFlags = 0;
+
+  clearExecutionState();
+  state = VPU_STATE_READY;
+  mode = VPU_MODE_MACRO;
+  cycles = 0;
+  microMemPC = 0;
+  terminationPositionCounter = 0;
+  terminationPositionValid = false;
+  dEnabled = false;
+  tEnabled = false;
+  pendingLowerInstruction = LowerInstruction();
+  pendingLowerInstructionAddress = 0;
+  pendingLowerInstructionReady = false;
+  pendingLowerWritebackDiscarded = false;
+  pendingBranchTarget = 0;
+  pendingBranchLinkRegister = 0;
+  pendingBranchLinkValue = 0;
+}
+
+void VPU::clearMicroMemory()
+{
+  for (size_t pair = 0; pair < decodedMicroMem.size(); pair++)
+  {
+    vector<uint8_t>::iterator instructions = microMem.begin() + pair * 8;
+    if (any_of(instructions, instructions + 8, [](uint8_t byte) { return byte != 0; }))
+    {
+      fill(instructions, instructions + 8, 0);
+      decodedMicroMem[pair].valid = false;
+    }
+  }
+}
+
+void VPU::clearExecutionState()
+{
+  orchestrator.reset();
+  lowerInstructionPending = false;
+  pendingIntegerWrites.fill(0);
+  pendingIALUWrites.fill(0);
+  bypassedIntegerValues.fill(0);
+  endDelaySlotPending = false;
+  branchDelaySlotPending = false;
+  pendingBranchTaken = false;
+  pendingBranchLinkValid = false;
+  terminationRequested = false;
+  haltAfterDrain = false;
+}
+
 void VPU::initMemory()
 {
   size_t memorySize;
@@ -46,6 +199,7 @@ void VPU::initMemory()
   }
 
   microMem.resize(memorySize);
+  decodedMicroMem.resize(memorySize / 8);
   vuMem.resize(memorySize);
 }
 
@@ -130,17 +284,7 @@ void VPU::forceBreak()
     return;
   }
 
-  orchestrator.reset();
-  lowerInstructionPending = false;
-  pendingIntegerWrites.fill(0);
-  pendingIALUWrites.fill(0);
-  bypassedIntegerValues.fill(0);
-  endDelaySlotPending = false;
-  branchDelaySlotPending = false;
-  pendingBranchTaken = false;
-  pendingBranchLinkValid = false;
-  terminationRequested = false;
-  haltAfterDrain = false;
+  clearExecutionState();
   terminationPositionValid = false;
   state = VPU_STATE_STOP;
 
@@ -224,7 +368,7 @@ void VPU::resetCycles()
   cycles = 0;
 }
 
-uint32_t VPU::elapsedCycles() const
+uint64_t VPU::elapsedCycles() const
 {
   return cycles;
 }
@@ -240,13 +384,44 @@ void VPU::uploadMicroInstructions(const vector<uint8_t> &instructions)
   {
     throw invalid_argument("Microprogram size must be a multiple of 8 bytes.");
   }
-  if (instructions.size() > microMem.size())
+
+  writeMicroMemory(0, instructions);
+  microMemPC = 0;
+}
+
+size_t VPU::writeMicroMemory(size_t address, const vector<uint8_t> &instructions)
+{
+  if (instructions.size() % 8 != 0)
+  {
+    throw invalid_argument("Microprogram size must be a multiple of 8 bytes.");
+  }
+  if (address % 8 != 0)
+  {
+    throw invalid_argument("VU micro-memory address must be 8-byte aligned.");
+  }
+  if (address > microMem.size() || instructions.size() > microMem.size() - address)
   {
     throw out_of_range("Microprogram exceeds VU micro memory.");
   }
 
-  copy(instructions.begin(), instructions.end(), microMem.begin());
-  microMemPC = 0;
+  size_t changedPairs = 0;
+
+  for (size_t offset = 0; offset < instructions.size(); offset += 8)
+  {
+    vector<uint8_t>::const_iterator source = instructions.begin() + offset;
+    vector<uint8_t>::iterator target = microMem.begin() + address + offset;
+
+    if (equal(source, source + 8, target))
+    {
+      continue;
+    }
+
+    copy(source, source + 8, target);
+    decodedMicroMem[(address + offset) / 8].valid = false;
+    changedPairs++;
+  }
+
+  return changedPairs;
 }
 
 void VPU::writeDataMemory(size_t address, const vector<uint8_t> &data)
@@ -269,6 +444,187 @@ vector<uint8_t> VPU::readDataMemory(size_t address, size_t byteCount) const
   return vector<uint8_t>(vuMem.begin() + address, vuMem.begin() + address + byteCount);
 }
 
+uint8_t *VPU::dataMemory()
+{
+  return vuMem.data();
+}
+
+vector<uint8_t> VPU::saveState() const
+{
+  vector<uint8_t> stateBuffer;
+  saveState(&stateBuffer);
+  return stateBuffer;
+}
+
+void VPU::saveState(vector<uint8_t> *stateBuffer) const
+{
+  stateBuffer->clear();
+  stateBuffer->reserve(microMem.size() + vuMem.size() + 1024);
+  SaveStateWriter writer(stateBuffer);
+
+  writer.writeU32(VPU_SAVE_STATE_MAGIC);
+  writer.writeU16(VPU_SAVE_STATE_VERSION);
+  writer.writeU8(static_cast<uint8_t>(type));
+
+  for (const FPRegister &reg : fpRegisters)
+  {
+    reg.saveState(&writer);
+  }
+  for (uint16_t value : intRegisters)
+  {
+    writer.writeU16(value);
+  }
+  accumulator.saveState(&writer);
+  writer.writeU32(iRegister.bits());
+  writer.writeDouble(qRegister);
+  writer.writeDouble(pRegister);
+  writer.writeU32(rRegister);
+  writer.writeU16(MACFlags);
+  writer.writeU16(statusFlags);
+  writer.writeU64(clippingFlags);
+
+  writer.writeU8(state);
+  writer.writeU8(mode);
+  writer.writeU64(cycles);
+  writer.writeU16(microMemPC);
+  writer.writeU16(terminationPositionCounter);
+  writer.writeBool(terminationPositionValid);
+  writer.writeBool(endDelaySlotPending);
+  writer.writeBool(branchDelaySlotPending);
+  writer.writeBool(pendingBranchTaken);
+  writer.writeU16(pendingBranchTarget);
+  writer.writeBool(pendingBranchLinkValid);
+  writer.writeU8(pendingBranchLinkRegister);
+  writer.writeU16(pendingBranchLinkValue);
+  writer.writeBool(terminationRequested);
+  writer.writeBool(haltAfterDrain);
+  writer.writeBool(dEnabled);
+  writer.writeBool(tEnabled);
+
+  saveLowerInstruction(&writer, pendingLowerInstruction);
+  writer.writeU16(pendingLowerInstructionAddress);
+  writer.writeBool(lowerInstructionPending);
+  writer.writeBool(pendingLowerInstructionReady);
+  writer.writeBool(pendingLowerWritebackDiscarded);
+  saveArray(&writer, pendingIntegerWrites);
+  saveArray(&writer, pendingIALUWrites);
+  saveArray(&writer, bypassedIntegerValues);
+  orchestrator.saveState(&writer);
+
+  writer.writeBytes(microMem.data(), microMem.size());
+  writer.writeBytes(vuMem.data(), vuMem.size());
+}
+
+void VPU::loadState(const vector<uint8_t> &stateBuffer)
+{
+  SaveStateReader reader(stateBuffer.data(), stateBuffer.size());
+
+  if (reader.remaining() < 7 || reader.readU32() != VPU_SAVE_STATE_MAGIC)
+  {
+    throw invalid_argument("VU save state has an invalid header.");
+  }
+  if (reader.readU16() != VPU_SAVE_STATE_VERSION)
+  {
+    throw invalid_argument("Unsupported VU save-state version.");
+  }
+  if (reader.readU8() != static_cast<uint8_t>(type))
+  {
+    throw invalid_argument("VU save state does not match this VU type.");
+  }
+
+  try
+  {
+    loadStateFields(&reader);
+    if (reader.remaining() != 0)
+    {
+      throw invalid_argument("VU save state has trailing data.");
+    }
+  }
+  catch (...)
+  {
+    reset();
+    throw;
+  }
+}
+
+void VPU::loadStateFields(SaveStateReader *reader)
+{
+  for (FPRegister &reg : fpRegisters)
+  {
+    reg.loadState(reader);
+  }
+  for (uint16_t &value : intRegisters)
+  {
+    value = reader->readU16();
+  }
+  accumulator.loadState(reader);
+  iRegister.setBits(reader->readU32());
+  qRegister = reader->readDouble();
+  pRegister = reader->readDouble();
+  rRegister = reader->readU32();
+  MACFlags = reader->readU16();
+  statusFlags = reader->readU16();
+  clippingFlags = reader->readU64();
+
+  state = reader->readU8();
+  if (state != VPU_STATE_READY && state != VPU_STATE_RUN && state != VPU_STATE_STOP)
+  {
+    throw invalid_argument("VU save state contains an invalid execution state.");
+  }
+  mode = reader->readU8();
+  if (mode != VPU_MODE_MICRO && mode != VPU_MODE_MACRO)
+  {
+    throw invalid_argument("VU save state contains an invalid mode.");
+  }
+  cycles = reader->readU64();
+  microMemPC = reader->readU16();
+  if (microMemPC > microMem.size() - 8)
+  {
+    throw invalid_argument("VU save state contains a PC outside micro memory.");
+  }
+  terminationPositionCounter = reader->readU16();
+  terminationPositionValid = reader->readBool();
+  endDelaySlotPending = reader->readBool();
+  branchDelaySlotPending = reader->readBool();
+  pendingBranchTaken = reader->readBool();
+  pendingBranchTarget = reader->readU16();
+  pendingBranchLinkValid = reader->readBool();
+  pendingBranchLinkRegister = reader->readU8() & (NUM_INT_REGISTERS - 1);
+  pendingBranchLinkValue = reader->readU16();
+  terminationRequested = reader->readBool();
+  haltAfterDrain = reader->readBool();
+  dEnabled = reader->readBool();
+  tEnabled = reader->readBool();
+
+  pendingLowerInstruction = loadLowerInstruction(reader);
+  pendingLowerInstructionAddress = reader->readU16();
+  lowerInstructionPending = reader->readBool();
+  pendingLowerInstructionReady = reader->readBool();
+  pendingLowerWritebackDiscarded = reader->readBool();
+  loadArray(reader, &pendingIntegerWrites);
+  loadArray(reader, &pendingIALUWrites);
+  loadArray(reader, &bypassedIntegerValues);
+  orchestrator.loadState(reader);
+
+  loadMicroMemoryState(reader->readSpan(microMem.size()));
+  reader->readBytes(vuMem.data(), vuMem.size());
+}
+
+void VPU::loadMicroMemoryState(const uint8_t *instructions)
+{
+  for (size_t pair = 0; pair < decodedMicroMem.size(); pair++)
+  {
+    const uint8_t *source = instructions + pair * 8;
+    vector<uint8_t>::iterator target = microMem.begin() + pair * 8;
+
+    if (!equal(source, source + 8, target))
+    {
+      copy(source, source + 8, target);
+      decodedMicroMem[pair].valid = false;
+    }
+  }
+}
+
 void VPU::initMicroMode()
 {
   startMicroMode();
@@ -290,19 +646,9 @@ void VPU::startMicroMode(uint16_t startAddress)
     throw out_of_range("VU start address is outside micro memory.");
   }
 
-  orchestrator.reset();
-  lowerInstructionPending = false;
-  pendingIntegerWrites.fill(0);
-  pendingIALUWrites.fill(0);
-  bypassedIntegerValues.fill(0);
+  clearExecutionState();
   mode = VPU_MODE_MICRO;
   microMemPC = startAddress;
-  endDelaySlotPending = false;
-  branchDelaySlotPending = false;
-  pendingBranchTaken = false;
-  pendingBranchLinkValid = false;
-  terminationRequested = false;
-  haltAfterDrain = false;
   state = VPU_STATE_RUN;
 }
 
@@ -329,35 +675,17 @@ bool VPU::tick()
     }
     else if (orchestrator.stalling)
     {
-      emitTrace({
-        VPUTraceEventType::PipelineStall,
-        cycles,
-        microMemPC,
-        0,
-        0,
-        0,
-        0,
-        0
-      });
+      emitStallTrace(NULL);
     }
     else
     {
       bool executingEndDelaySlot = endDelaySlotPending;
       bool executingBranchDelaySlot = branchDelaySlotPending;
       uint16_t instructionAddress = microMemPC;
-      uint32_t upperInstruction = nextUpperInstruction();
-      uint32_t lowerInstruction = nextLowerInstruction();
-      LowerInstruction decodedLowerInstruction;
-
-      if (hasFlag(upperInstruction, VPU_I_BIT))
-      {
-        decodedLowerInstruction.unit = LowerExecutionUnit::Immediate;
-        decodedLowerInstruction.immediateBits = lowerInstruction;
-      }
-      else
-      {
-        decodedLowerInstruction = decodeLowerInstruction(lowerInstruction);
-      }
+      const VPUDecodedInstructionPair &instructionPair = nextInstructionPair();
+      uint32_t upperInstruction = instructionPair.upperInstruction;
+      uint32_t lowerInstruction = instructionPair.lowerInstruction;
+      const LowerInstruction &decodedLowerInstruction = instructionPair.lower;
 
       if (executingEndDelaySlot && endBitSet(upperInstruction))
       {
@@ -371,20 +699,11 @@ bool VPU::tick()
 
       if (lowerInstructionStalls(decodedLowerInstruction))
       {
-        emitTrace({
-          VPUTraceEventType::PipelineStall,
-          cycles,
-          microMemPC,
-          0,
-          0,
-          0,
-          0,
-          0
-        });
+        emitStallTrace(&decodedLowerInstruction);
       }
       else
       {
-        uint16_t upperOpCode = processUpperInstruction(upperInstruction);
+        uint16_t upperOpCode = processUpperInstruction(instructionPair);
         queueLowerInstruction(
           decodedLowerInstruction,
           upperOpCode,
@@ -483,6 +802,22 @@ uint32_t VPU::run(uint32_t maxCycles)
   return executedCycles;
 }
 
+uint64_t VPU::runUntil(uint64_t deadline)
+{
+  if (state != VPU_STATE_RUN)
+  {
+    cycles = max(cycles, deadline);
+    return VPU_CYCLE_IDLE;
+  }
+
+  while (state == VPU_STATE_RUN && cycles < deadline)
+  {
+    tick();
+  }
+
+  return state == VPU_STATE_RUN ? max(cycles, deadline) : cycles;
+}
+
 void VPU::executeMicroInstructions()
 {
   while (state == VPU_STATE_RUN)
@@ -491,9 +826,10 @@ void VPU::executeMicroInstructions()
   }
 }
 
-void VPU::setTraceCallback(VPUTraceCallback callback)
+void VPU::setTraceCallback(VPUTraceCallback callback, bool includeStallReasons)
 {
   traceCallback = callback;
+  stallReasonsTraced = includeStallReasons;
 }
 
 void VPU::emitTrace(const VPUTraceEvent &event) const
@@ -504,6 +840,32 @@ void VPU::emitTrace(const VPUTraceEvent &event) const
   }
 }
 
+void VPU::emitStallTrace(const LowerInstruction *stalledLowerInstruction) const
+{
+  if (!traceCallback)
+  {
+    return;
+  }
+
+  VPUTraceEvent event = {
+    VPUTraceEventType::PipelineStall,
+    cycles,
+    microMemPC,
+    0,
+    0,
+    0,
+    0,
+    0
+  };
+  if (stallReasonsTraced)
+  {
+    event.stallReason = stalledLowerInstruction == NULL ?
+      upperStallReason() :
+      lowerStallReason(*stalledLowerInstruction);
+  }
+  traceCallback(event);
+}
+
 uint32_t VPU::nextUpperInstruction()
 {
   if (microMemPC + 7 >= microMem.size())
@@ -527,9 +889,54 @@ uint32_t VPU::nextLowerInstruction()
     (static_cast<uint32_t>(microMem[microMemPC + 3]) << 24);
 }
 
-uint16_t VPU::processUpperInstruction(uint32_t upperInstruction)
+const VPUDecodedInstructionPair &VPU::nextInstructionPair()
 {
-  uint16_t opCode = opCodeFromInstruction(upperInstruction);
+  uint32_t upperInstruction = nextUpperInstruction();
+  uint32_t lowerInstruction = nextLowerInstruction();
+
+  if (microMemPC % 8 != 0)
+  {
+    decodeInstructionPair(&unalignedInstructionPair, upperInstruction, lowerInstruction);
+    return unalignedInstructionPair;
+  }
+
+  VPUDecodedInstructionPair &pair = decodedMicroMem[microMemPC / 8];
+  if (!pair.valid)
+  {
+    decodeInstructionPair(&pair, upperInstruction, lowerInstruction);
+  }
+
+  return pair;
+}
+
+void VPU::decodeInstructionPair(VPUDecodedInstructionPair *pair, uint32_t upperInstruction, uint32_t lowerInstruction)
+{
+  LowerInstruction decodedLowerInstruction;
+
+  if (hasFlag(upperInstruction, VPU_I_BIT))
+  {
+    decodedLowerInstruction.unit = LowerExecutionUnit::Immediate;
+    decodedLowerInstruction.immediateBits = lowerInstruction;
+  }
+  else
+  {
+    decodedLowerInstruction = decodeLowerInstruction(lowerInstruction);
+  }
+
+  pair->upperInstruction = upperInstruction;
+  pair->lowerInstruction = lowerInstruction;
+  pair->lower = decodedLowerInstruction;
+  pair->upperSupported = decodeUpperOpCode(upperInstruction, &pair->upperOpCode);
+  pair->valid = true;
+}
+
+uint16_t VPU::processUpperInstruction(const VPUDecodedInstructionPair &pair)
+{
+  uint32_t upperInstruction = pair.upperInstruction;
+  uint16_t opCode =
+    pair.upperSupported ?
+    pair.upperOpCode :
+    opCodeFromInstruction(upperInstruction);
 
   if (opCode == VPU_NOP)
   {
@@ -567,21 +974,34 @@ uint8_t VPU::src1RegFromOpCodeAndInstruction(uint16_t opCode, uint32_t instructi
   }
 }
 
-uint16_t VPU::opCodeFromInstruction(uint32_t instruction)
+bool VPU::decodeUpperOpCode(uint32_t instruction, uint16_t *opCode) const
 {
   uint16_t type3OpCode = instruction & VPU_TYPE3_MASK;
   if (type3OpCodes.find(type3OpCode) != type3OpCodes.end())
   {
-    return type3OpCode;
+    *opCode = type3OpCode;
+    return true;
   }
 
   uint16_t type1OpCode = instruction & VPU_TYPE1_MASK;
   if (type1OpCodes.find(type1OpCode) != type1OpCodes.end())
   {
-    return type1OpCode;
+    *opCode = type1OpCode;
+    return true;
   }
 
-  throw runtime_error("Unsupported VU upper instruction.");
+  return false;
+}
+
+uint16_t VPU::opCodeFromInstruction(uint32_t instruction)
+{
+  uint16_t opCode;
+  if (!decodeUpperOpCode(instruction, &opCode))
+  {
+    throw runtime_error("Unsupported VU upper instruction.");
+  }
+
+  return opCode;
 }
 
 uint8_t VPU::regFromInstruction(uint32_t instruction, uint8_t shift)
@@ -1036,6 +1456,78 @@ bool VPU::lowerInstructionStalls(const LowerInstruction &instruction) const
   throw runtime_error("Unsupported VU lower execution unit.");
 }
 
+VPUStallReason VPU::upperStallReason() const
+{
+  const Pipeline *stalled = orchestrator.stalledPipeline();
+  if (stalled == NULL)
+  {
+    VPUStallReason reason = {VPUStallUnit::Upper};
+    return reason;
+  }
+
+  return hazardStallReason(
+    VPUStallUnit::Upper,
+    stalled->srcReg1,
+    stalled->srcReg1FieldMask,
+    stalled->srcReg2,
+    stalled->srcReg2FieldMask);
+}
+
+VPUStallReason VPU::lowerStallReason(const LowerInstruction &instruction) const
+{
+  if (instruction.opCode == VPU_SQI)
+  {
+    if (hasPendingIntegerWrite(instruction.sourceRegister2))
+    {
+      return integerStallReason(instruction.sourceRegister2);
+    }
+    return hazardStallReason(
+      VPUStallUnit::Lower,
+      instruction.sourceRegister1,
+      instruction.destinationFieldMask,
+      VPU_REGISTER_VF00,
+      FP_REGISTER_NO_FIELDS);
+  }
+
+  if (hasPendingIntegerWrite(instruction.sourceRegister1))
+  {
+    return integerStallReason(instruction.sourceRegister1);
+  }
+  return integerStallReason(instruction.sourceRegister2);
+}
+
+VPUStallReason VPU::hazardStallReason(VPUStallUnit unit, uint8_t srcReg1, uint8_t srcReg1FieldMask, uint8_t srcReg2, uint8_t srcReg2FieldMask) const
+{
+  VPUStallReason reason = {unit, VPUStallRegisterClass::Float};
+  const Pipeline *blocking = orchestrator.findRegisterHazard(
+    srcReg1,
+    srcReg1FieldMask,
+    srcReg2,
+    srcReg2FieldMask);
+  if (blocking == NULL)
+  {
+    return reason;
+  }
+
+  uint8_t fieldMask = srcReg1 == blocking->destReg ? srcReg1FieldMask : 0;
+  fieldMask |= srcReg2 == blocking->destReg ? srcReg2FieldMask : 0;
+  reason.registerID = blocking->destReg;
+  reason.fieldMask = fieldMask & blocking->destFieldMask;
+  reason.blockingInstructionAddress = blocking->instructionAddress;
+  return reason;
+}
+
+VPUStallReason VPU::integerStallReason(uint8_t registerID) const
+{
+  VPUStallReason reason = {VPUStallUnit::Lower, VPUStallRegisterClass::Integer, registerID};
+  const Pipeline *blocking = orchestrator.findIntegerWriter(registerID);
+  if (blocking != NULL)
+  {
+    reason.blockingInstructionAddress = blocking->instructionAddress;
+  }
+  return reason;
+}
+
 bool VPU::lowerInstructionForbiddenInEndDelaySlot(const LowerInstruction &instruction) const
 {
   return
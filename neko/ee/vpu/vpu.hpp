@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "fp_register.hpp"
+#include "save_state.hpp"
 #include "vpu_lower_instruction.hpp"
 #include "vpu_pipeline_handler.hpp"
 #include "vpu_pipeline_orchestrator.hpp"
@@ -18,9 +19,17 @@
 #define VPU_STATE_STOP 3
 #define VPU_MODE_MICRO 1
 #define VPU_MODE_MACRO 2
+#define VPU_SAVE_STATE_VERSION 1
+#define VPU_CLOCK_HZ 147456000
+#define VPU_CYCLE_IDLE UINT64_MAX
+#define NUM_TYPE1_OPCODES 52
+#define NUM_TYPE3_OPCODES 43
 
 using namespace std;
 
+extern const uint16_t type1OpCodeList[NUM_TYPE1_OPCODES];
+extern const uint16_t type3OpCodeList[NUM_TYPE3_OPCODES];
+
 enum class VPUType : uint8_t
 {
   VU0,
@@ -35,24 +44,70 @@ enum class VPUTraceEventType : uint8_t
   ForceBreak
 };
 
+enum class VPUStallUnit : uint8_t
+{
+  None,
+  Upper,
+  Lower
+};
+
+enum class VPUStallRegisterClass : uint8_t
+{
+  None,
+  Float,
+  Integer
+};
+
+// Filled in on stall events only when the trace consumer asks for reasons.
+struct VPUStallReason
+{
+  VPUStallUnit unit = VPUStallUnit::None;
+  VPUStallRegisterClass registerClass = VPUStallRegisterClass::None;
+  uint8_t registerID = 0;
+  uint8_t fieldMask = 0;
+  uint16_t blockingInstructionAddress = 0;
+};
+
 struct VPUTraceEvent
 {
   VPUTraceEventType type;
-  uint32_t cycle;
+  uint64_t cycle;
   uint16_t instructionAddress;
   uint32_t upperInstruction;
   uint32_t lowerInstruction;
   uint16_t opCode;
   uint8_t destinationRegister;
   uint8_t destinationFieldMask;
+  VPUStallReason stallReason = {};
 };
 
 using VPUTraceCallback = function<void(const VPUTraceEvent &)>;
 
+// The register file a PipelineWriteback event with this opCode writes to;
+// destinationRegister alone does not tell VI and VF registers apart.
+VPUStallRegisterClass vpuWritebackRegisterClass(uint16_t opCode);
+
+struct VPUResetOptions
+{
+  bool keepMicroMemory = false;
+  bool keepDataMemory = false;
+};
+
+struct VPUDecodedInstructionPair
+{
+  bool valid = false;
+  bool upperSupported = false;
+  uint16_t upperOpCode = 0;
+  uint32_t upperInstruction = 0;
+  uint32_t lowerInstruction = 0;
+  LowerInstruction lower;
+};
+
 class VPU : public PipelineHandler
 {
   public:
     explicit VPU(VPUType type = VPUType::VU0);
+    void reset(const VPUResetOptions &options = VPUResetOptions());
     FPRegister accumulator;
     uint64_t clippingFlags = 0;
 
@@ -73,7 +128,7 @@ class VPU : public PipelineHandler
     void loadFPRegister(int registerID, double x, double y, double z, double w);
     void loadIntFPRegister(int registerID, int32_t x, int32_t y, int32_t z, int32_t w);
     void loadIntRegister(int registerID, int value);
-    uint32_t elapsedCycles() const;
+    uint64_t elapsedCycles() const;
     void resetCycles();
     void setMode(uint8_t newMode);
     void initMicroMode();
@@ -81,10 +136,22 @@ class VPU : public PipelineHandler
     bool tick();
     bool stepInstruction();
     uint32_t run(uint32_t maxCycles);
-    void setTraceCallback(VPUTraceCallback callback);
+    // Runs on the VU's 64-bit cycle timeline until elapsedCycles() reaches
+    // deadline. Returns the cycle the VU next needs scheduling: deadline while
+    // it is still running, the termination cycle when the program stopped
+    // inside the slice, or VPU_CYCLE_IDLE when it was not running. An idle VU
+    // only advances its clock to the deadline.
+    uint64_t runUntil(uint64_t deadline);
+    void setTraceCallback(VPUTraceCallback callback, bool includeStallReasons = false);
     void uploadMicroInstructions(const vector<uint8_t> &instructions);
+    size_t writeMicroMemory(size_t address, const vector<uint8_t> &instructions);
     void writeDataMemory(size_t address, const vector<uint8_t> &data);
     vector<uint8_t> readDataMemory(size_t address, size_t byteCount) const;
+    // Direct access for DMA-style writers such as the VIF.
+    uint8_t *dataMemory();
+    vector<uint8_t> saveState() const;
+    void saveState(vector<uint8_t> *stateBuffer) const;
+    void loadState(const vector<uint8_t> &stateBuffer);
     virtual void pipelineStarted(Pipeline * p);
     virtual void pipelineFinished(Pipeline * p);
     bool hasMACFlag(uint16_t flag);
@@ -95,9 +162,11 @@ class VPU : public PipelineHandler
   private:
     VPUType type;
     vector<uint8_t> microMem;
+    vector<VPUDecodedInstructionPair> decodedMicroMem;
+    VPUDecodedInstructionPair unalignedInstructionPair;
     vector<uint8_t> vuMem;
     uint8_t state = VPU_STATE_READY;
-    uint32_t cycles = 0;
+    uint64_t cycles = 0;
     uint8_t mode = VPU_MODE_MACRO;
     uint16_t microMemPC = 0;
     uint16_t terminationPositionCounter = 0;
@@ -114,6 +183,7 @@ class VPU : public PipelineHandler
     bool dEnabled = false;
     bool tEnabled = false;
     VPUTraceCallback traceCallback;
+    bool stallReasonsTraced = false;
     vector<FPRegister> fpRegisters;
     vector<uint16_t> intRegisters;
     VUFloat iRegister;
@@ -140,15 +210,27 @@ class VPU : public PipelineHandler
     void initMemory();
     void initFPRegisters();
     void initIntRegisters();
+    void clearMicroMemory();
+    void clearExecutionState();
+    void loadMicroMemoryState(const uint8_t *instructions);
+    void loadStateFields(SaveStateReader *reader);
     void initOpCodeSets();
     void initPipelineOrchestrator();
     void executeMicroInstructions();
     void emitTrace(const VPUTraceEvent &event) const;
+    void emitStallTrace(const LowerInstruction *stalledLowerInstruction) const;
+    VPUStallReason upperStallReason() const;
+    VPUStallReason lowerStallReason(const LowerInstruction &instruction) const;
+    VPUStallReason hazardStallReason(VPUStallUnit unit, uint8_t srcReg1, uint8_t srcReg1FieldMask, uint8_t srcReg2, uint8_t srcReg2FieldMask) const;
+    VPUStallReason integerStallReason(uint8_t registerID) const;
     bool endBitSet(uint32_t instruction);
     bool haltBitSet(uint32_t instruction);
     uint32_t nextUpperInstruction();
     uint32_t nextLowerInstruction();
-    uint16_t processUpperInstruction(uint32_t upperInstruction);
+    const VPUDecodedInstructionPair &nextInstructionPair();
+    void decodeInstructionPair(VPUDecodedInstructionPair *pair, uint32_t upperInstruction, uint32_t lowerInstruction);
+    uint16_t processUpperInstruction(const VPUDecodedInstructionPair &pair);
+    bool decodeUpperOpCode(uint32_t instruction, uint16_t *opCode) const;
     uint16_t opCodeFromInstruction(uint32_t instruction);
     uint8_t regFromInstruction(uint32_t instruction, uint8_t shift);
     uint8_t src1RegFromOpCodeAndInstruction(uint16_t opCode, uint32_t instruction);
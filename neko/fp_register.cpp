@@ -7,6 +7,7 @@
 #include "bit_ops.hpp"
 #include "floating_point_ops.hpp"
 #include "fp_register.hpp"
+#include "save_state.hpp"
 
 using namespace std;
 
@@ -135,6 +136,30 @@ FPRegister::FPRegister(double x, double y, double z, double w) : x(x), y(y), z(z
 {
 }
 
+void FPRegister::saveState(SaveStateWriter * writer) const
+{
+  writer->writeU32(x.bits());
+  writer->writeU32(y.bits());
+  writer->writeU32(z.bits());
+  writer->writeU32(w.bits());
+  writer->writeU8(xResultFlags);
+  writer->writeU8(yResultFlags);
+  writer->writeU8(zResultFlags);
+  writer->writeU8(wResultFlags);
+}
+
+void FPRegister::loadState(SaveStateReader * reader)
+{
+  x.setBits(reader->readU32());
+  y.setBits(reader->readU32());
+  z.setBits(reader->readU32());
+  w.setBits(reader->readU32());
+  xResultFlags = reader->readU8();
+  yResultFlags = reader->readU8();
+  zResultFlags = reader->readU8();
+  wResultFlags = reader->readU8();
+}
+
 void FPRegister::load(double newX, double newY, double newZ, double newW)
 {
   x = newX;
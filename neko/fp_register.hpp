@@ -3,6 +3,9 @@
 
 #include <cstdint>
 
+class SaveStateReader;
+class SaveStateWriter;
+
 #define FP_REGISTER_NO_FIELDS 0
 #define FP_REGISTER_X_FIELD 1
 #define FP_REGISTER_Y_FIELD 2
@@ -40,6 +43,8 @@ class FPRegister
     void load(double x, double y, double z, double w);
     void copyFrom(FPRegister * srcReg);
     void copyFieldsFrom(FPRegister * srcReg, uint8_t fieldMask);
+    void saveState(SaveStateWriter * writer) const;
+    void loadState(SaveStateReader * reader);
     VUFloat x;
     VUFloat y;
     VUFloat z;
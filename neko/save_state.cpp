@@ -0,0 +1,118 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "save_state.hpp"
+
+SaveStateWriter::SaveStateWriter(std::vector<std::uint8_t> *buffer) : buffer(buffer)
+{
+}
+
+void SaveStateWriter::writeU8(std::uint8_t value)
+{
+  buffer->push_back(value);
+}
+
+void SaveStateWriter::writeU16(std::uint16_t value)
+{
+  writeU8(value & 0xff);
+  writeU8(value >> 8);
+}
+
+void SaveStateWriter::writeU32(std::uint32_t value)
+{
+  writeU16(value & 0xffff);
+  writeU16(value >> 16);
+}
+
+void SaveStateWriter::writeU64(std::uint64_t value)
+{
+  writeU32(value & 0xffffffff);
+  writeU32(value >> 32);
+}
+
+void SaveStateWriter::writeBool(bool value)
+{
+  writeU8(value ? 1 : 0);
+}
+
+void SaveStateWriter::writeDouble(double value)
+{
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  writeU64(bits);
+}
+
+void SaveStateWriter::writeBytes(const std::uint8_t *bytes, std::size_t size)
+{
+  buffer->insert(buffer->end(), bytes, bytes + size);
+}
+
+SaveStateReader::SaveStateReader(const std::uint8_t *bytes, std::size_t size) : bytes(bytes), size(size), offset(0)
+{
+}
+
+const std::uint8_t *SaveStateReader::readSpan(std::size_t count)
+{
+  if (count > size - offset)
+  {
+    throw std::invalid_argument("Save state is truncated.");
+  }
+
+  const std::uint8_t *position = bytes + offset;
+  offset += count;
+  return position;
+}
+
+std::uint8_t SaveStateReader::readU8()
+{
+  return *readSpan(1);
+}
+
+std::uint16_t SaveStateReader::readU16()
+{
+  const std::uint8_t *value = readSpan(2);
+  return static_cast<std::uint16_t>(value[0] | (value[1] << 8));
+}
+
+std::uint32_t SaveStateReader::readU32()
+{
+  std::uint32_t low = readU16();
+  std::uint32_t high = readU16();
+  return low | (high << 16);
+}
+
+std::uint64_t SaveStateReader::readU64()
+{
+  std::uint64_t low = readU32();
+  std::uint64_t high = readU32();
+  return low | (high << 32);
+}
+
+bool SaveStateReader::readBool()
+{
+  std::uint8_t value = readU8();
+  if (value > 1)
+  {
+    throw std::invalid_argument("Save state contains an invalid boolean.");
+  }
+
+  return value == 1;
+}
+
+double SaveStateReader::readDouble()
+{
+  std::uint64_t bits = readU64();
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void SaveStateReader::readBytes(std::uint8_t *destination, std::size_t count)
+{
+  std::memcpy(destination, readSpan(count), count);
+}
+
+std::size_t SaveStateReader::remaining() const
+{
+  return size - offset;
+}
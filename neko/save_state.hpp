@@ -0,0 +1,42 @@
+#ifndef SAVE_STATE_HPP
+#define SAVE_STATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SaveStateWriter
+{
+  public:
+    explicit SaveStateWriter(std::vector<std::uint8_t> *buffer);
+    void writeU8(std::uint8_t value);
+    void writeU16(std::uint16_t value);
+    void writeU32(std::uint32_t value);
+    void writeU64(std::uint64_t value);
+    void writeBool(bool value);
+    void writeDouble(double value);
+    void writeBytes(const std::uint8_t *bytes, std::size_t size);
+  private:
+    std::vector<std::uint8_t> *buffer;
+};
+
+class SaveStateReader
+{
+  public:
+    SaveStateReader(const std::uint8_t *bytes, std::size_t size);
+    std::uint8_t readU8();
+    std::uint16_t readU16();
+    std::uint32_t readU32();
+    std::uint64_t readU64();
+    bool readBool();
+    double readDouble();
+    void readBytes(std::uint8_t *bytes, std::size_t size);
+    const std::uint8_t *readSpan(std::size_t size);
+    std::size_t remaining() const;
+  private:
+    const std::uint8_t *bytes;
+    std::size_t size;
+    std::size_t offset;
+};
+
+#endif
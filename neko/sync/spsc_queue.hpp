@@ -0,0 +1,94 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#define SPSC_QUEUE_CACHE_LINE 64
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two.
+template <typename T>
+class SPSCQueue
+{
+  public:
+    explicit SPSCQueue(std::size_t capacity)
+    {
+      if (capacity == 0)
+      {
+        throw std::invalid_argument(
+          "SPSC queue capacity must be greater than zero.");
+      }
+
+      std::size_t slotCount = 1;
+      while (slotCount < capacity)
+      {
+        slotCount <<= 1;
+      }
+      slots.resize(slotCount);
+      mask = slotCount - 1;
+    }
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    bool tryPush(const T &value)
+    {
+      std::size_t tail = writeIndex.load(std::memory_order_relaxed);
+      if (tail - cachedReadIndex == slots.size())
+      {
+        cachedReadIndex = readIndex.load(std::memory_order_acquire);
+        if (tail - cachedReadIndex == slots.size())
+        {
+          return false;
+        }
+      }
+
+      slots[tail & mask] = value;
+      writeIndex.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool tryPop(T *value)
+    {
+      std::size_t head = readIndex.load(std::memory_order_relaxed);
+      if (head == cachedWriteIndex)
+      {
+        cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+        if (head == cachedWriteIndex)
+        {
+          return false;
+        }
+      }
+
+      *value = slots[head & mask];
+      readIndex.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    std::size_t capacity() const
+    {
+      return slots.size();
+    }
+
+    bool empty() const
+    {
+      return readIndex.load(std::memory_order_acquire) ==
+        writeIndex.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::vector<T> slots;
+    std::size_t mask = 0;
+    char sharedPadding[SPSC_QUEUE_CACHE_LINE];
+    std::atomic<std::size_t> writeIndex{0};
+    std::size_t cachedReadIndex = 0;
+    char producerPadding[SPSC_QUEUE_CACHE_LINE];
+    std::atomic<std::size_t> readIndex{0};
+    std::size_t cachedWriteIndex = 0;
+    char consumerPadding[SPSC_QUEUE_CACHE_LINE];
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "neko_system.hpp"
+
+static_assert(
+  NEKO_MASTER_CLOCK_HZ % VPU_CLOCK_HZ == 0,
+  "The VU clock must divide the master clock.");
+
+VPUClockDomain::VPUClockDomain(VPU *vpu) : vpu(vpu)
+{
+}
+
+uint64_t VPUClockDomain::advanceTo(uint64_t tick)
+{
+  uint64_t attention = vpu->runUntil(tick / NEKO_VU_CLOCK_DIVIDER - cycleOffset);
+  if (attention == VPU_CYCLE_IDLE)
+  {
+    return SCHEDULER_NEVER;
+  }
+  return (attention + cycleOffset) * NEKO_VU_CLOCK_DIVIDER;
+}
+
+void VPUClockDomain::rebase(uint64_t tick)
+{
+  cycleOffset = tick / NEKO_VU_CLOCK_DIVIDER - vpu->elapsedCycles();
+}
+
+NekoSystem::NekoSystem(uint64_t sliceTicks) :
+  vu0Unit(VPUType::VU0),
+  vu1Unit(VPUType::VU1),
+  vu0Domain(&vu0Unit),
+  vu1Domain(&vu1Unit),
+  systemScheduler(sliceTicks)
+{
+  systemScheduler.addComponent(&vu0Domain);
+  systemScheduler.addComponent(&vu1Domain);
+}
+
+VPU &NekoSystem::vu0()
+{
+  return vu0Unit;
+}
+
+VPU &NekoSystem::vu1()
+{
+  return vu1Unit;
+}
+
+Scheduler &NekoSystem::scheduler()
+{
+  return systemScheduler;
+}
+
+uint64_t NekoSystem::masterTick() const
+{
+  return systemScheduler.now();
+}
+
+void NekoSystem::resetVU(VPUType type, const VPUResetOptions &options)
+{
+  if (type == VPUType::VU0)
+  {
+    vu0Unit.reset(options);
+    vu0Domain.rebase(masterTick());
+  }
+  else
+  {
+    vu1Unit.reset(options);
+    vu1Domain.rebase(masterTick());
+  }
+}
+
+void NekoSystem::runUntil(uint64_t tick)
+{
+  systemScheduler.runUntil(tick);
+}
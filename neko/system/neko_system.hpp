@@ -0,0 +1,54 @@
+#ifndef NEKO_SYSTEM_HPP
+#define NEKO_SYSTEM_HPP
+
+#include <cstdint>
+
+#include "scheduler.hpp"
+#include "vpu.hpp"
+
+// The master clock runs at the EE clock; every other clock is an integer
+// divider of it.
+#define NEKO_MASTER_CLOCK_HZ 294912000
+#define NEKO_VU_CLOCK_DIVIDER (NEKO_MASTER_CLOCK_HZ / VPU_CLOCK_HZ)
+
+// Runs a VPU against the master clock. Resetting the VPU rewinds its own
+// cycle counter, so the domain keeps the offset between the two and has to be
+// rebased whenever the VPU is reset.
+class VPUClockDomain : public SchedulerComponent
+{
+  public:
+    explicit VPUClockDomain(VPU *vpu);
+    std::uint64_t advanceTo(std::uint64_t tick) override;
+    // Places the VPU's current cycle at master tick on the timeline.
+    void rebase(std::uint64_t tick);
+
+  private:
+    VPU *vpu;
+    std::uint64_t cycleOffset = 0;
+};
+
+// Owns the hardware components and the scheduler that interleaves them.
+class NekoSystem
+{
+  public:
+    explicit NekoSystem(std::uint64_t sliceTicks = SCHEDULER_DEFAULT_SLICE_TICKS);
+    NekoSystem(const NekoSystem &) = delete;
+    NekoSystem &operator=(const NekoSystem &) = delete;
+    VPU &vu0();
+    VPU &vu1();
+    Scheduler &scheduler();
+    std::uint64_t masterTick() const;
+    // Resets a VU and keeps it on the master timeline. Reset the VUs through
+    // here rather than through vu0() or vu1().
+    void resetVU(VPUType type, const VPUResetOptions &options = VPUResetOptions());
+    void runUntil(std::uint64_t tick);
+
+  private:
+    VPU vu0Unit;
+    VPU vu1Unit;
+    VPUClockDomain vu0Domain;
+    VPUClockDomain vu1Domain;
+    Scheduler systemScheduler;
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "scheduler.hpp"
+
+using namespace std;
+
+// Advances one component per slice on a persistent host thread.
+class Scheduler::SliceWorker
+{
+  public:
+    SliceWorker() : thread(&SliceWorker::work, this)
+    {
+    }
+
+    ~SliceWorker()
+    {
+      {
+        lock_guard<mutex> lock(guard);
+        stopping = true;
+      }
+      wake.notify_one();
+      thread.join();
+    }
+
+    void start(SchedulerComponent *component, uint64_t tick, uint64_t *attention)
+    {
+      {
+        lock_guard<mutex> lock(guard);
+        this->component = component;
+        this->tick = tick;
+        this->attention = attention;
+        pending = true;
+      }
+      wake.notify_one();
+    }
+
+    exception_ptr finish()
+    {
+      unique_lock<mutex> lock(guard);
+      done.wait(lock, [this]() { return !pending; });
+      exception_ptr result = failure;
+      failure = nullptr;
+      return result;
+    }
+
+  private:
+    mutex guard;
+    condition_variable wake;
+    condition_variable done;
+    SchedulerComponent *component = nullptr;
+    uint64_t tick = 0;
+    uint64_t *attention = nullptr;
+    exception_ptr failure;
+    bool pending = false;
+    bool stopping = false;
+    std::thread thread;
+
+    void work()
+    {
+      unique_lock<mutex> lock(guard);
+      while (true)
+      {
+        wake.wait(lock, [this]() { return pending || stopping; });
+        if (stopping)
+        {
+          return;
+        }
+
+        lock.unlock();
+        try
+        {
+          *attention = component->advanceTo(tick);
+        }
+        catch (...)
+        {
+          failure = current_exception();
+        }
+        lock.lock();
+        pending = false;
+        done.notify_one();
+      }
+    }
+};
+
+Scheduler::Scheduler(uint64_t sliceTicks)
+{
+  setSliceTicks(sliceTicks);
+}
+
+Scheduler::~Scheduler()
+{
+}
+
+void Scheduler::setSliceTicks(uint64_t sliceTicks)
+{
+  if (sliceTicks == 0)
+  {
+    throw invalid_argument("Scheduler slices must be at least one tick.");
+  }
+
+  slice = sliceTicks;
+}
+
+uint64_t Scheduler::sliceTicks() const
+{
+  return slice;
+}
+
+uint64_t Scheduler::now() const
+{
+  return currentTick;
+}
+
+void Scheduler::setExecution(SchedulerExecution execution)
+{
+  mode = execution;
+  if (mode == SchedulerExecution::Serial)
+  {
+    workers.clear();
+  }
+}
+
+SchedulerExecution Scheduler::execution() const
+{
+  return mode;
+}
+
+void Scheduler::addComponent(SchedulerComponent *component)
+{
+  components.push_back(component);
+  componentAttention.push_back(SCHEDULER_NEVER);
+}
+
+void Scheduler::schedule(uint64_t tick, SchedulerCallback callback)
+{
+  if (tick < currentTick)
+  {
+    throw invalid_argument("Scheduler events cannot be scheduled in the past.");
+  }
+
+  events.push({tick, nextSequence++, callback});
+}
+
+void Scheduler::runUntil(uint64_t deadline)
+{
+  fireDueEvents();
+
+  while (currentTick < deadline)
+  {
+    uint64_t end = sliceEnd(deadline);
+    advanceComponents(end);
+    currentTick = end;
+    fireDueEvents();
+  }
+}
+
+uint64_t Scheduler::sliceEnd(uint64_t deadline) const
+{
+  uint64_t end = deadline - currentTick > slice ? currentTick + slice : deadline;
+  if (!events.empty())
+  {
+    end = min(end, events.top().tick);
+  }
+  for (uint64_t attention : componentAttention)
+  {
+    if (attention > currentTick)
+    {
+      end = min(end, attention);
+    }
+  }
+  return end;
+}
+
+void Scheduler::advanceComponents(uint64_t end)
+{
+  if (mode == SchedulerExecution::Parallel && components.size() > 1)
+  {
+    advanceComponentsInParallel(end);
+    return;
+  }
+
+  exception_ptr failure;
+  for (size_t index = 0; index < components.size(); index++)
+  {
+    try
+    {
+      componentAttention[index] = components[index]->advanceTo(end);
+    }
+    catch (...)
+    {
+      failure = failure ? failure : current_exception();
+    }
+  }
+  if (failure)
+  {
+    rethrow_exception(failure);
+  }
+}
+
+// The first component runs on the calling thread while the workers run the
+// rest; the slice ends once every worker has finished.
+void Scheduler::advanceComponentsInParallel(uint64_t end)
+{
+  while (workers.size() < components.size() - 1)
+  {
+    workers.emplace_back(new SliceWorker());
+  }
+
+  for (size_t index = 1; index < components.size(); index++)
+  {
+    workers[index - 1]->start(components[index], end, &componentAttention[index]);
+  }
+
+  exception_ptr failure;
+  try
+  {
+    componentAttention[0] = components[0]->advanceTo(end);
+  }
+  catch (...)
+  {
+    failure = current_exception();
+  }
+
+  for (size_t index = 1; index < components.size(); index++)
+  {
+    exception_ptr workerFailure = workers[index - 1]->finish();
+    failure = failure ? failure : workerFailure;
+  }
+  if (failure)
+  {
+    rethrow_exception(failure);
+  }
+}
+
+void Scheduler::fireDueEvents()
+{
+  while (!events.empty() && events.top().tick <= currentTick)
+  {
+    Event event = events.top();
+    events.pop();
+    event.callback(event.tick);
+  }
+}
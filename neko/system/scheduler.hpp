@@ -0,0 +1,95 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#define SCHEDULER_NEVER UINT64_MAX
+#define SCHEDULER_DEFAULT_SLICE_TICKS 4096
+
+// A component that can run on its own up to a master-clock tick.
+class SchedulerComponent
+{
+  public:
+    virtual ~SchedulerComponent() {}
+    // Advances to tick and returns the tick at which the component next needs
+    // the scheduler, or SCHEDULER_NEVER. Ticks at or before tick impose no
+    // limit on later slices.
+    virtual std::uint64_t advanceTo(std::uint64_t tick) = 0;
+};
+
+typedef std::function<void(std::uint64_t tick)> SchedulerCallback;
+
+enum class SchedulerExecution : std::uint8_t
+{
+  Serial,
+  // Every component after the first advances on its own host thread. Slice
+  // ends are the synchronization points: components must not touch shared
+  // state inside advanceTo, so anything shared has to be an event or an
+  // attention tick. Results then match serial execution exactly.
+  Parallel
+};
+
+// Runs components in slices on an integer master clock. A slice ends at the
+// earliest of the deadline, the slice granularity, the next scheduled event
+// and the next tick a component asked for. Within a slice components advance
+// in the order they were added; events due at the slice end then fire in
+// tick order, ties in the order they were scheduled. When a component throws,
+// the slice still finishes and the first failure in component order is
+// rethrown.
+class Scheduler
+{
+  public:
+    explicit Scheduler(std::uint64_t sliceTicks = SCHEDULER_DEFAULT_SLICE_TICKS);
+    ~Scheduler();
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+    void setSliceTicks(std::uint64_t sliceTicks);
+    std::uint64_t sliceTicks() const;
+    std::uint64_t now() const;
+    void setExecution(SchedulerExecution execution);
+    SchedulerExecution execution() const;
+    void addComponent(SchedulerComponent *component);
+    void schedule(std::uint64_t tick, SchedulerCallback callback);
+    void runUntil(std::uint64_t deadline);
+
+  private:
+    struct Event
+    {
+      std::uint64_t tick;
+      std::uint64_t sequence;
+      SchedulerCallback callback;
+    };
+
+    struct LaterEvent
+    {
+      bool operator()(const Event &left, const Event &right) const
+      {
+        return left.tick != right.tick ?
+          left.tick > right.tick :
+          left.sequence > right.sequence;
+      }
+    };
+
+    class SliceWorker;
+
+    std::uint64_t currentTick = 0;
+    std::uint64_t slice;
+    std::uint64_t nextSequence = 0;
+    std::vector<SchedulerComponent *> components;
+    std::vector<std::uint64_t> componentAttention;
+    std::priority_queue<Event, std::vector<Event>, LaterEvent> events;
+    SchedulerExecution mode = SchedulerExecution::Serial;
+    std::vector<std::unique_ptr<SliceWorker>> workers;
+
+    std::uint64_t sliceEnd(std::uint64_t deadline) const;
+    void advanceComponents(std::uint64_t end);
+    void advanceComponentsInParallel(std::uint64_t end);
+    void fireDueEvents();
+};
+
+#endif
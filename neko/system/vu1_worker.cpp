@@ -0,0 +1,194 @@
+#include "vu1_worker.hpp"
+
+using namespace std;
+
+VU1Worker::VU1Worker(const VU1WorkerOptions &options) :
+  vu1(VPUType::VU1),
+  commands(options.commandCapacity),
+  outputs(options.outputCapacity)
+{
+  worker = thread(&VU1Worker::work, this);
+}
+
+VU1Worker::~VU1Worker()
+{
+  stopping.store(true, memory_order_release);
+  wake(&workerSleeping, &workerWake);
+  worker.join();
+}
+
+void VU1Worker::uploadMicroProgram(size_t address, const vector<uint8_t> &instructions)
+{
+  VU1Command command;
+  command.type = VU1CommandType::UploadMicroProgram;
+  command.address = address;
+  command.data = instructions;
+  submit(command);
+}
+
+void VU1Worker::writeDataMemory(size_t address, const vector<uint8_t> &data)
+{
+  VU1Command command;
+  command.type = VU1CommandType::WriteDataMemory;
+  command.address = address;
+  command.data = data;
+  submit(command);
+}
+
+void VU1Worker::start(uint16_t startAddress, size_t outputAddress, size_t outputSize)
+{
+  VU1Command command;
+  command.type = VU1CommandType::Start;
+  command.startAddress = startAddress;
+  command.outputAddress = outputAddress;
+  command.outputSize = outputSize;
+  submit(command);
+}
+
+bool VU1Worker::tryReadOutput(VU1Output *output)
+{
+  if (!outputs.tryPop(output))
+  {
+    return false;
+  }
+  wake(&workerSleeping, &workerWake);
+  return true;
+}
+
+void VU1Worker::synchronize()
+{
+  sleepUntil(&producerSleeping, &producerWake, [this]() {
+    return completedCommands.load(memory_order_acquire) >= submittedCommands ||
+      workerFailed.load(memory_order_acquire);
+  });
+
+  if (workerFailed.load(memory_order_acquire) && workerError)
+  {
+    exception_ptr error = workerError;
+    workerError = nullptr;
+    rethrow_exception(error);
+  }
+}
+
+const VPU &VU1Worker::vu() const
+{
+  return vu1;
+}
+
+// Commands submitted after a worker failure are dropped.
+void VU1Worker::submit(const VU1Command &command)
+{
+  bool pushed = false;
+  sleepUntil(&producerSleeping, &producerWake, [this, &command, &pushed]() {
+    pushed = commands.tryPush(command);
+    return pushed || workerFailed.load(memory_order_acquire);
+  });
+  if (!pushed)
+  {
+    return;
+  }
+  submittedCommands++;
+  wake(&workerSleeping, &workerWake);
+}
+
+// The sleeper advertises itself before re-checking ready, and a waker fences
+// between its ring update and reading the flag, so one of them always sees
+// the other. The mutex is only taken on the sleeping path.
+template <typename Ready>
+void VU1Worker::sleepUntil(atomic<bool> *sleeping, condition_variable *condition, Ready ready)
+{
+  if (ready())
+  {
+    return;
+  }
+
+  unique_lock<mutex> lock(wakeMutex);
+  sleeping->store(true, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  condition->wait(lock, ready);
+  sleeping->store(false, memory_order_relaxed);
+}
+
+void VU1Worker::wake(atomic<bool> *sleeping, condition_variable *condition)
+{
+  atomic_thread_fence(memory_order_seq_cst);
+  if (sleeping->load(memory_order_relaxed))
+  {
+    lock_guard<mutex> lock(wakeMutex);
+    condition->notify_all();
+  }
+}
+
+void VU1Worker::work()
+{
+  try
+  {
+    VU1Command command;
+    while (true)
+    {
+      sleepUntil(&workerSleeping, &workerWake, [this, &command]() {
+        return stopping.load(memory_order_acquire) || commands.tryPop(&command);
+      });
+      if (stopping.load(memory_order_acquire))
+      {
+        return;
+      }
+      wake(&producerSleeping, &producerWake);
+
+      execute(command);
+      completedCommands.fetch_add(1, memory_order_release);
+      wake(&producerSleeping, &producerWake);
+    }
+  }
+  catch (...)
+  {
+    workerError = current_exception();
+    workerFailed.store(true, memory_order_release);
+    wake(&producerSleeping, &producerWake);
+  }
+}
+
+void VU1Worker::execute(const VU1Command &command)
+{
+  switch (command.type)
+  {
+    case VU1CommandType::UploadMicroProgram:
+      vu1.writeMicroMemory(command.address, command.data);
+      break;
+    case VU1CommandType::WriteDataMemory:
+      vu1.writeDataMemory(command.address, command.data);
+      break;
+    case VU1CommandType::Start:
+      runProgram(command);
+      break;
+  }
+}
+
+void VU1Worker::runProgram(const VU1Command &command)
+{
+  uint64_t startCycle = vu1.elapsedCycles();
+  vu1.startMicroMode(command.startAddress);
+
+  uint64_t nextCycle = startCycle;
+  while (vu1.getState() == VPU_STATE_RUN)
+  {
+    if (stopping.load(memory_order_acquire))
+    {
+      return;
+    }
+    nextCycle = vu1.runUntil(vu1.elapsedCycles() + VU1_WORKER_RUN_CYCLES);
+  }
+
+  VU1Output output;
+  output.startAddress = command.startAddress;
+  output.elapsedCycles = nextCycle - startCycle;
+  output.terminationPosition = vu1.terminationPosition();
+  if (command.outputSize > 0)
+  {
+    output.data = vu1.readDataMemory(command.outputAddress, command.outputSize);
+  }
+
+  sleepUntil(&workerSleeping, &workerWake, [this, &output]() {
+    return stopping.load(memory_order_acquire) || outputs.tryPush(output);
+  });
+}
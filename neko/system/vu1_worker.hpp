@@ -0,0 +1,105 @@
+#ifndef VU1_WORKER_HPP
+#define VU1_WORKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.hpp"
+#include "vpu.hpp"
+
+// VU cycles the worker runs between checks for shutdown.
+#define VU1_WORKER_RUN_CYCLES 4096
+
+enum class VU1CommandType : std::uint8_t
+{
+  UploadMicroProgram,
+  WriteDataMemory,
+  Start
+};
+
+// One entry of the command ring, mirroring the VIF commands that feed VU1:
+// MPG uploads, UNPACK writes and MSCAL starts.
+struct VU1Command
+{
+  VU1CommandType type = VU1CommandType::Start;
+  std::size_t address = 0;
+  std::vector<std::uint8_t> data;
+  std::uint16_t startAddress = 0;
+  std::size_t outputAddress = 0;
+  std::size_t outputSize = 0;
+};
+
+// Published when a started program terminates. data holds the requested
+// window of VU1 data memory as it was at termination.
+struct VU1Output
+{
+  std::uint16_t startAddress = 0;
+  std::uint64_t elapsedCycles = 0;
+  std::uint16_t terminationPosition = 0;
+  std::vector<std::uint8_t> data;
+};
+
+struct VU1WorkerOptions
+{
+  std::size_t commandCapacity = 256;
+  std::size_t outputCapacity = 256;
+};
+
+// Runs VU1 on its own thread. Commands are executed in order and a Start
+// holds back later commands until its program terminates. The producer only
+// waits when the command ring is full, and the worker only waits when the
+// output ring is full, so the consumer must keep draining outputs. Both rings
+// stay lock-free; a side takes the mutex only to sleep, or to wake the other
+// side after it has advertised that it is asleep.
+class VU1Worker
+{
+  public:
+    explicit VU1Worker(const VU1WorkerOptions &options = VU1WorkerOptions());
+    ~VU1Worker();
+    VU1Worker(const VU1Worker &) = delete;
+    VU1Worker &operator=(const VU1Worker &) = delete;
+
+    void uploadMicroProgram(std::size_t address, const std::vector<std::uint8_t> &instructions);
+    void writeDataMemory(std::size_t address, const std::vector<std::uint8_t> &data);
+    void start(std::uint16_t startAddress, std::size_t outputAddress = 0, std::size_t outputSize = 0);
+    bool tryReadOutput(VU1Output *output);
+    // Waits until every submitted command has finished and rethrows a worker
+    // failure. vu() may be inspected until the next command is submitted.
+    void synchronize();
+    const VPU &vu() const;
+
+  private:
+    VPU vu1;
+    SPSCQueue<VU1Command> commands;
+    SPSCQueue<VU1Output> outputs;
+    std::uint64_t submittedCommands = 0;
+    std::atomic<std::uint64_t> completedCommands{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> workerFailed{false};
+    std::exception_ptr workerError;
+    std::mutex wakeMutex;
+    std::atomic<bool> workerSleeping{false};
+    std::atomic<bool> producerSleeping{false};
+    // Signalled when a command is submitted, an output is read or the worker
+    // is stopping.
+    std::condition_variable workerWake;
+    // Signalled when a command is taken or completes, or the worker fails.
+    std::condition_variable producerWake;
+    std::thread worker;
+
+    void submit(const VU1Command &command);
+    template <typename Ready>
+    void sleepUntil(std::atomic<bool> *sleeping, std::condition_variable *condition, Ready ready);
+    void wake(std::atomic<bool> *sleeping, std::condition_variable *condition);
+    void work();
+    void execute(const VU1Command &command);
+    void runProgram(const VU1Command &command);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "allocation_tracker.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  thread_local AllocationCounts counts;
+
+  void *allocate(std::size_t size)
+  {
+    counts.allocations++;
+    counts.bytes += size;
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+      throw std::bad_alloc();
+    }
+    return memory;
+  }
+
+  void release(void *memory)
+  {
+    if (memory != nullptr)
+    {
+      counts.deallocations++;
+      std::free(memory);
+    }
+  }
+}
+
+AllocationCounts threadAllocationCounts()
+{
+  return counts;
+}
+
+AllocationCounts operator-(
+  const AllocationCounts &after,
+  const AllocationCounts &before)
+{
+  AllocationCounts difference;
+  difference.allocations = after.allocations - before.allocations;
+  difference.deallocations = after.deallocations - before.deallocations;
+  difference.bytes = after.bytes - before.bytes;
+  return difference;
+}
+
+void *operator new(std::size_t size)
+{
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+  return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocate(size);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return allocate(size);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return nullptr;
+  }
+}
+
+void operator delete(void *memory) noexcept
+{
+  release(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+  release(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+  release(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+  release(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+  release(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+  release(memory);
+}
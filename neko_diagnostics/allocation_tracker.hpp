@@ -0,0 +1,44 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// Linking allocation_tracker.cpp replaces the global operator new and delete
+// with versions that count every call on the calling thread. Counts from
+// other threads are not visible here.
+struct AllocationCounts
+{
+  std::uint64_t allocations = 0;
+  std::uint64_t deallocations = 0;
+  std::uint64_t bytes = 0;
+};
+
+AllocationCounts threadAllocationCounts();
+AllocationCounts operator-(
+  const AllocationCounts &after,
+  const AllocationCounts &before);
+
+template <typename Work>
+AllocationCounts countAllocations(Work work)
+{
+  AllocationCounts before = threadAllocationCounts();
+  work();
+  return threadAllocationCounts() - before;
+}
+
+// Throws when work allocates, naming the work and the number of allocations.
+template <typename Work>
+void requireNoAllocations(const char *description, Work work)
+{
+  AllocationCounts counts = countAllocations(work);
+  if (counts.allocations != 0)
+  {
+    throw std::logic_error(
+      std::string(description) + " allocated " +
+      std::to_string(counts.allocations) + " times.");
+  }
+}
+
+#endif
@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "fp_register.hpp"
+#include "vpu_program_runner.hpp"
+#include "vpu_trace_differ.hpp"
+#include "vpu_trace_file.hpp"
+
+namespace
+{
+  void printUsage()
+  {
+    std::cerr
+      << "usage: neko_trace <trace.bin> range <first-cycle> <last-cycle>\n"
+      << "       neko_trace <trace.bin> pc <instruction-address>\n"
+      << "       neko_trace <trace.bin> writebacks <vfN|viN> [xyzw]\n"
+      << "       neko_trace <trace.bin> stalls <minimum-cycles>\n"
+      << "       neko_trace diff <left.bin> <right.bin>\n";
+  }
+
+  std::uint64_t parseNumber(const std::string &text)
+  {
+    std::size_t parsed = 0;
+    std::uint64_t value = std::stoull(text, &parsed, 0);
+    if (parsed != text.size())
+    {
+      throw std::invalid_argument("Invalid number: " + text);
+    }
+
+    return value;
+  }
+
+  // Accepts vf3 or vi3 style names; a bare number is ambiguous because VF and
+  // VI writebacks share register numbers.
+  void parseRegister(
+    const std::string &text,
+    VPUStallRegisterClass *registerClass,
+    std::uint8_t *registerID)
+  {
+    std::string prefix = text.substr(0, 2);
+    if (prefix == "vf" || prefix == "VF")
+    {
+      *registerClass = VPUStallRegisterClass::Float;
+    }
+    else if (prefix == "vi" || prefix == "VI")
+    {
+      *registerClass = VPUStallRegisterClass::Integer;
+    }
+    else
+    {
+      throw std::invalid_argument("Invalid register: " + text);
+    }
+
+    std::uint64_t value = parseNumber(text.substr(2));
+    if (value >= 32 ||
+      (*registerClass == VPUStallRegisterClass::Integer && value >= 16))
+    {
+      throw std::invalid_argument("Invalid register: " + text);
+    }
+    *registerID = static_cast<std::uint8_t>(value);
+  }
+
+  std::uint8_t parseFieldMask(const std::string &text)
+  {
+    std::uint8_t fieldMask = FP_REGISTER_NO_FIELDS;
+    for (char field : text)
+    {
+      switch (field)
+      {
+        case 'x':
+          fieldMask |= FP_REGISTER_X_FIELD;
+          break;
+        case 'y':
+          fieldMask |= FP_REGISTER_Y_FIELD;
+          break;
+        case 'z':
+          fieldMask |= FP_REGISTER_Z_FIELD;
+          break;
+        case 'w':
+          fieldMask |= FP_REGISTER_W_FIELD;
+          break;
+        default:
+          throw std::invalid_argument("Invalid field mask: " + text);
+      }
+    }
+
+    return fieldMask;
+  }
+
+  void printEvent(const VPUTraceEvent &event)
+  {
+    writeVPUTraceEventJsonLine(std::cout, event);
+  }
+
+  int runDiff(const char *leftPath, const char *rightPath)
+  {
+    std::ifstream left(leftPath, std::ios::binary);
+    std::ifstream right(rightPath, std::ios::binary);
+    if (!left || !right)
+    {
+      throw std::runtime_error("Unable to open VU trace file.");
+    }
+
+    VPUTraceDivergence divergence = diffVPUBinaryTraces(left, right);
+    writeVPUTraceDivergence(std::cout, divergence);
+    return divergence.diverged ? 2 : 0;
+  }
+
+  int runQuery(int argc, const char *argv[])
+  {
+    if (std::string(argv[1]) == "diff")
+    {
+      if (argc != 4)
+      {
+        printUsage();
+        return 1;
+      }
+      return runDiff(argv[2], argv[3]);
+    }
+
+    VPUTraceFile trace(argv[1]);
+    std::string query = argv[2];
+
+    if (query == "range" && argc == 5)
+    {
+      trace.eventsInCycleRange(
+        parseNumber(argv[3]), parseNumber(argv[4]), printEvent);
+    }
+    else if (query == "pc" && argc == 4)
+    {
+      trace.issuesAt(
+        static_cast<std::uint16_t>(parseNumber(argv[3])), printEvent);
+    }
+    else if (query == "writebacks" && (argc == 4 || argc == 5))
+    {
+      VPUStallRegisterClass registerClass;
+      std::uint8_t registerID;
+      parseRegister(argv[3], &registerClass, &registerID);
+      trace.writebacksTo(
+        registerClass,
+        registerID,
+        argc == 5 ? parseFieldMask(argv[4]) : FP_REGISTER_NO_FIELDS,
+        printEvent);
+    }
+    else if (query == "stalls" && argc == 4)
+    {
+      for (const VPUTraceStallSpan &span :
+        trace.stallSpansLongerThan(parseNumber(argv[3])))
+      {
+        std::cout
+          << "{\"instruction_address\":" << span.instructionAddress
+          << ",\"first_cycle\":" << span.firstCycle
+          << ",\"last_cycle\":" << span.lastCycle
+          << ",\"cycles\":" << span.lastCycle - span.firstCycle + 1
+          << "}\n";
+      }
+    }
+    else
+    {
+      printUsage();
+      return 1;
+    }
+
+    return 0;
+  }
+}
+
+int main(int argc, const char *argv[])
+{
+  if (argc < 3)
+  {
+    printUsage();
+    return 1;
+  }
+
+  try
+  {
+    return runQuery(argc, argv);
+  }
+  catch (const std::exception &error)
+  {
+    std::cerr << "neko_trace: " << error.what() << "\n";
+    return 1;
+  }
+}
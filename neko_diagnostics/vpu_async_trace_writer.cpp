@@ -0,0 +1,165 @@
+#include "vpu_async_trace_writer.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+#include "vpu_trace_output.hpp"
+
+VPUAsyncTraceWriter::VPUAsyncTraceWriter(
+  std::ostream *output,
+  const VPUAsyncTraceWriterOptions &options,
+  const VPUBinaryTraceHeader &header) :
+  output(output),
+  options(options),
+  header(header),
+  queue(options.queueCapacity)
+{
+  if (output == nullptr)
+  {
+    throw std::invalid_argument("VU async trace writer requires an output.");
+  }
+
+  writer = std::thread(&VPUAsyncTraceWriter::drain, this);
+}
+
+VPUAsyncTraceWriter::~VPUAsyncTraceWriter()
+{
+  if (writer.joinable())
+  {
+    producerDone.store(true, std::memory_order_release);
+    wake(&writerSleeping, &writerWake);
+    writer.join();
+  }
+}
+
+void VPUAsyncTraceWriter::write(const VPUTraceEvent &event)
+{
+  if (queue.tryPush(event))
+  {
+    if (++unsignalledEvents >= VPU_ASYNC_TRACE_BATCH_SIZE)
+    {
+      unsignalledEvents = 0;
+      wake(&writerSleeping, &writerWake);
+    }
+    return;
+  }
+
+  unsignalledEvents = 0;
+  wake(&writerSleeping, &writerWake);
+  if (options.backpressure == VPUTraceBackpressure::Block)
+  {
+    bool pushed = false;
+    sleepUntil(&producerSleeping, &producerWake, [this, &event, &pushed]() {
+      pushed = queue.tryPush(event);
+      return pushed || writerFailed.load(std::memory_order_acquire);
+    });
+    if (pushed)
+    {
+      unsignalledEvents++;
+      return;
+    }
+  }
+
+  dropped++;
+}
+
+void VPUAsyncTraceWriter::finish()
+{
+  if (writer.joinable())
+  {
+    producerDone.store(true, std::memory_order_release);
+    wake(&writerSleeping, &writerWake);
+    writer.join();
+  }
+
+  if (writerError)
+  {
+    std::exception_ptr error = writerError;
+    writerError = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+std::uint64_t VPUAsyncTraceWriter::droppedEvents() const
+{
+  return dropped;
+}
+
+// The sleeper advertises itself before re-checking ready, and a waker fences
+// between its queue update and reading the flag, so one of them always sees
+// the other.
+template <typename Ready>
+void VPUAsyncTraceWriter::sleepUntil(
+  std::atomic<bool> *sleeping,
+  std::condition_variable *condition,
+  Ready ready)
+{
+  if (ready())
+  {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(wakeMutex);
+  sleeping->store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  condition->wait(lock, ready);
+  sleeping->store(false, std::memory_order_relaxed);
+}
+
+void VPUAsyncTraceWriter::wake(
+  std::atomic<bool> *sleeping,
+  std::condition_variable *condition)
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping->load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    condition->notify_all();
+  }
+}
+
+void VPUAsyncTraceWriter::drain()
+{
+  try
+  {
+    VPUTraceOutput traceOutput(output, options.format, header);
+
+    std::vector<VPUTraceEvent> batch(VPU_ASYNC_TRACE_BATCH_SIZE);
+    while (true)
+    {
+      bool producerFinished = producerDone.load(std::memory_order_acquire);
+      std::size_t eventCount = 0;
+      while (eventCount < batch.size() && queue.tryPop(&batch[eventCount]))
+      {
+        eventCount++;
+      }
+      if (eventCount > 0)
+      {
+        wake(&producerSleeping, &producerWake);
+      }
+
+      for (std::size_t event = 0; event < eventCount; event++)
+      {
+        traceOutput.write(batch[event]);
+      }
+
+      if (eventCount == 0)
+      {
+        if (producerFinished)
+        {
+          traceOutput.finish();
+          break;
+        }
+        sleepUntil(&writerSleeping, &writerWake, [this]() {
+          return producerDone.load(std::memory_order_acquire) || !queue.empty();
+        });
+      }
+    }
+  }
+  catch (...)
+  {
+    writerError = std::current_exception();
+    writerFailed.store(true, std::memory_order_release);
+    wake(&producerSleeping, &producerWake);
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef VPU_ASYNC_TRACE_WRITER_H
+#define VPU_ASYNC_TRACE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "spsc_queue.hpp"
+#include "vpu_binary_trace.hpp"
+#include "vpu_program_runner.hpp"
+
+#define VPU_ASYNC_TRACE_BATCH_SIZE 256
+
+struct VPUAsyncTraceWriterOptions
+{
+  std::size_t queueCapacity = 4096;
+  VPUTraceBackpressure backpressure = VPUTraceBackpressure::Block;
+  VPUTraceOutputFormat format = VPUTraceOutputFormat::JsonLines;
+};
+
+// Formats trace events on a background thread. write() is called from the
+// emulation thread only; finish() joins the writer and rethrows its failure.
+// The writer sleeps once the queue is empty and is woken after a batch of
+// events, a full queue or finish(). A blocked producer sleeps until the
+// writer takes events.
+class VPUAsyncTraceWriter
+{
+  public:
+    VPUAsyncTraceWriter(
+      std::ostream *output,
+      const VPUAsyncTraceWriterOptions &options,
+      const VPUBinaryTraceHeader &header = VPUBinaryTraceHeader());
+    ~VPUAsyncTraceWriter();
+    VPUAsyncTraceWriter(const VPUAsyncTraceWriter &) = delete;
+    VPUAsyncTraceWriter &operator=(const VPUAsyncTraceWriter &) = delete;
+
+    void write(const VPUTraceEvent &event);
+    void finish();
+    std::uint64_t droppedEvents() const;
+
+  private:
+    std::ostream *output;
+    VPUAsyncTraceWriterOptions options;
+    VPUBinaryTraceHeader header;
+    SPSCQueue<VPUTraceEvent> queue;
+    std::atomic<bool> producerDone{false};
+    std::atomic<bool> writerFailed{false};
+    std::uint64_t dropped = 0;
+    std::size_t unsignalledEvents = 0;
+    std::exception_ptr writerError;
+    std::mutex wakeMutex;
+    std::atomic<bool> writerSleeping{false};
+    std::atomic<bool> producerSleeping{false};
+    std::condition_variable writerWake;
+    std::condition_variable producerWake;
+    std::thread writer;
+
+    template <typename Ready>
+    void sleepUntil(std::atomic<bool> *sleeping, std::condition_variable *condition, Ready ready);
+    void wake(std::atomic<bool> *sleeping, std::condition_variable *condition);
+    void drain();
+};
+
+#endif
@@ -0,0 +1,212 @@
+#include "vpu_binary_trace.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include "save_state.hpp"
+#include "vpu_program_runner.hpp"
+
+namespace
+{
+  const char traceMagic[4] = {'N', 'K', 'T', 'R'};
+
+  VPUTraceEventType traceEventType(std::uint8_t type)
+  {
+    if (type > static_cast<std::uint8_t>(VPUTraceEventType::ForceBreak))
+    {
+      throw std::runtime_error(
+        "VU binary trace contains an unknown event type.");
+    }
+
+    return static_cast<VPUTraceEventType>(type);
+  }
+
+  VPUStallUnit stallUnit(std::uint8_t unit)
+  {
+    if (unit > static_cast<std::uint8_t>(VPUStallUnit::Lower))
+    {
+      throw std::runtime_error(
+        "VU binary trace contains an unknown stall reason.");
+    }
+
+    return static_cast<VPUStallUnit>(unit);
+  }
+
+  VPUStallRegisterClass stallRegisterClass(std::uint8_t registerClass)
+  {
+    if (registerClass > static_cast<std::uint8_t>(
+      VPUStallRegisterClass::Integer))
+    {
+      throw std::runtime_error(
+        "VU binary trace contains an unknown stall reason.");
+    }
+
+    return static_cast<VPUStallRegisterClass>(registerClass);
+  }
+}
+
+VPUBinaryTraceWriter::VPUBinaryTraceWriter(
+  std::ostream *output,
+  const VPUBinaryTraceHeader &header) :
+  output(output)
+{
+  if (output == nullptr)
+  {
+    throw std::invalid_argument("VU binary trace writer requires an output.");
+  }
+
+  std::vector<std::uint8_t> bytes(traceMagic, traceMagic + 4);
+  SaveStateWriter writer(&bytes);
+  writer.writeU16(VPU_BINARY_TRACE_VERSION);
+  writer.writeU8(static_cast<std::uint8_t>(header.type));
+  writer.writeU8(0);
+  writer.writeU32(VPU_BINARY_TRACE_RECORD_SIZE);
+  writer.writeU64(header.programHash);
+  output->write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  record.reserve(VPU_BINARY_TRACE_RECORD_SIZE);
+}
+
+void VPUBinaryTraceWriter::write(const VPUTraceEvent &event)
+{
+  encodeVPUTraceRecord(event, &record);
+  output->write(reinterpret_cast<const char *>(record.data()), record.size());
+}
+
+VPUBinaryTraceReader::VPUBinaryTraceReader(std::istream *input) :
+  input(input),
+  record(VPU_BINARY_TRACE_RECORD_SIZE)
+{
+  if (input == nullptr)
+  {
+    throw std::invalid_argument("VU binary trace reader requires an input.");
+  }
+
+  std::uint8_t bytes[VPU_BINARY_TRACE_HEADER_SIZE];
+  input->read(reinterpret_cast<char *>(bytes), sizeof(bytes));
+  traceHeader = decodeVPUBinaryTraceHeader(
+    bytes,
+    static_cast<std::size_t>(input->gcount()));
+}
+
+const VPUBinaryTraceHeader &VPUBinaryTraceReader::header() const
+{
+  return traceHeader;
+}
+
+bool VPUBinaryTraceReader::read(VPUTraceEvent *event)
+{
+  input->read(reinterpret_cast<char *>(record.data()), record.size());
+  if (input->gcount() == 0)
+  {
+    return false;
+  }
+  if (input->gcount() != VPU_BINARY_TRACE_RECORD_SIZE)
+  {
+    throw std::runtime_error("VU binary trace ends with a partial record.");
+  }
+
+  decodeVPUTraceRecord(record.data(), event);
+  return true;
+}
+
+VPUBinaryTraceHeader decodeVPUBinaryTraceHeader(
+  const std::uint8_t *bytes,
+  std::size_t size)
+{
+  if (size < VPU_BINARY_TRACE_HEADER_SIZE ||
+    !std::equal(traceMagic, traceMagic + 4, bytes))
+  {
+    throw std::runtime_error("VU binary trace has an invalid header.");
+  }
+
+  SaveStateReader reader(bytes + 4, VPU_BINARY_TRACE_HEADER_SIZE - 4);
+  if (reader.readU16() != VPU_BINARY_TRACE_VERSION)
+  {
+    throw std::runtime_error("Unsupported VU binary trace version.");
+  }
+
+  std::uint8_t type = reader.readU8();
+  reader.readU8();
+  if (type > static_cast<std::uint8_t>(VPUType::VU1) ||
+    reader.readU32() != VPU_BINARY_TRACE_RECORD_SIZE)
+  {
+    throw std::runtime_error("VU binary trace has an invalid header.");
+  }
+
+  VPUBinaryTraceHeader header;
+  header.type = static_cast<VPUType>(type);
+  header.programHash = reader.readU64();
+  return header;
+}
+
+std::uint64_t hashVPUProgram(const std::vector<std::uint8_t> &microProgram)
+{
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (std::uint8_t byte : microProgram)
+  {
+    hash ^= byte;
+    hash *= 0x100000001b3;
+  }
+
+  return hash;
+}
+
+void encodeVPUTraceRecord(
+  const VPUTraceEvent &event,
+  std::vector<std::uint8_t> *record)
+{
+  record->clear();
+  SaveStateWriter writer(record);
+  writer.writeU8(static_cast<std::uint8_t>(event.type));
+  writer.writeU8(event.destinationRegister);
+  writer.writeU8(event.destinationFieldMask);
+  writer.writeU8(0);
+  writer.writeU16(event.instructionAddress);
+  writer.writeU16(event.opCode);
+  writer.writeU32(event.upperInstruction);
+  writer.writeU32(event.lowerInstruction);
+  writer.writeU64(event.cycle);
+  writer.writeU8(static_cast<std::uint8_t>(event.stallReason.unit));
+  writer.writeU8(static_cast<std::uint8_t>(event.stallReason.registerClass));
+  writer.writeU8(event.stallReason.registerID);
+  writer.writeU8(event.stallReason.fieldMask);
+  writer.writeU16(event.stallReason.blockingInstructionAddress);
+  writer.writeU16(0);
+}
+
+void decodeVPUTraceRecord(const std::uint8_t *record, VPUTraceEvent *event)
+{
+  SaveStateReader reader(record, VPU_BINARY_TRACE_RECORD_SIZE);
+  event->type = traceEventType(reader.readU8());
+  event->destinationRegister = reader.readU8();
+  event->destinationFieldMask = reader.readU8();
+  reader.readU8();
+  event->instructionAddress = reader.readU16();
+  event->opCode = reader.readU16();
+  event->upperInstruction = reader.readU32();
+  event->lowerInstruction = reader.readU32();
+  event->cycle = reader.readU64();
+  event->stallReason.unit = stallUnit(reader.readU8());
+  event->stallReason.registerClass = stallRegisterClass(reader.readU8());
+  event->stallReason.registerID = reader.readU8();
+  event->stallReason.fieldMask = reader.readU8();
+  event->stallReason.blockingInstructionAddress = reader.readU16();
+}
+
+std::size_t convertVPUBinaryTraceToJsonLines(
+  std::istream &input,
+  std::ostream &output)
+{
+  VPUBinaryTraceReader reader(&input);
+  VPUTraceEvent event;
+  std::size_t eventCount = 0;
+  while (reader.read(&event))
+  {
+    writeVPUTraceEventJsonLine(output, event);
+    eventCount++;
+  }
+
+  return eventCount;
+}
@@ -0,0 +1,71 @@
+#ifndef VPU_BINARY_TRACE_H
+#define VPU_BINARY_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include "vpu.hpp"
+
+#define VPU_BINARY_TRACE_VERSION 2
+#define VPU_BINARY_TRACE_HEADER_SIZE 20
+#define VPU_BINARY_TRACE_RECORD_SIZE 32
+
+// A binary trace is a header followed by fixed-size little-endian records:
+//   header: "NKTR", u16 version, u8 VPU type, u8 reserved, u32 record size,
+//           u64 FNV-1a hash of the microprogram
+//   record: u8 type, u8 destination register, u8 destination field mask,
+//           u8 reserved, u16 instruction address, u16 opcode,
+//           u32 upper instruction, u32 lower instruction, u64 cycle,
+//           u8 stall unit, u8 stall register class, u8 stall register,
+//           u8 stall field mask, u16 blocking instruction address,
+//           u16 reserved
+struct VPUBinaryTraceHeader
+{
+  VPUType type = VPUType::VU0;
+  std::uint64_t programHash = 0;
+};
+
+class VPUBinaryTraceWriter
+{
+  public:
+    VPUBinaryTraceWriter(
+      std::ostream *output,
+      const VPUBinaryTraceHeader &header);
+    void write(const VPUTraceEvent &event);
+
+  private:
+    std::ostream *output;
+    std::vector<std::uint8_t> record;
+};
+
+class VPUBinaryTraceReader
+{
+  public:
+    explicit VPUBinaryTraceReader(std::istream *input);
+    const VPUBinaryTraceHeader &header() const;
+    bool read(VPUTraceEvent *event);
+
+  private:
+    std::istream *input;
+    VPUBinaryTraceHeader traceHeader;
+    std::vector<std::uint8_t> record;
+};
+
+VPUBinaryTraceHeader decodeVPUBinaryTraceHeader(
+  const std::uint8_t *bytes,
+  std::size_t size);
+
+std::uint64_t hashVPUProgram(const std::vector<std::uint8_t> &microProgram);
+
+void encodeVPUTraceRecord(
+  const VPUTraceEvent &event,
+  std::vector<std::uint8_t> *record);
+void decodeVPUTraceRecord(const std::uint8_t *record, VPUTraceEvent *event);
+
+std::size_t convertVPUBinaryTraceToJsonLines(
+  std::istream &input,
+  std::ostream &output);
+
+#endif
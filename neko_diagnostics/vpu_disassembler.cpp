@@ -0,0 +1,390 @@
+#include "vpu_disassembler.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "vpu_lower_instruction.hpp"
+#include "vpu_opcodes.hpp"
+
+#define VPU_UPPER_FLAG_BITS \
+  (VPU_I_BIT | VPU_E_BIT | VPU_M_BIT | VPU_D_BIT | VPU_T_BIT)
+
+namespace
+{
+  enum class UpperForm
+  {
+    Vector,
+    Broadcast,
+    IRegister,
+    QRegister,
+    Accumulator,
+    AccumulatorBroadcast,
+    AccumulatorIRegister,
+    AccumulatorQRegister,
+    Convert,
+    Clip,
+    None
+  };
+
+  struct UpperOpCode
+  {
+    std::uint16_t opCode;
+    const char *name;
+    UpperForm form;
+  };
+
+  const UpperOpCode type3OpCodes[] = {
+    {VPU_ABS, "ABS", UpperForm::Convert},
+    {VPU_ADDA, "ADDA", UpperForm::Accumulator},
+    {VPU_ADDAi, "ADDAi", UpperForm::AccumulatorIRegister},
+    {VPU_ADDAq, "ADDAq", UpperForm::AccumulatorQRegister},
+    {VPU_CLIP, "CLIPw", UpperForm::Clip},
+    {VPU_FTOI0, "FTOI0", UpperForm::Convert},
+    {VPU_FTOI4, "FTOI4", UpperForm::Convert},
+    {VPU_FTOI12, "FTOI12", UpperForm::Convert},
+    {VPU_FTOI15, "FTOI15", UpperForm::Convert},
+    {VPU_ITOF0, "ITOF0", UpperForm::Convert},
+    {VPU_ITOF4, "ITOF4", UpperForm::Convert},
+    {VPU_ITOF12, "ITOF12", UpperForm::Convert},
+    {VPU_ITOF15, "ITOF15", UpperForm::Convert},
+    {VPU_MADDA, "MADDA", UpperForm::Accumulator},
+    {VPU_MADDAi, "MADDAi", UpperForm::AccumulatorIRegister},
+    {VPU_MADDAq, "MADDAq", UpperForm::AccumulatorQRegister},
+    {VPU_MADDAx, "MADDAx", UpperForm::AccumulatorBroadcast},
+    {VPU_MADDAy, "MADDAy", UpperForm::AccumulatorBroadcast},
+    {VPU_MADDAz, "MADDAz", UpperForm::AccumulatorBroadcast},
+    {VPU_MADDAw, "MADDAw", UpperForm::AccumulatorBroadcast},
+    {VPU_MSUBA, "MSUBA", UpperForm::Accumulator},
+    {VPU_MSUBAi, "MSUBAi", UpperForm::AccumulatorIRegister},
+    {VPU_MSUBAq, "MSUBAq", UpperForm::AccumulatorQRegister},
+    {VPU_MSUBAx, "MSUBAx", UpperForm::AccumulatorBroadcast},
+    {VPU_MSUBAy, "MSUBAy", UpperForm::AccumulatorBroadcast},
+    {VPU_MSUBAz, "MSUBAz", UpperForm::AccumulatorBroadcast},
+    {VPU_MSUBAw, "MSUBAw", UpperForm::AccumulatorBroadcast},
+    {VPU_MULA, "MULA", UpperForm::Accumulator},
+    {VPU_MULAi, "MULAi", UpperForm::AccumulatorIRegister},
+    {VPU_MULAq, "MULAq", UpperForm::AccumulatorQRegister},
+    {VPU_MULAx, "MULAx", UpperForm::AccumulatorBroadcast},
+    {VPU_MULAy, "MULAy", UpperForm::AccumulatorBroadcast},
+    {VPU_MULAz, "MULAz", UpperForm::AccumulatorBroadcast},
+    {VPU_MULAw, "MULAw", UpperForm::AccumulatorBroadcast},
+    {VPU_NOP, "NOP", UpperForm::None},
+    {VPU_OPMULA, "OPMULA", UpperForm::Accumulator},
+    {VPU_SUBA, "SUBA", UpperForm::Accumulator},
+    {VPU_SUBAi, "SUBAi", UpperForm::AccumulatorIRegister},
+    {VPU_SUBAq, "SUBAq", UpperForm::AccumulatorQRegister},
+    {VPU_SUBAx, "SUBAx", UpperForm::AccumulatorBroadcast},
+    {VPU_SUBAy, "SUBAy", UpperForm::AccumulatorBroadcast},
+    {VPU_SUBAz, "SUBAz", UpperForm::AccumulatorBroadcast},
+    {VPU_SUBAw, "SUBAw", UpperForm::AccumulatorBroadcast}
+  };
+
+  const UpperOpCode type1OpCodes[] = {
+    {VPU_ADD, "ADD", UpperForm::Vector},
+    {VPU_ADDi, "ADDi", UpperForm::IRegister},
+    {VPU_ADDq, "ADDq", UpperForm::QRegister},
+    {VPU_ADDx, "ADDx", UpperForm::Broadcast},
+    {VPU_ADDy, "ADDy", UpperForm::Broadcast},
+    {VPU_ADDz, "ADDz", UpperForm::Broadcast},
+    {VPU_ADDw, "ADDw", UpperForm::Broadcast},
+    {VPU_ADDAx, "ADDAx", UpperForm::AccumulatorBroadcast},
+    {VPU_ADDAy, "ADDAy", UpperForm::AccumulatorBroadcast},
+    {VPU_ADDAz, "ADDAz", UpperForm::AccumulatorBroadcast},
+    {VPU_ADDAw, "ADDAw", UpperForm::AccumulatorBroadcast},
+    {VPU_MADD, "MADD", UpperForm::Vector},
+    {VPU_MADDi, "MADDi", UpperForm::IRegister},
+    {VPU_MADDq, "MADDq", UpperForm::QRegister},
+    {VPU_MADDx, "MADDx", UpperForm::Broadcast},
+    {VPU_MADDy, "MADDy", UpperForm::Broadcast},
+    {VPU_MADDz, "MADDz", UpperForm::Broadcast},
+    {VPU_MADDw, "MADDw", UpperForm::Broadcast},
+    {VPU_MAX, "MAX", UpperForm::Vector},
+    {VPU_MAXi, "MAXi", UpperForm::IRegister},
+    {VPU_MAXx, "MAXx", UpperForm::Broadcast},
+    {VPU_MAXy, "MAXy", UpperForm::Broadcast},
+    {VPU_MAXz, "MAXz", UpperForm::Broadcast},
+    {VPU_MAXw, "MAXw", UpperForm::Broadcast},
+    {VPU_MINI, "MINI", UpperForm::Vector},
+    {VPU_MINIi, "MINIi", UpperForm::IRegister},
+    {VPU_MINIx, "MINIx", UpperForm::Broadcast},
+    {VPU_MINIy, "MINIy", UpperForm::Broadcast},
+    {VPU_MINIz, "MINIz", UpperForm::Broadcast},
+    {VPU_MINIw, "MINIw", UpperForm::Broadcast},
+    {VPU_MSUB, "MSUB", UpperForm::Vector},
+    {VPU_MSUBi, "MSUBi", UpperForm::IRegister},
+    {VPU_MSUBq, "MSUBq", UpperForm::QRegister},
+    {VPU_MSUBx, "MSUBx", UpperForm::Broadcast},
+    {VPU_MSUBy, "MSUBy", UpperForm::Broadcast},
+    {VPU_MSUBz, "MSUBz", UpperForm::Broadcast},
+    {VPU_MSUBw, "MSUBw", UpperForm::Broadcast},
+    {VPU_MUL, "MUL", UpperForm::Vector},
+    {VPU_MULi, "MULi", UpperForm::IRegister},
+    {VPU_MULq, "MULq", UpperForm::QRegister},
+    {VPU_MULx, "MULx", UpperForm::Broadcast},
+    {VPU_MULy, "MULy", UpperForm::Broadcast},
+    {VPU_MULz, "MULz", UpperForm::Broadcast},
+    {VPU_MULw, "MULw", UpperForm::Broadcast},
+    {VPU_OPMSUB, "OPMSUB", UpperForm::Vector},
+    {VPU_SUB, "SUB", UpperForm::Vector},
+    {VPU_SUBi, "SUBi", UpperForm::IRegister},
+    {VPU_SUBq, "SUBq", UpperForm::QRegister},
+    {VPU_SUBx, "SUBx", UpperForm::Broadcast},
+    {VPU_SUBy, "SUBy", UpperForm::Broadcast},
+    {VPU_SUBz, "SUBz", UpperForm::Broadcast},
+    {VPU_SUBw, "SUBw", UpperForm::Broadcast}
+  };
+
+  const char broadcastFields[] = {'x', 'y', 'z', 'w'};
+
+  const UpperOpCode *findUpperOpCode(std::uint32_t instruction)
+  {
+    for (const UpperOpCode &opCode : type3OpCodes)
+    {
+      if ((instruction & VPU_TYPE3_MASK) == opCode.opCode)
+      {
+        return &opCode;
+      }
+    }
+    for (const UpperOpCode &opCode : type1OpCodes)
+    {
+      if ((instruction & VPU_TYPE1_MASK) == opCode.opCode)
+      {
+        return &opCode;
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::string fieldSuffix(std::uint32_t destinationBits)
+  {
+    std::string suffix = ".";
+    suffix += (destinationBits & VPU_DEST_X_BIT) ? "x" : "";
+    suffix += (destinationBits & VPU_DEST_Y_BIT) ? "y" : "";
+    suffix += (destinationBits & VPU_DEST_Z_BIT) ? "z" : "";
+    suffix += (destinationBits & VPU_DEST_W_BIT) ? "w" : "";
+    return suffix == "." ? "" : suffix;
+  }
+
+  std::string lowerFieldSuffix(std::uint8_t fieldMask)
+  {
+    std::string suffix = ".";
+    for (std::uint8_t field = 0; field < 4; field++)
+    {
+      if (fieldMask & (1 << field))
+      {
+        suffix += broadcastFields[field];
+      }
+    }
+    return suffix == "." ? "" : suffix;
+  }
+
+  std::string registerName(const char *prefix, std::uint32_t registerID)
+  {
+    std::ostringstream name;
+    name << prefix << std::setw(2) << std::setfill('0') << registerID;
+    return name.str();
+  }
+
+  std::string upperRegister(std::uint32_t instruction, std::uint8_t shift)
+  {
+    return registerName("VF", (instruction >> shift) & VPU_REG_MASK);
+  }
+
+  std::string rawWord(std::uint32_t instruction)
+  {
+    std::ostringstream text;
+    text << ".word 0x" << std::hex << std::setw(8) << std::setfill('0')
+      << instruction;
+    return text.str();
+  }
+
+  std::string upperOperands(const UpperOpCode &opCode, std::uint32_t word)
+  {
+    std::string ft = upperRegister(word, VPU_FT_REG_SHIFT);
+    std::string fs = upperRegister(word, VPU_FS_REG_SHIFT);
+    std::string fd = upperRegister(word, VPU_FD_REG_SHIFT);
+    std::string broadcast = ft + broadcastFields[opCode.opCode & 3];
+    switch (opCode.form)
+    {
+      case UpperForm::Vector:
+        return fd + ", " + fs + ", " + ft;
+      case UpperForm::Broadcast:
+        return fd + ", " + fs + ", " + broadcast;
+      case UpperForm::IRegister:
+        return fd + ", " + fs + ", I";
+      case UpperForm::QRegister:
+        return fd + ", " + fs + ", Q";
+      case UpperForm::Accumulator:
+        return "ACC, " + fs + ", " + ft;
+      case UpperForm::AccumulatorBroadcast:
+        return "ACC, " + fs + ", " + broadcast;
+      case UpperForm::AccumulatorIRegister:
+        return "ACC, " + fs + ", I";
+      case UpperForm::AccumulatorQRegister:
+        return "ACC, " + fs + ", Q";
+      case UpperForm::Convert:
+        return ft + ", " + fs;
+      case UpperForm::Clip:
+        return fs + ".xyz, " + ft + ".w";
+      case UpperForm::None:
+        break;
+    }
+
+    return "";
+  }
+
+  std::string lowerOperands(const LowerInstruction &decoded)
+  {
+    std::string vis = registerName("VI", decoded.sourceRegister1);
+    std::string vit = registerName("VI", decoded.sourceRegister2);
+    std::string destination = decoded.opCode == VPU_LQ ||
+      decoded.opCode == VPU_MFIR ?
+      registerName("VF", decoded.destinationRegister) :
+      registerName("VI", decoded.destinationRegister);
+    std::string immediate = std::to_string(decoded.immediate);
+    switch (decoded.opCode)
+    {
+      case VPU_IADD:
+        return destination + ", " + vis + ", " + vit;
+      case VPU_ISUBIU:
+        return destination + ", " + vis + ", " + immediate;
+      case VPU_IBNE:
+        return vit + ", " + vis + ", " + immediate;
+      case VPU_JALR:
+        return destination + ", " + vis;
+      case VPU_JR:
+        return vis;
+      case VPU_ILW:
+      case VPU_LQ:
+        return destination + ", " + immediate + "(" + vis + ")";
+      case VPU_MFIR:
+        return destination + ", " + vis;
+      case VPU_SQI:
+        return registerName("VF", decoded.sourceRegister1) + ", (" +
+          registerName("VI", decoded.sourceRegister2) + "++)";
+    }
+
+    return "";
+  }
+
+  const char *lowerName(std::uint32_t opCode)
+  {
+    switch (opCode)
+    {
+      case VPU_IADD:
+        return "IADD";
+      case VPU_ISUBIU:
+        return "ISUBIU";
+      case VPU_IBNE:
+        return "IBNE";
+      case VPU_JALR:
+        return "JALR";
+      case VPU_JR:
+        return "JR";
+      case VPU_ILW:
+        return "ILW";
+      case VPU_LQ:
+        return "LQ";
+      case VPU_MFIR:
+        return "MFIR";
+      case VPU_SQI:
+        return "SQI";
+    }
+
+    return nullptr;
+  }
+}
+
+std::string disassembleVPUUpperInstruction(std::uint32_t instruction)
+{
+  const UpperOpCode *opCode = findUpperOpCode(instruction);
+  if (opCode == nullptr)
+  {
+    return rawWord(instruction);
+  }
+
+  std::string text = opCode->name;
+  if (opCode->form != UpperForm::None && opCode->form != UpperForm::Clip)
+  {
+    text += fieldSuffix(instruction & VPU_DEST_ALL_FIELDS);
+  }
+  std::string operands = upperOperands(*opCode, instruction);
+  if (!operands.empty())
+  {
+    text += " " + operands;
+  }
+
+  const char *flags[] = {"[I]", "[E]", "[M]", "[D]", "[T]"};
+  const std::uint32_t flagBits[] = {
+    VPU_I_BIT, VPU_E_BIT, VPU_M_BIT, VPU_D_BIT, VPU_T_BIT};
+  for (int flag = 0; flag < 5; flag++)
+  {
+    if (instruction & flagBits[flag])
+    {
+      text += std::string(" ") + flags[flag];
+    }
+  }
+
+  return text;
+}
+
+std::string disassembleVPULowerInstruction(std::uint32_t instruction)
+{
+  if (instruction == VPU_LOWER_NOP)
+  {
+    return "NOP";
+  }
+
+  LowerInstruction decoded;
+  try
+  {
+    decoded = decodeLowerInstruction(instruction);
+  }
+  catch (const std::runtime_error &)
+  {
+    return rawWord(instruction);
+  }
+
+  const char *name = lowerName(decoded.opCode);
+  if (name == nullptr)
+  {
+    return rawWord(instruction);
+  }
+
+  return name + lowerFieldSuffix(decoded.destinationFieldMask) + " " +
+    lowerOperands(decoded);
+}
+
+std::string disassembleVPUInstructionPair(
+  std::uint32_t upperInstruction,
+  std::uint32_t lowerInstruction)
+{
+  std::string lower;
+  if (upperInstruction & VPU_I_BIT)
+  {
+    std::ostringstream immediate;
+    immediate << "LOI 0x" << std::hex << lowerInstruction;
+    lower = immediate.str();
+  }
+  else
+  {
+    lower = disassembleVPULowerInstruction(lowerInstruction);
+  }
+
+  return disassembleVPUUpperInstruction(upperInstruction) + " | " + lower;
+}
+
+bool isVPUDualIssuePair(
+  std::uint32_t upperInstruction,
+  std::uint32_t lowerInstruction)
+{
+  if ((upperInstruction & ~VPU_UPPER_FLAG_BITS) == VPU_NOP)
+  {
+    return false;
+  }
+
+  return (upperInstruction & VPU_I_BIT) != 0 ||
+    lowerInstruction != VPU_LOWER_NOP;
+}
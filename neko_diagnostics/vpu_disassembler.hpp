@@ -0,0 +1,19 @@
+#ifndef VPU_DISASSEMBLER_H
+#define VPU_DISASSEMBLER_H
+
+#include <cstdint>
+#include <string>
+
+// Renders the instructions the VPU implements. Anything else is shown as a
+// raw word so reports never fail on unsupported encodings.
+std::string disassembleVPUUpperInstruction(std::uint32_t instruction);
+std::string disassembleVPULowerInstruction(std::uint32_t instruction);
+std::string disassembleVPUInstructionPair(
+  std::uint32_t upperInstruction,
+  std::uint32_t lowerInstruction);
+
+bool isVPUDualIssuePair(
+  std::uint32_t upperInstruction,
+  std::uint32_t lowerInstruction);
+
+#endif
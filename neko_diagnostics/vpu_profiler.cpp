@@ -0,0 +1,275 @@
+#include "vpu_profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "vpu_disassembler.hpp"
+
+#define VPU_PROFILE_EVENT_TYPES 4
+
+namespace
+{
+  std::uint32_t readInstructionWord(
+    const std::vector<std::uint8_t> &microProgram,
+    std::size_t offset)
+  {
+    return static_cast<std::uint32_t>(microProgram[offset]) |
+      (static_cast<std::uint32_t>(microProgram[offset + 1]) << 8) |
+      (static_cast<std::uint32_t>(microProgram[offset + 2]) << 16) |
+      (static_cast<std::uint32_t>(microProgram[offset + 3]) << 24);
+  }
+
+  std::uint64_t stallCauseKey(std::size_t pair, const VPUStallReason &reason)
+  {
+    return (static_cast<std::uint64_t>(pair) << 48) |
+      (static_cast<std::uint64_t>(reason.blockingInstructionAddress) << 32) |
+      (static_cast<std::uint64_t>(reason.unit) << 24) |
+      (static_cast<std::uint64_t>(reason.registerClass) << 16) |
+      (static_cast<std::uint64_t>(reason.registerID) << 8) |
+      reason.fieldMask;
+  }
+
+  VPUStallReason stallReasonFromKey(std::uint64_t key)
+  {
+    VPUStallReason reason;
+    reason.blockingInstructionAddress =
+      static_cast<std::uint16_t>(key >> 32);
+    reason.unit = static_cast<VPUStallUnit>((key >> 24) & 0xff);
+    reason.registerClass =
+      static_cast<VPUStallRegisterClass>((key >> 16) & 0xff);
+    reason.registerID = static_cast<std::uint8_t>(key >> 8);
+    reason.fieldMask = static_cast<std::uint8_t>(key);
+    return reason;
+  }
+
+  std::string stallRegisterName(const VPUStallReason &reason)
+  {
+    if (reason.registerClass == VPUStallRegisterClass::None)
+    {
+      return "unknown register";
+    }
+
+    std::ostringstream name;
+    name << (reason.registerClass == VPUStallRegisterClass::Integer ?
+      "VI" : "VF")
+      << std::setw(2) << std::setfill('0')
+      << static_cast<unsigned int>(reason.registerID);
+    if (reason.fieldMask != 0)
+    {
+      name << ".";
+      const char fields[] = {'x', 'y', 'z', 'w'};
+      for (int field = 0; field < 4; field++)
+      {
+        if (reason.fieldMask & (1 << field))
+        {
+          name << fields[field];
+        }
+      }
+    }
+    return name.str();
+  }
+
+  double percentage(std::uint64_t part, std::uint64_t total)
+  {
+    return total == 0 ? 0.0 : 100.0 * part / total;
+  }
+
+  class TraceCallbackReset
+  {
+    public:
+      explicit TraceCallbackReset(VPU *vpu) :
+        vpu(vpu)
+      {
+      }
+
+      ~TraceCallbackReset()
+      {
+        vpu->setTraceCallback(VPUTraceCallback());
+      }
+
+    private:
+      VPU *vpu;
+  };
+}
+
+VPUProfiler::VPUProfiler(
+  std::size_t microMemorySize,
+  const VPUProfilerOptions &options) :
+  collectStallCauses(options.collectStallCauses)
+{
+  if (microMemorySize < 8 || (microMemorySize & (microMemorySize - 1)) != 0)
+  {
+    throw std::invalid_argument(
+      "VU profiler memory size must be a power of two of at least 8 bytes.");
+  }
+
+  counters.resize(microMemorySize / 8 * VPU_PROFILE_EVENT_TYPES);
+  addressMask = microMemorySize - 1;
+}
+
+bool VPUProfiler::collectsStallCauses() const
+{
+  return collectStallCauses;
+}
+
+void VPUProfiler::record(const VPUTraceEvent &event)
+{
+  std::size_t pair = (event.instructionAddress & addressMask) >> 3;
+  counters[pair * VPU_PROFILE_EVENT_TYPES +
+    static_cast<std::size_t>(event.type)]++;
+  if (collectStallCauses && event.stallReason.unit != VPUStallUnit::None)
+  {
+    stallCauses[stallCauseKey(pair, event.stallReason)]++;
+  }
+}
+
+void VPUProfiler::clear()
+{
+  std::fill(counters.begin(), counters.end(), 0);
+  stallCauses.clear();
+}
+
+VPUProfileReport VPUProfiler::report(
+  const std::vector<std::uint8_t> &microProgram) const
+{
+  VPUProfileReport report;
+  std::size_t pairs = counters.size() / VPU_PROFILE_EVENT_TYPES;
+  for (std::size_t pair = 0; pair < pairs; pair++)
+  {
+    VPUProfileRow row;
+    row.instructionAddress = static_cast<std::uint16_t>(pair * 8);
+    row.executions = counter(pair, VPUTraceEventType::InstructionIssued);
+    row.stallCycles = counter(pair, VPUTraceEventType::PipelineStall);
+    row.writebacks = counter(pair, VPUTraceEventType::PipelineWriteback);
+    if (row.executions == 0 && row.stallCycles == 0 && row.writebacks == 0)
+    {
+      continue;
+    }
+
+    if (pair * 8 + 8 <= microProgram.size())
+    {
+      std::uint32_t lower = readInstructionWord(microProgram, pair * 8);
+      std::uint32_t upper = readInstructionWord(microProgram, pair * 8 + 4);
+      row.dualIssue = isVPUDualIssuePair(upper, lower);
+      row.disassembly = disassembleVPUInstructionPair(upper, lower);
+    }
+
+    auto cause = stallCauses.lower_bound(
+      static_cast<std::uint64_t>(pair) << 48);
+    for (; cause != stallCauses.end() && cause->first >> 48 == pair; ++cause)
+    {
+      VPUProfileStallCause stallCause;
+      stallCause.reason = stallReasonFromKey(cause->first);
+      stallCause.cycles = cause->second;
+      row.stallCauses.push_back(stallCause);
+    }
+
+    report.issueCycles += row.executions;
+    report.stallCycles += row.stallCycles;
+    report.dualIssueCycles += row.dualIssue ? row.executions : 0;
+    report.rows.push_back(row);
+  }
+
+  return report;
+}
+
+std::uint64_t VPUProfiler::counter(
+  std::size_t pair,
+  VPUTraceEventType type) const
+{
+  return counters[pair * VPU_PROFILE_EVENT_TYPES +
+    static_cast<std::size_t>(type)];
+}
+
+VPUProgramRunResult profileVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  VPUProfiler *profiler)
+{
+  if (profiler == nullptr)
+  {
+    throw std::invalid_argument("VU profiling requires a profiler.");
+  }
+  if (config.captureTrace || config.traceOutput != nullptr)
+  {
+    throw std::invalid_argument(
+      "VU profiling cannot be combined with trace capture.");
+  }
+
+  vpu->setTraceCallback([profiler](const VPUTraceEvent &event) {
+    profiler->record(event);
+  }, profiler->collectsStallCauses());
+  TraceCallbackReset traceCallbackReset(vpu);
+  return runVPUProgram(vpu, config);
+}
+
+void writeVPUProfileText(std::ostream &output, const VPUProfileReport &report)
+{
+  std::uint64_t totalCycles = report.issueCycles + report.stallCycles;
+  std::ios_base::fmtflags flags = output.flags();
+  output << std::fixed << std::setprecision(1)
+    << "issue cycles: " << report.issueCycles
+    << ", stall cycles: " << report.stallCycles
+    << ", dual issue: " << report.dualIssueCycles << " ("
+    << percentage(report.dualIssueCycles, report.issueCycles) << "%)\n"
+    << "address  executions  stalls   share  dual  writebacks  instruction\n";
+  for (const VPUProfileRow &row : report.rows)
+  {
+    output << "0x" << std::hex << std::setw(4) << std::setfill('0')
+      << row.instructionAddress << std::dec << std::setfill(' ')
+      << std::setw(13) << row.executions
+      << std::setw(8) << row.stallCycles
+      << std::setw(7)
+      << percentage(row.executions + row.stallCycles, totalCycles) << "%"
+      << std::setw(6) << (row.dualIssue ? "yes" : "no")
+      << std::setw(12) << row.writebacks
+      << "  " << row.disassembly << "\n";
+    for (const VPUProfileStallCause &cause : row.stallCauses)
+    {
+      output << "        " << std::setw(21) << cause.cycles
+        << "  " << (cause.reason.unit == VPUStallUnit::Upper ?
+          "upper" : "lower")
+        << " waits on " << stallRegisterName(cause.reason)
+        << " from 0x" << std::hex << std::setw(4) << std::setfill('0')
+        << cause.reason.blockingInstructionAddress << std::dec
+        << std::setfill(' ') << "\n";
+    }
+  }
+  output.flags(flags);
+}
+
+void writeVPUProfileJson(std::ostream &output, const VPUProfileReport &report)
+{
+  output << "{\"issue_cycles\":" << report.issueCycles
+    << ",\"stall_cycles\":" << report.stallCycles
+    << ",\"dual_issue_cycles\":" << report.dualIssueCycles
+    << ",\"instructions\":[";
+  for (std::size_t index = 0; index < report.rows.size(); index++)
+  {
+    const VPUProfileRow &row = report.rows[index];
+    output << (index == 0 ? "" : ",")
+      << "{\"instruction_address\":" << row.instructionAddress
+      << ",\"executions\":" << row.executions
+      << ",\"stall_cycles\":" << row.stallCycles
+      << ",\"writebacks\":" << row.writebacks
+      << ",\"dual_issue\":" << (row.dualIssue ? "true" : "false")
+      << ",\"disassembly\":\"" << row.disassembly
+      << "\",\"stall_causes\":[";
+    for (std::size_t cause = 0; cause < row.stallCauses.size(); cause++)
+    {
+      const VPUStallReason &reason = row.stallCauses[cause].reason;
+      output << (cause == 0 ? "" : ",")
+        << "{\"unit\":\""
+        << (reason.unit == VPUStallUnit::Upper ? "upper" : "lower")
+        << "\",\"register\":\"" << stallRegisterName(reason)
+        << "\",\"blocking_instruction_address\":"
+        << reason.blockingInstructionAddress
+        << ",\"cycles\":" << row.stallCauses[cause].cycles << "}";
+    }
+    output << "]}";
+  }
+  output << "]}\n";
+}
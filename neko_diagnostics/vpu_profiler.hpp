@@ -0,0 +1,77 @@
+#ifndef VPU_PROFILER_H
+#define VPU_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "vpu_program_runner.hpp"
+
+struct VPUProfileStallCause
+{
+  VPUStallReason reason = {};
+  std::uint64_t cycles = 0;
+};
+
+struct VPUProfileRow
+{
+  std::uint16_t instructionAddress = 0;
+  std::uint64_t executions = 0;
+  std::uint64_t stallCycles = 0;
+  std::uint64_t writebacks = 0;
+  bool dualIssue = false;
+  std::string disassembly;
+  std::vector<VPUProfileStallCause> stallCauses;
+};
+
+struct VPUProfileReport
+{
+  std::uint64_t issueCycles = 0;
+  std::uint64_t stallCycles = 0;
+  std::uint64_t dualIssueCycles = 0;
+  std::vector<VPUProfileRow> rows;
+};
+
+struct VPUProfilerOptions
+{
+  // Counts stalls per blocking register and lane. Costs a hazard lookup in the
+  // VU and a map update per stall, so it is off by default.
+  bool collectStallCauses = false;
+};
+
+// Counts trace events per instruction pair. Recording an event is a single
+// counter increment; decoding and disassembly happen only in report().
+class VPUProfiler
+{
+  public:
+    explicit VPUProfiler(
+      std::size_t microMemorySize,
+      const VPUProfilerOptions &options = VPUProfilerOptions());
+    bool collectsStallCauses() const;
+    void record(const VPUTraceEvent &event);
+    void clear();
+    VPUProfileReport report(
+      const std::vector<std::uint8_t> &microProgram) const;
+
+  private:
+    std::vector<std::uint64_t> counters;
+    std::map<std::uint64_t, std::uint64_t> stallCauses;
+    std::size_t addressMask;
+    bool collectStallCauses;
+
+    std::uint64_t counter(std::size_t pair, VPUTraceEventType type) const;
+};
+
+// Runs the program like runVPUProgram with the profiler recording every event.
+VPUProgramRunResult profileVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  VPUProfiler *profiler);
+
+void writeVPUProfileText(std::ostream &output, const VPUProfileReport &report);
+void writeVPUProfileJson(std::ostream &output, const VPUProfileReport &report);
+
+#endif
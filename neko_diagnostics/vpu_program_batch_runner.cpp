@@ -0,0 +1,251 @@
+#include "vpu_program_batch_runner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+  struct BatchJobView
+  {
+    VPUType type;
+    const VPUProgramRunConfig *config;
+    const std::vector<VPUDataMemoryWrite> *inputMemory;
+  };
+
+  class WorkQueue
+  {
+    public:
+      void push(std::size_t job)
+      {
+        jobs.push_back(job);
+      }
+
+      bool popFront(std::size_t *job)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty())
+        {
+          return false;
+        }
+
+        *job = jobs.front();
+        jobs.pop_front();
+        return true;
+      }
+
+      bool stealBack(std::size_t *job)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty())
+        {
+          return false;
+        }
+
+        *job = jobs.back();
+        jobs.pop_back();
+        return true;
+      }
+
+    private:
+      std::mutex mutex;
+      std::deque<std::size_t> jobs;
+  };
+
+  class BatchWorker
+  {
+    public:
+      BatchWorker(
+        std::size_t index,
+        std::vector<WorkQueue> *queues,
+        const std::vector<BatchJobView> *jobs,
+        std::vector<VPUProgramRunResult> *results,
+        std::vector<std::exception_ptr> *errors,
+        std::vector<std::ostringstream> *traceOutputs) :
+        index(index),
+        queues(queues),
+        jobs(jobs),
+        results(results),
+        errors(errors),
+        traceOutputs(traceOutputs)
+      {
+      }
+
+      void run()
+      {
+        std::size_t job;
+        while (nextJob(&job))
+        {
+          try
+          {
+            const BatchJobView &view = (*jobs)[job];
+            VPU *vpu = vpuFor(view.type, view.config->microProgram);
+            if (view.config->traceOutput == nullptr)
+            {
+              (*results)[job] =
+                runVPUProgram(vpu, *view.config, *view.inputMemory);
+              continue;
+            }
+
+            VPUProgramRunConfig config = *view.config;
+            config.traceOutput = &(*traceOutputs)[job];
+            (*results)[job] = runVPUProgram(vpu, config, *view.inputMemory);
+          }
+          catch (...)
+          {
+            (*errors)[job] = std::current_exception();
+          }
+        }
+      }
+
+    private:
+      std::size_t index;
+      std::vector<WorkQueue> *queues;
+      const std::vector<BatchJobView> *jobs;
+      std::vector<VPUProgramRunResult> *results;
+      std::vector<std::exception_ptr> *errors;
+      std::vector<std::ostringstream> *traceOutputs;
+      std::array<std::unique_ptr<VPU>, 2> vpus;
+      std::array<const std::vector<std::uint8_t> *, 2> loadedPrograms = {};
+
+      bool nextJob(std::size_t *job)
+      {
+        if ((*queues)[index].popFront(job))
+        {
+          return true;
+        }
+
+        for (std::size_t offset = 1; offset < queues->size(); offset++)
+        {
+          std::size_t victim = (index + offset) % queues->size();
+          if ((*queues)[victim].stealBack(job))
+          {
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      VPU *vpuFor(VPUType type, const std::vector<std::uint8_t> &program)
+      {
+        std::size_t slot = static_cast<std::size_t>(type);
+        std::unique_ptr<VPU> &vpu = vpus[slot];
+        if (!vpu)
+        {
+          vpu.reset(new VPU(type));
+        }
+        else
+        {
+          VPUResetOptions options;
+          options.keepMicroMemory =
+            loadedPrograms[slot] == &program ||
+            *loadedPrograms[slot] == program;
+          vpu->reset(options);
+        }
+
+        loadedPrograms[slot] = &program;
+        return vpu.get();
+      }
+  };
+
+  std::vector<VPUProgramRunResult> runBatch(
+    const std::vector<BatchJobView> &jobs,
+    const VPUProgramBatchOptions &options)
+  {
+    std::vector<VPUProgramRunResult> results(jobs.size());
+    std::vector<std::exception_ptr> errors(jobs.size());
+    std::vector<std::ostringstream> traceOutputs(jobs.size());
+    if (jobs.empty())
+    {
+      return results;
+    }
+
+    std::size_t workerCount = options.workerCount;
+    if (workerCount == 0)
+    {
+      workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workerCount = std::min(workerCount, jobs.size());
+
+    std::vector<WorkQueue> queues(workerCount);
+    for (std::size_t job = 0; job < jobs.size(); job++)
+    {
+      queues[job * workerCount / jobs.size()].push(job);
+    }
+
+    std::vector<BatchWorker> workers;
+    workers.reserve(workerCount);
+    for (std::size_t worker = 0; worker < workerCount; worker++)
+    {
+      workers.emplace_back(
+        worker, &queues, &jobs, &results, &errors, &traceOutputs);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (std::size_t worker = 1; worker < workerCount; worker++)
+    {
+      threads.emplace_back(&BatchWorker::run, &workers[worker]);
+    }
+    workers[0].run();
+    for (std::thread &thread : threads)
+    {
+      thread.join();
+    }
+
+    for (std::size_t job = 0; job < jobs.size(); job++)
+    {
+      if (jobs[job].config->traceOutput != nullptr)
+      {
+        *jobs[job].config->traceOutput << traceOutputs[job].str();
+      }
+    }
+
+    for (const std::exception_ptr &error : errors)
+    {
+      if (error)
+      {
+        std::rethrow_exception(error);
+      }
+    }
+
+    return results;
+  }
+}
+
+std::vector<VPUProgramRunResult> runVPUProgramBatch(
+  const std::vector<VPUProgramBatchJob> &jobs,
+  const VPUProgramBatchOptions &options)
+{
+  std::vector<BatchJobView> views;
+  views.reserve(jobs.size());
+  for (const VPUProgramBatchJob &job : jobs)
+  {
+    views.push_back({job.type, &job.config, &job.config.inputMemory});
+  }
+
+  return runBatch(views, options);
+}
+
+std::vector<VPUProgramRunResult> runVPUProgramBatch(
+  VPUType type,
+  const VPUProgramRunConfig &program,
+  const std::vector<std::vector<VPUDataMemoryWrite>> &inputSets,
+  const VPUProgramBatchOptions &options)
+{
+  std::vector<BatchJobView> views;
+  views.reserve(inputSets.size());
+  for (const std::vector<VPUDataMemoryWrite> &inputMemory : inputSets)
+  {
+    views.push_back({type, &program, &inputMemory});
+  }
+
+  return runBatch(views, options);
+}
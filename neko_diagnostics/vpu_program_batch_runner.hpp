@@ -0,0 +1,33 @@
+#ifndef VPU_PROGRAM_BATCH_RUNNER_H
+#define VPU_PROGRAM_BATCH_RUNNER_H
+
+#include <vector>
+
+#include "vpu_program_runner.hpp"
+
+struct VPUProgramBatchJob
+{
+  VPUType type = VPUType::VU0;
+  VPUProgramRunConfig config;
+};
+
+struct VPUProgramBatchOptions
+{
+  unsigned int workerCount = 0;
+};
+
+// Results are returned in job order. When jobs throw, the exception from the
+// lowest-numbered failing job is rethrown after every worker has finished.
+// Each job traces into its own buffer; the buffers are written to the jobs'
+// trace outputs in job order once every worker has finished.
+std::vector<VPUProgramRunResult> runVPUProgramBatch(
+  const std::vector<VPUProgramBatchJob> &jobs,
+  const VPUProgramBatchOptions &options = VPUProgramBatchOptions());
+
+std::vector<VPUProgramRunResult> runVPUProgramBatch(
+  VPUType type,
+  const VPUProgramRunConfig &program,
+  const std::vector<std::vector<VPUDataMemoryWrite>> &inputSets,
+  const VPUProgramBatchOptions &options = VPUProgramBatchOptions());
+
+#endif
@@ -1,8 +1,15 @@
 #include "vpu_program_runner.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <ostream>
 #include <stdexcept>
 
+#include "vpu_async_trace_writer.hpp"
+#include "vpu_binary_trace.hpp"
+#include "vpu_trace_output.hpp"
+#include "vpu_trace_ring_buffer.hpp"
+
 namespace
 {
   const char *traceEventTypeName(VPUTraceEventType type)
@@ -22,6 +29,26 @@ namespace
     throw std::invalid_argument("Unknown VU trace event type.");
   }
 
+  const char *stallUnitName(VPUStallUnit unit)
+  {
+    return unit == VPUStallUnit::Upper ? "upper" : "lower";
+  }
+
+  const char *stallRegisterClassName(VPUStallRegisterClass registerClass)
+  {
+    switch (registerClass)
+    {
+      case VPUStallRegisterClass::Float:
+        return "float";
+      case VPUStallRegisterClass::Integer:
+        return "integer";
+      case VPUStallRegisterClass::None:
+        break;
+    }
+
+    return "none";
+  }
+
   class TraceCallbackReset
   {
     public:
@@ -43,60 +70,259 @@ namespace
       VPU *vpu;
       bool enabled;
   };
-}
 
-VPUProgramRunResult runVPUProgram(
-  VPU *vpu,
-  const VPUProgramRunConfig &config)
-{
-  if (vpu == nullptr)
-  {
-    throw std::invalid_argument("VPU program runner requires a VPU.");
-  }
-  if (config.traceStartCycle > config.traceEndCycle)
+  void validateRunConfig(VPU *vpu, const VPUProgramRunConfig &config)
   {
-    throw std::invalid_argument(
-      "VU trace start cycle cannot exceed its end cycle.");
+    if (vpu == nullptr)
+    {
+      throw std::invalid_argument("VPU program runner requires a VPU.");
+    }
+    if (config.traceStartCycle > config.traceEndCycle)
+    {
+      throw std::invalid_argument(
+        "VU trace start cycle cannot exceed its end cycle.");
+    }
   }
 
-  VPUProgramRunResult result;
-  bool traceEnabled = config.captureTrace || config.traceOutput != nullptr;
-  TraceCallbackReset traceCallbackReset(vpu, traceEnabled);
-  if (traceEnabled)
+  class TraceCapture
   {
-    vpu->setTraceCallback(
-      [&config, &result](const VPUTraceEvent &event) {
+    public:
+      TraceCapture(
+        VPU *vpu,
+        const VPUProgramRunConfig &config,
+        VPUProgramRunResult *result) :
+        config(config),
+        result(result)
+      {
+        if (!config.captureTrace && config.traceOutput == nullptr)
+        {
+          return;
+        }
+
+        if (config.captureTrace && config.traceCapacity != 0)
+        {
+          ring.reset(new VPUTraceRingBuffer(config.traceCapacity));
+        }
+        VPUBinaryTraceHeader header;
+        header.type = vpu->unitType();
+        header.programHash = hashVPUProgram(config.microProgram);
+        if (config.traceOutput != nullptr && config.asyncTraceOutput)
+        {
+          VPUAsyncTraceWriterOptions options;
+          options.queueCapacity = config.asyncTraceQueueCapacity;
+          options.backpressure = config.traceBackpressure;
+          options.format = config.traceOutputFormat;
+          asyncWriter.reset(
+            new VPUAsyncTraceWriter(config.traceOutput, options, header));
+        }
+        else if (config.traceOutput != nullptr)
+        {
+          output.reset(new VPUTraceOutput(
+            config.traceOutput, config.traceOutputFormat, header));
+        }
+
+        vpu->setTraceCallback([this](const VPUTraceEvent &event) {
+          record(event);
+        }, config.traceStallReasons);
+      }
+
+      void finish()
+      {
+        if (asyncWriter)
+        {
+          asyncWriter->finish();
+          result->droppedTraceOutputEvents = asyncWriter->droppedEvents();
+        }
+        if (output)
+        {
+          output->finish();
+        }
+        if (ring)
+        {
+          result->traceEvents = ring->events();
+          result->droppedTraceEvents = ring->droppedEvents();
+        }
+      }
+
+    private:
+      const VPUProgramRunConfig &config;
+      VPUProgramRunResult *result;
+      std::unique_ptr<VPUTraceRingBuffer> ring;
+      std::unique_ptr<VPUTraceOutput> output;
+      std::unique_ptr<VPUAsyncTraceWriter> asyncWriter;
+
+      void record(const VPUTraceEvent &event)
+      {
         if (event.cycle < config.traceStartCycle ||
             event.cycle > config.traceEndCycle)
         {
           return;
         }
-        if (config.captureTrace)
+        if (ring)
+        {
+          ring->push(event);
+        }
+        else if (config.captureTrace)
+        {
+          result->traceEvents.push_back(event);
+        }
+        if (asyncWriter)
         {
-          result.traceEvents.push_back(event);
+          asyncWriter->write(event);
         }
-        if (config.traceOutput != nullptr)
+        else if (output)
         {
-          writeVPUTraceEventJsonLine(*config.traceOutput, event);
+          output->write(event);
         }
-      });
+      }
+  };
+
+  void captureRunResult(
+    const VPU &vpu,
+    const VPUProgramRunConfig &config,
+    VPUProgramRunResult *result)
+  {
+    result->state = vpu.getState();
+    result->programCounter = vpu.programCounter();
+    result->elapsedCycles = vpu.elapsedCycles();
+    result->hasTerminationPosition = vpu.hasTerminationPosition();
+    if (result->hasTerminationPosition)
+    {
+      result->terminationPosition = vpu.terminationPosition();
+    }
+    result->outputMemory =
+      vpu.readDataMemory(config.outputAddress, config.outputSize);
   }
+}
 
+VPUProgramRunResult runVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config)
+{
+  return runVPUProgram(vpu, config, config.inputMemory);
+}
+
+VPUProgramRunResult runVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  const std::vector<VPUDataMemoryWrite> &inputMemory)
+{
+  validateRunConfig(vpu, config);
+
+  VPUProgramRunResult result;
+  bool traceEnabled = config.captureTrace || config.traceOutput != nullptr;
+  TraceCapture traceCapture(vpu, config, &result);
+  TraceCallbackReset traceCallbackReset(vpu, traceEnabled);
+
+  startVPUProgram(vpu, config, inputMemory);
+  vpu->run(config.cycleBudget);
+
+  traceCapture.finish();
+  captureRunResult(*vpu, config, &result);
+  return result;
+}
+
+void startVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  const std::vector<VPUDataMemoryWrite> &inputMemory)
+{
   vpu->uploadMicroInstructions(config.microProgram);
+  for (const VPUDataMemoryWrite &write : inputMemory)
+  {
+    vpu->writeDataMemory(write.address, write.data);
+  }
   vpu->resetCycles();
   vpu->startMicroMode(config.startAddress);
-  vpu->run(config.cycleBudget);
+}
 
-  result.state = vpu->getState();
-  result.programCounter = vpu->programCounter();
-  result.elapsedCycles = vpu->elapsedCycles();
-  result.hasTerminationPosition = vpu->hasTerminationPosition();
-  if (result.hasTerminationPosition)
+VPUProgramRunResult recordVPUProgramCheckpoints(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  std::uint32_t checkpointInterval,
+  std::vector<VPUProgramCheckpoint> *checkpoints)
+{
+  validateRunConfig(vpu, config);
+  if (checkpointInterval == 0)
+  {
+    throw std::invalid_argument(
+      "VU checkpoint interval must be greater than zero.");
+  }
+  if (checkpoints == nullptr)
   {
-    result.terminationPosition = vpu->terminationPosition();
+    throw std::invalid_argument(
+      "VU checkpoint recording requires a checkpoint list.");
   }
-  result.outputMemory =
-    vpu->readDataMemory(config.outputAddress, config.outputSize);
+
+  checkpoints->clear();
+  std::uint64_t programHash = hashVPUProgram(config.microProgram);
+  startVPUProgram(vpu, config, config.inputMemory);
+
+  std::uint32_t remainingCycles = config.cycleBudget;
+  while (true)
+  {
+    checkpoints->emplace_back();
+    checkpoints->back().cycle = vpu->elapsedCycles();
+    checkpoints->back().programHash = programHash;
+    vpu->saveState(&checkpoints->back().state);
+    if (vpu->getState() != VPU_STATE_RUN || remainingCycles == 0)
+    {
+      break;
+    }
+
+    remainingCycles -=
+      vpu->run(std::min(checkpointInterval, remainingCycles));
+  }
+
+  VPUProgramRunResult result;
+  captureRunResult(*vpu, config, &result);
+  return result;
+}
+
+VPUProgramRunResult replayVPUTraceWindow(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  const std::vector<VPUProgramCheckpoint> &checkpoints)
+{
+  validateRunConfig(vpu, config);
+
+  auto checkpoint = std::upper_bound(
+    checkpoints.begin(),
+    checkpoints.end(),
+    config.traceStartCycle,
+    [](std::uint64_t cycle, const VPUProgramCheckpoint &candidate) {
+      return cycle < candidate.cycle;
+    });
+  if (checkpoint == checkpoints.begin())
+  {
+    throw std::invalid_argument(
+      "No VU checkpoint precedes the trace window.");
+  }
+  checkpoint--;
+  if (checkpoint->programHash != hashVPUProgram(config.microProgram))
+  {
+    throw std::invalid_argument(
+      "VU checkpoints were recorded for a different program.");
+  }
+
+  VPUProgramRunResult result;
+  bool traceEnabled = config.captureTrace || config.traceOutput != nullptr;
+  vpu->loadState(checkpoint->state);
+  TraceCapture traceCapture(vpu, config, &result);
+  TraceCallbackReset traceCallbackReset(vpu, traceEnabled);
+
+  std::uint64_t stopCycle = config.cycleBudget;
+  if (config.traceEndCycle < stopCycle)
+  {
+    stopCycle = config.traceEndCycle + 1;
+  }
+  if (stopCycle > checkpoint->cycle)
+  {
+    vpu->run(static_cast<std::uint32_t>(stopCycle - checkpoint->cycle));
+  }
+
+  traceCapture.finish();
+  captureRunResult(*vpu, config, &result);
   return result;
 }
 
@@ -114,6 +340,19 @@ void writeVPUTraceEventJsonLine(
     << ",\"destination_register\":"
     << static_cast<unsigned int>(event.destinationRegister)
     << ",\"destination_field_mask\":"
-    << static_cast<unsigned int>(event.destinationFieldMask)
-    << "}\n";
+    << static_cast<unsigned int>(event.destinationFieldMask);
+  if (event.stallReason.unit != VPUStallUnit::None)
+  {
+    output
+      << ",\"stall_unit\":\"" << stallUnitName(event.stallReason.unit)
+      << "\",\"stall_register_class\":\""
+      << stallRegisterClassName(event.stallReason.registerClass)
+      << "\",\"stall_register\":"
+      << static_cast<unsigned int>(event.stallReason.registerID)
+      << ",\"stall_field_mask\":"
+      << static_cast<unsigned int>(event.stallReason.fieldMask)
+      << ",\"blocking_instruction_address\":"
+      << event.stallReason.blockingInstructionAddress;
+  }
+  output << "}\n";
 }
@@ -9,34 +9,100 @@
 
 #include "vpu.hpp"
 
+struct VPUDataMemoryWrite
+{
+  std::size_t address = 0;
+  std::vector<std::uint8_t> data;
+};
+
+enum class VPUTraceOutputFormat : std::uint8_t
+{
+  JsonLines,
+  Binary,
+  Compressed
+};
+
+enum class VPUTraceBackpressure : std::uint8_t
+{
+  Block,
+  Drop
+};
+
 struct VPUProgramRunConfig
 {
   std::vector<std::uint8_t> microProgram;
+  std::vector<VPUDataMemoryWrite> inputMemory;
   std::uint16_t startAddress = 0;
   std::uint32_t cycleBudget = 0;
   std::size_t outputAddress = 0;
   std::size_t outputSize = 0;
   bool captureTrace = false;
-  std::uint32_t traceStartCycle = 0;
-  std::uint32_t traceEndCycle = std::numeric_limits<std::uint32_t>::max();
+  std::uint64_t traceStartCycle = 0;
+  std::uint64_t traceEndCycle = std::numeric_limits<std::uint64_t>::max();
+  // Stall events carry their cause only when asked; it costs a hazard lookup.
+  bool traceStallReasons = false;
+  // Zero keeps every captured event; otherwise only the most recent ones.
+  std::size_t traceCapacity = 0;
   std::ostream *traceOutput = nullptr;
+  VPUTraceOutputFormat traceOutputFormat = VPUTraceOutputFormat::JsonLines;
+  // Moves trace output formatting onto a writer thread fed by a bounded queue.
+  bool asyncTraceOutput = false;
+  std::size_t asyncTraceQueueCapacity = 4096;
+  VPUTraceBackpressure traceBackpressure = VPUTraceBackpressure::Block;
 };
 
 struct VPUProgramRunResult
 {
   std::uint8_t state = VPU_STATE_READY;
   std::uint16_t programCounter = 0;
-  std::uint32_t elapsedCycles = 0;
+  std::uint64_t elapsedCycles = 0;
   bool hasTerminationPosition = false;
   std::uint16_t terminationPosition = 0;
   std::vector<std::uint8_t> outputMemory;
   std::vector<VPUTraceEvent> traceEvents;
+  std::uint64_t droppedTraceEvents = 0;
+  std::uint64_t droppedTraceOutputEvents = 0;
+};
+
+struct VPUProgramCheckpoint
+{
+  std::uint64_t cycle = 0;
+  std::uint64_t programHash = 0;
+  std::vector<std::uint8_t> state;
 };
 
 VPUProgramRunResult runVPUProgram(
   VPU *vpu,
   const VPUProgramRunConfig &config);
 
+VPUProgramRunResult runVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  const std::vector<VPUDataMemoryWrite> &inputMemory);
+
+// Uploads the program and its inputs and starts it without running a cycle.
+void startVPUProgram(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  const std::vector<VPUDataMemoryWrite> &inputMemory);
+
+// Runs the program without tracing and saves the VPU every checkpointInterval
+// cycles. The first checkpoint is the started program at cycle 0 and the last
+// is the VPU when the run stops.
+VPUProgramRunResult recordVPUProgramCheckpoints(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  std::uint32_t checkpointInterval,
+  std::vector<VPUProgramCheckpoint> *checkpoints);
+
+// Restores the last checkpoint at or before traceStartCycle and runs only until
+// the trace window closes. The result describes the VPU at that point.
+// Checkpoints recorded for a different micro program are rejected.
+VPUProgramRunResult replayVPUTraceWindow(
+  VPU *vpu,
+  const VPUProgramRunConfig &config,
+  const std::vector<VPUProgramCheckpoint> &checkpoints);
+
 void writeVPUTraceEventJsonLine(
   std::ostream &output,
   const VPUTraceEvent &event);
@@ -0,0 +1,491 @@
+#include "vpu_trace_codec.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include "save_state.hpp"
+
+#define VPU_TRACE_TAG_TYPE_MASK 0x03
+#define VPU_TRACE_TAG_UPPER_REFERENCE 0x04
+#define VPU_TRACE_TAG_LOWER_REFERENCE 0x08
+#define VPU_TRACE_TAG_SAME_OPERANDS 0x10
+#define VPU_TRACE_TAG_SEQUENTIAL_ADDRESS 0x20
+#define VPU_TRACE_TAG_STALL_REASON 0x40
+#define VPU_TRACE_ENCODER_FLUSH_SIZE 0x10000
+
+namespace
+{
+  const char traceMagic[4] = {'N', 'K', 'T', 'Z'};
+  const char indexMagic[4] = {'N', 'K', 'T', 'I'};
+
+  std::uint64_t zigzagEncode(std::int64_t value)
+  {
+    return (static_cast<std::uint64_t>(value) << 1) ^
+      static_cast<std::uint64_t>(value >> 63);
+  }
+
+  std::int64_t zigzagDecode(std::uint64_t value)
+  {
+    return static_cast<std::int64_t>(value >> 1) ^
+      -static_cast<std::int64_t>(value & 1);
+  }
+
+  bool sameOperands(const VPUTraceEvent &left, const VPUTraceEvent &right)
+  {
+    return left.opCode == right.opCode &&
+      left.destinationRegister == right.destinationRegister &&
+      left.destinationFieldMask == right.destinationFieldMask;
+  }
+
+  void corruptBlock()
+  {
+    throw std::runtime_error("VU compressed trace block is corrupt.");
+  }
+
+  void invalidIndex()
+  {
+    throw std::runtime_error("VU compressed trace has an invalid index.");
+  }
+}
+
+VPUTraceEncoder::VPUTraceEncoder(
+  std::ostream *output,
+  const VPUBinaryTraceHeader &header,
+  std::uint32_t blockEventCount) :
+  output(output),
+  blockEventCount(blockEventCount),
+  previous()
+{
+  if (output == nullptr)
+  {
+    throw std::invalid_argument("VU trace encoder requires an output.");
+  }
+  if (blockEventCount == 0)
+  {
+    throw std::invalid_argument(
+      "VU compressed trace blocks must hold at least one event.");
+  }
+
+  buffer.assign(traceMagic, traceMagic + 4);
+  SaveStateWriter writer(&buffer);
+  writer.writeU16(VPU_COMPRESSED_TRACE_VERSION);
+  writer.writeU8(static_cast<std::uint8_t>(header.type));
+  writer.writeU8(0);
+  writer.writeU32(blockEventCount);
+  writer.writeU64(header.programHash);
+  buffer.reserve(VPU_TRACE_ENCODER_FLUSH_SIZE + 64);
+}
+
+void VPUTraceEncoder::write(const VPUTraceEvent &event)
+{
+  if (finished)
+  {
+    throw std::logic_error("VU compressed trace has already been finished.");
+  }
+
+  if (eventCount % blockEventCount == 0)
+  {
+    index.push_back(bytesWritten + buffer.size());
+    index.push_back(event.cycle);
+    dictionary.clear();
+    previous = VPUTraceEvent();
+  }
+
+  bool upperReference = dictionary.count(event.upperInstruction) != 0;
+  bool lowerReference = dictionary.count(event.lowerInstruction) != 0 ||
+    (!upperReference && event.lowerInstruction == event.upperInstruction);
+  bool sequentialAddress = event.instructionAddress ==
+    static_cast<std::uint16_t>(previous.instructionAddress + 8);
+  bool repeatedOperands = sameOperands(event, previous);
+  bool stallReason = event.stallReason.unit != VPUStallUnit::None;
+
+  std::uint8_t tag = static_cast<std::uint8_t>(event.type) &
+    VPU_TRACE_TAG_TYPE_MASK;
+  tag |= upperReference ? VPU_TRACE_TAG_UPPER_REFERENCE : 0;
+  tag |= lowerReference ? VPU_TRACE_TAG_LOWER_REFERENCE : 0;
+  tag |= repeatedOperands ? VPU_TRACE_TAG_SAME_OPERANDS : 0;
+  tag |= sequentialAddress ? VPU_TRACE_TAG_SEQUENTIAL_ADDRESS : 0;
+  tag |= stallReason ? VPU_TRACE_TAG_STALL_REASON : 0;
+  buffer.push_back(tag);
+
+  writeVarint(zigzagEncode(
+    static_cast<std::int64_t>(event.cycle) -
+    static_cast<std::int64_t>(previous.cycle)));
+  if (!sequentialAddress)
+  {
+    writeVarint(zigzagEncode(
+      static_cast<std::int64_t>(event.instructionAddress) -
+      static_cast<std::int64_t>(previous.instructionAddress)));
+  }
+  writeInstructionWord(event.upperInstruction);
+  writeInstructionWord(event.lowerInstruction);
+  if (!repeatedOperands)
+  {
+    writeVarint(event.opCode);
+    buffer.push_back(event.destinationRegister);
+    buffer.push_back(event.destinationFieldMask);
+  }
+  if (stallReason)
+  {
+    buffer.push_back(static_cast<std::uint8_t>(event.stallReason.unit));
+    buffer.push_back(
+      static_cast<std::uint8_t>(event.stallReason.registerClass));
+    buffer.push_back(event.stallReason.registerID);
+    buffer.push_back(event.stallReason.fieldMask);
+    writeVarint(event.stallReason.blockingInstructionAddress);
+  }
+
+  previous = event;
+  eventCount++;
+  if (buffer.size() >= VPU_TRACE_ENCODER_FLUSH_SIZE)
+  {
+    flush();
+  }
+}
+
+void VPUTraceEncoder::finish()
+{
+  if (finished)
+  {
+    return;
+  }
+
+  std::uint64_t indexOffset = bytesWritten + buffer.size();
+  SaveStateWriter writer(&buffer);
+  for (std::uint64_t entry : index)
+  {
+    writer.writeU64(entry);
+  }
+  writer.writeU64(indexOffset);
+  writer.writeU64(eventCount);
+  buffer.insert(buffer.end(), indexMagic, indexMagic + 4);
+  flush();
+  finished = true;
+}
+
+void VPUTraceEncoder::flush()
+{
+  output->write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+  bytesWritten += buffer.size();
+  buffer.clear();
+}
+
+void VPUTraceEncoder::writeVarint(std::uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+void VPUTraceEncoder::writeInstructionWord(std::uint32_t word)
+{
+  auto entry = dictionary.find(word);
+  if (entry != dictionary.end())
+  {
+    writeVarint(entry->second);
+    return;
+  }
+
+  std::uint32_t dictionaryIndex = static_cast<std::uint32_t>(dictionary.size());
+  dictionary.emplace(word, dictionaryIndex);
+  SaveStateWriter writer(&buffer);
+  writer.writeU32(word);
+}
+
+VPUTraceDecoder::VPUTraceDecoder(std::istream *input) :
+  input(input),
+  previous()
+{
+  if (input == nullptr)
+  {
+    throw std::invalid_argument("VU trace decoder requires an input.");
+  }
+
+  std::uint8_t header[VPU_COMPRESSED_TRACE_HEADER_SIZE];
+  input->read(reinterpret_cast<char *>(header), sizeof(header));
+  if (input->gcount() != VPU_COMPRESSED_TRACE_HEADER_SIZE ||
+    !std::equal(traceMagic, traceMagic + 4, header))
+  {
+    throw std::runtime_error("VU compressed trace has an invalid header.");
+  }
+
+  SaveStateReader headerReader(header + 4, sizeof(header) - 4);
+  if (headerReader.readU16() != VPU_COMPRESSED_TRACE_VERSION)
+  {
+    throw std::runtime_error("Unsupported VU compressed trace version.");
+  }
+  std::uint8_t type = headerReader.readU8();
+  headerReader.readU8();
+  eventsPerBlock = headerReader.readU32();
+  if (type > static_cast<std::uint8_t>(VPUType::VU1) || eventsPerBlock == 0)
+  {
+    throw std::runtime_error("VU compressed trace has an invalid header.");
+  }
+  traceHeader.type = static_cast<VPUType>(type);
+  traceHeader.programHash = headerReader.readU64();
+
+  input->seekg(0, std::ios::end);
+  std::streamoff size = input->tellg();
+  if (size < VPU_COMPRESSED_TRACE_HEADER_SIZE +
+    VPU_COMPRESSED_TRACE_FOOTER_SIZE)
+  {
+    invalidIndex();
+  }
+
+  std::uint8_t footer[VPU_COMPRESSED_TRACE_FOOTER_SIZE];
+  input->seekg(size - VPU_COMPRESSED_TRACE_FOOTER_SIZE);
+  input->read(reinterpret_cast<char *>(footer), sizeof(footer));
+  if (input->gcount() != VPU_COMPRESSED_TRACE_FOOTER_SIZE ||
+    !std::equal(indexMagic, indexMagic + 4, footer + 16))
+  {
+    invalidIndex();
+  }
+
+  SaveStateReader footerReader(footer, 16);
+  indexOffset = footerReader.readU64();
+  totalEvents = footerReader.readU64();
+  std::uint64_t blockCount =
+    totalEvents / eventsPerBlock + (totalEvents % eventsPerBlock != 0);
+  std::uint64_t indexEnd =
+    static_cast<std::uint64_t>(size) - VPU_COMPRESSED_TRACE_FOOTER_SIZE;
+  if (indexOffset < VPU_COMPRESSED_TRACE_HEADER_SIZE ||
+    indexOffset > indexEnd ||
+    (indexEnd - indexOffset) / VPU_COMPRESSED_TRACE_INDEX_ENTRY_SIZE !=
+      blockCount ||
+    (indexEnd - indexOffset) % VPU_COMPRESSED_TRACE_INDEX_ENTRY_SIZE != 0)
+  {
+    invalidIndex();
+  }
+
+  std::vector<std::uint8_t> index(indexEnd - indexOffset);
+  input->seekg(indexOffset);
+  input->read(reinterpret_cast<char *>(index.data()), index.size());
+  if (static_cast<std::uint64_t>(input->gcount()) != index.size())
+  {
+    invalidIndex();
+  }
+  SaveStateReader indexReader(index.data(), index.size());
+  std::uint64_t expectedOffset = VPU_COMPRESSED_TRACE_HEADER_SIZE;
+  for (std::uint64_t block = 0; block < blockCount; block++)
+  {
+    std::uint64_t offset = indexReader.readU64();
+    if (offset < expectedOffset || offset >= indexOffset ||
+      (block == 0 && offset != VPU_COMPRESSED_TRACE_HEADER_SIZE))
+    {
+      invalidIndex();
+    }
+    blockOffsets.push_back(offset);
+    blockCycles.push_back(indexReader.readU64());
+    expectedOffset = offset + 1;
+  }
+}
+
+const VPUBinaryTraceHeader &VPUTraceDecoder::header() const
+{
+  return traceHeader;
+}
+
+std::uint32_t VPUTraceDecoder::blockEventCount() const
+{
+  return eventsPerBlock;
+}
+
+std::uint64_t VPUTraceDecoder::eventCount() const
+{
+  return totalEvents;
+}
+
+std::uint64_t VPUTraceDecoder::position() const
+{
+  return nextEvent;
+}
+
+bool VPUTraceDecoder::read(VPUTraceEvent *event)
+{
+  if (nextEvent == totalEvents)
+  {
+    return false;
+  }
+  if (nextEvent % eventsPerBlock == 0)
+  {
+    loadBlock(nextEvent / eventsPerBlock);
+  }
+
+  std::uint8_t tag = readByte();
+  if (tag & ~(VPU_TRACE_TAG_TYPE_MASK | VPU_TRACE_TAG_UPPER_REFERENCE |
+    VPU_TRACE_TAG_LOWER_REFERENCE | VPU_TRACE_TAG_SAME_OPERANDS |
+    VPU_TRACE_TAG_SEQUENTIAL_ADDRESS | VPU_TRACE_TAG_STALL_REASON))
+  {
+    corruptBlock();
+  }
+
+  event->type = static_cast<VPUTraceEventType>(tag & VPU_TRACE_TAG_TYPE_MASK);
+  event->cycle = previous.cycle + zigzagDecode(readVarint());
+  if (tag & VPU_TRACE_TAG_SEQUENTIAL_ADDRESS)
+  {
+    event->instructionAddress =
+      static_cast<std::uint16_t>(previous.instructionAddress + 8);
+  }
+  else
+  {
+    event->instructionAddress = static_cast<std::uint16_t>(
+      previous.instructionAddress + zigzagDecode(readVarint()));
+  }
+  event->upperInstruction =
+    readInstructionWord((tag & VPU_TRACE_TAG_UPPER_REFERENCE) != 0);
+  event->lowerInstruction =
+    readInstructionWord((tag & VPU_TRACE_TAG_LOWER_REFERENCE) != 0);
+  if (tag & VPU_TRACE_TAG_SAME_OPERANDS)
+  {
+    event->opCode = previous.opCode;
+    event->destinationRegister = previous.destinationRegister;
+    event->destinationFieldMask = previous.destinationFieldMask;
+  }
+  else
+  {
+    std::uint64_t opCode = readVarint();
+    if (opCode > 0xffff)
+    {
+      corruptBlock();
+    }
+    event->opCode = static_cast<std::uint16_t>(opCode);
+    event->destinationRegister = readByte();
+    event->destinationFieldMask = readByte();
+  }
+  event->stallReason = VPUStallReason();
+  if (tag & VPU_TRACE_TAG_STALL_REASON)
+  {
+    readStallReason(&event->stallReason);
+  }
+
+  previous = *event;
+  nextEvent++;
+  return true;
+}
+
+void VPUTraceDecoder::seek(std::uint64_t eventIndex)
+{
+  if (eventIndex > totalEvents)
+  {
+    throw std::out_of_range("VU compressed trace event is out of range.");
+  }
+
+  nextEvent = eventIndex - eventIndex % eventsPerBlock;
+  VPUTraceEvent event;
+  while (nextEvent < eventIndex)
+  {
+    read(&event);
+  }
+}
+
+void VPUTraceDecoder::seekCycle(std::uint64_t cycle)
+{
+  auto block = std::lower_bound(blockCycles.begin(), blockCycles.end(), cycle);
+  std::uint64_t blockIndex =
+    block == blockCycles.begin() ? 0 : block - blockCycles.begin() - 1;
+
+  std::uint64_t target = blockIndex * eventsPerBlock;
+  nextEvent = std::min(target, totalEvents);
+  VPUTraceEvent event;
+  while (read(&event) && event.cycle < cycle)
+  {
+    target++;
+  }
+
+  seek(std::min(target, totalEvents));
+}
+
+void VPUTraceDecoder::loadBlock(std::size_t blockIndex)
+{
+  std::uint64_t start = blockOffsets[blockIndex];
+  std::uint64_t end = blockIndex + 1 < blockOffsets.size() ?
+    blockOffsets[blockIndex + 1] : indexOffset;
+  block.resize(end - start);
+  input->clear();
+  input->seekg(start);
+  input->read(reinterpret_cast<char *>(block.data()), block.size());
+  if (static_cast<std::uint64_t>(input->gcount()) != block.size())
+  {
+    corruptBlock();
+  }
+
+  blockPosition = 0;
+  dictionary.clear();
+  previous = VPUTraceEvent();
+}
+
+std::uint8_t VPUTraceDecoder::readByte()
+{
+  if (blockPosition == block.size())
+  {
+    corruptBlock();
+  }
+
+  return block[blockPosition++];
+}
+
+std::uint64_t VPUTraceDecoder::readVarint()
+{
+  std::uint64_t value = 0;
+  for (unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    std::uint8_t byte = readByte();
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return value;
+    }
+  }
+
+  corruptBlock();
+  return 0;
+}
+
+std::uint32_t VPUTraceDecoder::readInstructionWord(bool dictionaryReference)
+{
+  if (dictionaryReference)
+  {
+    std::uint64_t dictionaryIndex = readVarint();
+    if (dictionaryIndex >= dictionary.size())
+    {
+      corruptBlock();
+    }
+    return dictionary[dictionaryIndex];
+  }
+
+  std::uint32_t word = 0;
+  for (unsigned int byte = 0; byte < 4; byte++)
+  {
+    word |= static_cast<std::uint32_t>(readByte()) << (byte * 8);
+  }
+  dictionary.push_back(word);
+  return word;
+}
+
+void VPUTraceDecoder::readStallReason(VPUStallReason *reason)
+{
+  std::uint8_t unit = readByte();
+  std::uint8_t registerClass = readByte();
+  if (unit == static_cast<std::uint8_t>(VPUStallUnit::None) ||
+    unit > static_cast<std::uint8_t>(VPUStallUnit::Lower) ||
+    registerClass > static_cast<std::uint8_t>(VPUStallRegisterClass::Integer))
+  {
+    corruptBlock();
+  }
+
+  reason->unit = static_cast<VPUStallUnit>(unit);
+  reason->registerClass = static_cast<VPUStallRegisterClass>(registerClass);
+  reason->registerID = readByte();
+  reason->fieldMask = readByte();
+  std::uint64_t address = readVarint();
+  if (address > 0xffff)
+  {
+    corruptBlock();
+  }
+  reason->blockingInstructionAddress = static_cast<std::uint16_t>(address);
+}
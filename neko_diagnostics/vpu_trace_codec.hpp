@@ -0,0 +1,94 @@
+#ifndef VPU_TRACE_CODEC_H
+#define VPU_TRACE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <unordered_map>
+#include <vector>
+
+#include "vpu_binary_trace.hpp"
+
+#define VPU_COMPRESSED_TRACE_VERSION 2
+#define VPU_COMPRESSED_TRACE_HEADER_SIZE 20
+#define VPU_COMPRESSED_TRACE_FOOTER_SIZE 20
+#define VPU_COMPRESSED_TRACE_INDEX_ENTRY_SIZE 16
+#define VPU_COMPRESSED_TRACE_BLOCK_EVENTS 4096
+
+// A compressed trace is a header, a run of blocks, a seek index and a footer:
+//   header: "NKTZ", u16 version, u8 VPU type, u8 reserved, u32 events per
+//           block, u64 FNV-1a hash of the microprogram
+//   block:  events encoded against the previous event in the same block
+//   index:  u64 block offset and u64 first cycle for every block
+//   footer: u64 index offset, u64 event count, "NKTI"
+// Each event is a tag byte followed by the fields the tag does not elide:
+//   bits 0-1  event type
+//   bit 2     upper word is a block dictionary index rather than a literal
+//   bit 3     lower word is a block dictionary index rather than a literal
+//   bit 4     opcode and destination repeat the previous event
+//   bit 5     instruction address is the previous address plus 8
+//   bit 6     a stall reason follows: unit, register class, register and
+//             field mask bytes, then a varint blocking instruction address
+// Cycle and address deltas are zigzag varints, dictionary indices are varints
+// and literal instruction words are four little-endian bytes. Blocks reset the
+// delta and dictionary state so the index can seek straight to any of them.
+class VPUTraceEncoder
+{
+  public:
+    VPUTraceEncoder(
+      std::ostream *output,
+      const VPUBinaryTraceHeader &header,
+      std::uint32_t blockEventCount = VPU_COMPRESSED_TRACE_BLOCK_EVENTS);
+    void write(const VPUTraceEvent &event);
+    void finish();
+
+  private:
+    std::ostream *output;
+    std::uint32_t blockEventCount;
+    std::uint64_t eventCount = 0;
+    std::uint64_t bytesWritten = 0;
+    std::vector<std::uint8_t> buffer;
+    std::vector<std::uint64_t> index;
+    std::unordered_map<std::uint32_t, std::uint32_t> dictionary;
+    VPUTraceEvent previous;
+    bool finished = false;
+
+    void flush();
+    void writeVarint(std::uint64_t value);
+    void writeInstructionWord(std::uint32_t word);
+};
+
+class VPUTraceDecoder
+{
+  public:
+    explicit VPUTraceDecoder(std::istream *input);
+    const VPUBinaryTraceHeader &header() const;
+    std::uint32_t blockEventCount() const;
+    std::uint64_t eventCount() const;
+    std::uint64_t position() const;
+    bool read(VPUTraceEvent *event);
+    void seek(std::uint64_t eventIndex);
+    void seekCycle(std::uint64_t cycle);
+
+  private:
+    std::istream *input;
+    VPUBinaryTraceHeader traceHeader;
+    std::uint32_t eventsPerBlock = 0;
+    std::uint64_t totalEvents = 0;
+    std::uint64_t indexOffset = 0;
+    std::vector<std::uint64_t> blockOffsets;
+    std::vector<std::uint64_t> blockCycles;
+    std::vector<std::uint8_t> block;
+    std::size_t blockPosition = 0;
+    std::uint64_t nextEvent = 0;
+    std::vector<std::uint32_t> dictionary;
+    VPUTraceEvent previous;
+
+    void loadBlock(std::size_t blockIndex);
+    std::uint8_t readByte();
+    std::uint64_t readVarint();
+    std::uint32_t readInstructionWord(bool dictionaryReference);
+    void readStallReason(VPUStallReason *reason);
+};
+
+#endif
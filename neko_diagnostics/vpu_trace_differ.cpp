@@ -0,0 +1,380 @@
+#include "vpu_trace_differ.hpp"
+
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "vpu_binary_trace.hpp"
+#include "vpu_register_ids.hpp"
+
+namespace
+{
+  std::string hex(std::uint64_t value)
+  {
+    std::ostringstream text;
+    text << "0x" << std::hex << value;
+    return text.str();
+  }
+
+  std::string hexBytes(const std::vector<std::uint8_t> &bytes)
+  {
+    std::ostringstream text;
+    text << std::hex << std::setfill('0');
+    for (std::uint8_t byte : bytes)
+    {
+      text << std::setw(2) << static_cast<unsigned int>(byte);
+    }
+    return text.str();
+  }
+
+  void diffValue(
+    std::vector<std::string> *differences,
+    const std::string &name,
+    std::uint64_t left,
+    std::uint64_t right)
+  {
+    if (left != right)
+    {
+      differences->push_back(name + ": " + hex(left) + " != " + hex(right));
+    }
+  }
+
+  void diffFPRegister(
+    std::vector<std::string> *differences,
+    const std::string &name,
+    const FPRegister &left,
+    const FPRegister &right)
+  {
+    diffValue(differences, name + ".x", left.x.bits(), right.x.bits());
+    diffValue(differences, name + ".y", left.y.bits(), right.y.bits());
+    diffValue(differences, name + ".z", left.z.bits(), right.z.bits());
+    diffValue(differences, name + ".w", left.w.bits(), right.w.bits());
+  }
+
+  std::string registerName(const char *prefix, int registerID)
+  {
+    std::ostringstream name;
+    name << prefix << std::setw(2) << std::setfill('0') << registerID;
+    return name.str();
+  }
+
+  void describeEvent(
+    std::ostream &output,
+    const char *label,
+    bool present,
+    const VPUTraceEvent &event)
+  {
+    output << label;
+    if (present)
+    {
+      writeVPUTraceEventJsonLine(output, event);
+    }
+    else
+    {
+      output << "<end of trace>\n";
+    }
+  }
+}
+
+VPUTraceDiffer::VPUTraceDiffer(std::size_t contextEvents) :
+  context(contextEvents)
+{
+}
+
+void VPUTraceDiffer::addLeft(const VPUTraceEvent &event)
+{
+  if (!result.diverged)
+  {
+    leftEvents.push_back(event);
+    compare();
+  }
+}
+
+void VPUTraceDiffer::addRight(const VPUTraceEvent &event)
+{
+  if (!result.diverged)
+  {
+    rightEvents.push_back(event);
+    compare();
+  }
+}
+
+void VPUTraceDiffer::finish()
+{
+  if (result.diverged)
+  {
+    return;
+  }
+  if (!leftEvents.empty())
+  {
+    diverge(&leftEvents.front(), nullptr);
+  }
+  else if (!rightEvents.empty())
+  {
+    diverge(nullptr, &rightEvents.front());
+  }
+}
+
+bool VPUTraceDiffer::diverged() const
+{
+  return result.diverged;
+}
+
+const VPUTraceDivergence &VPUTraceDiffer::divergence() const
+{
+  return result;
+}
+
+void VPUTraceDiffer::compare()
+{
+  while (!leftEvents.empty() && !rightEvents.empty())
+  {
+    if (!vpuTraceEventsEqual(leftEvents.front(), rightEvents.front()))
+    {
+      diverge(&leftEvents.front(), &rightEvents.front());
+      return;
+    }
+
+    context.push(leftEvents.front());
+    leftEvents.pop_front();
+    rightEvents.pop_front();
+    result.eventIndex++;
+  }
+}
+
+void VPUTraceDiffer::diverge(
+  const VPUTraceEvent *left,
+  const VPUTraceEvent *right)
+{
+  result.diverged = true;
+  result.hasLeftEvent = left != nullptr;
+  result.hasRightEvent = right != nullptr;
+  if (left != nullptr)
+  {
+    result.leftEvent = *left;
+  }
+  if (right != nullptr)
+  {
+    result.rightEvent = *right;
+  }
+  result.context = context.events();
+  leftEvents.clear();
+  rightEvents.clear();
+}
+
+bool vpuTraceEventsEqual(const VPUTraceEvent &left, const VPUTraceEvent &right)
+{
+  return left.type == right.type &&
+    left.cycle == right.cycle &&
+    left.instructionAddress == right.instructionAddress &&
+    left.upperInstruction == right.upperInstruction &&
+    left.lowerInstruction == right.lowerInstruction &&
+    left.opCode == right.opCode &&
+    left.destinationRegister == right.destinationRegister &&
+    left.destinationFieldMask == right.destinationFieldMask &&
+    left.stallReason.unit == right.stallReason.unit &&
+    left.stallReason.registerClass == right.stallReason.registerClass &&
+    left.stallReason.registerID == right.stallReason.registerID &&
+    left.stallReason.fieldMask == right.stallReason.fieldMask &&
+    left.stallReason.blockingInstructionAddress ==
+      right.stallReason.blockingInstructionAddress;
+}
+
+std::vector<std::string> diffVPUState(const VPU &left, const VPU &right)
+{
+  std::vector<std::string> differences;
+  if (left.unitType() != right.unitType())
+  {
+    differences.push_back("VU type differs");
+    return differences;
+  }
+
+  diffValue(&differences, "state", left.getState(), right.getState());
+  diffValue(&differences, "PC", left.programCounter(), right.programCounter());
+  diffValue(
+    &differences, "cycles", left.elapsedCycles(), right.elapsedCycles());
+  for (int registerID = VPU_REGISTER_VF00;
+    registerID <= VPU_REGISTER_VF31;
+    registerID++)
+  {
+    diffFPRegister(
+      &differences,
+      registerName("VF", registerID),
+      *left.fpRegisterValue(registerID),
+      *right.fpRegisterValue(registerID));
+  }
+  diffFPRegister(&differences, "ACC", left.accumulator, right.accumulator);
+  for (int registerID = VPU_REGISTER_VI00;
+    registerID <= VPU_REGISTER_VI15;
+    registerID++)
+  {
+    diffValue(
+      &differences,
+      registerName("VI", registerID),
+      left.intRegisterValue(registerID),
+      right.intRegisterValue(registerID));
+  }
+  diffValue(
+    &differences, "clipping flags", left.clippingFlags, right.clippingFlags);
+
+  std::size_t differingRows = 0;
+  for (std::size_t address = 0; address < left.dataMemorySize(); address += 16)
+  {
+    std::vector<std::uint8_t> leftRow = left.readDataMemory(address, 16);
+    std::vector<std::uint8_t> rightRow = right.readDataMemory(address, 16);
+    if (leftRow == rightRow)
+    {
+      continue;
+    }
+    if (differingRows < VPU_TRACE_DIFF_MEMORY_ROWS)
+    {
+      differences.push_back(
+        "data memory " + hex(address) + ": " + hexBytes(leftRow) + " != " +
+        hexBytes(rightRow));
+    }
+    differingRows++;
+  }
+  if (differingRows > VPU_TRACE_DIFF_MEMORY_ROWS)
+  {
+    differences.push_back(
+      std::to_string(differingRows - VPU_TRACE_DIFF_MEMORY_ROWS) +
+      " more data-memory rows differ");
+  }
+
+  if (differences.empty() && left.saveState() != right.saveState())
+  {
+    differences.push_back("internal state differs");
+  }
+
+  return differences;
+}
+
+VPUTraceDivergence diffVPUPrograms(
+  VPU *left,
+  VPU *right,
+  const VPUProgramRunConfig &config,
+  std::size_t contextEvents)
+{
+  if (left == nullptr || right == nullptr)
+  {
+    throw std::invalid_argument("VU trace differ requires two VPUs.");
+  }
+
+  VPUTraceDiffer differ(contextEvents);
+  left->setTraceCallback([&differ](const VPUTraceEvent &event) {
+    differ.addLeft(event);
+  });
+  right->setTraceCallback([&differ](const VPUTraceEvent &event) {
+    differ.addRight(event);
+  });
+
+  try
+  {
+    startVPUProgram(left, config, config.inputMemory);
+    startVPUProgram(right, config, config.inputMemory);
+    for (std::uint32_t cycle = 0;
+      cycle < config.cycleBudget && !differ.diverged() &&
+        (left->getState() == VPU_STATE_RUN ||
+          right->getState() == VPU_STATE_RUN);
+      cycle++)
+    {
+      left->run(1);
+      right->run(1);
+    }
+  }
+  catch (...)
+  {
+    left->setTraceCallback(VPUTraceCallback());
+    right->setTraceCallback(VPUTraceCallback());
+    throw;
+  }
+  left->setTraceCallback(VPUTraceCallback());
+  right->setTraceCallback(VPUTraceCallback());
+
+  differ.finish();
+  VPUTraceDivergence divergence = differ.divergence();
+  divergence.stateDifferences = diffVPUState(*left, *right);
+  if (!divergence.stateDifferences.empty())
+  {
+    divergence.diverged = true;
+  }
+  return divergence;
+}
+
+VPUTraceDivergence diffVPUBinaryTraces(
+  std::istream &left,
+  std::istream &right,
+  std::size_t contextEvents)
+{
+  VPUBinaryTraceReader leftReader(&left);
+  VPUBinaryTraceReader rightReader(&right);
+  VPUTraceDiffer differ(contextEvents);
+  VPUTraceEvent event;
+  bool leftOpen = true;
+  bool rightOpen = true;
+  while ((leftOpen || rightOpen) && !differ.diverged())
+  {
+    if (leftOpen && (leftOpen = leftReader.read(&event)))
+    {
+      differ.addLeft(event);
+    }
+    if (rightOpen && (rightOpen = rightReader.read(&event)))
+    {
+      differ.addRight(event);
+    }
+  }
+  differ.finish();
+
+  VPUTraceDivergence divergence = differ.divergence();
+  if (leftReader.header().type != rightReader.header().type)
+  {
+    divergence.stateDifferences.push_back("trace VU types differ");
+  }
+  diffValue(
+    &divergence.stateDifferences,
+    "trace program hash",
+    leftReader.header().programHash,
+    rightReader.header().programHash);
+  if (!divergence.stateDifferences.empty())
+  {
+    divergence.diverged = true;
+  }
+  return divergence;
+}
+
+void writeVPUTraceDivergence(
+  std::ostream &output,
+  const VPUTraceDivergence &divergence)
+{
+  if (!divergence.diverged)
+  {
+    output << "traces match (" << divergence.eventIndex << " events)\n";
+    return;
+  }
+
+  if (divergence.hasLeftEvent || divergence.hasRightEvent)
+  {
+    output << "first divergence at event " << divergence.eventIndex << "\n";
+    output << "context:\n";
+    for (const VPUTraceEvent &event : divergence.context)
+    {
+      output << "  ";
+      writeVPUTraceEventJsonLine(output, event);
+    }
+    describeEvent(
+      output, "left:  ", divergence.hasLeftEvent, divergence.leftEvent);
+    describeEvent(
+      output, "right: ", divergence.hasRightEvent, divergence.rightEvent);
+  }
+  else
+  {
+    output << "traces match (" << divergence.eventIndex
+      << " events) but the states differ\n";
+  }
+
+  for (const std::string &difference : divergence.stateDifferences)
+  {
+    output << "state " << difference << "\n";
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef VPU_TRACE_DIFFER_H
+#define VPU_TRACE_DIFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "vpu_program_runner.hpp"
+#include "vpu_trace_ring_buffer.hpp"
+
+#define VPU_TRACE_DIFF_CONTEXT_EVENTS 8
+#define VPU_TRACE_DIFF_MEMORY_ROWS 8
+
+struct VPUTraceDivergence
+{
+  bool diverged = false;
+  std::uint64_t eventIndex = 0;
+  bool hasLeftEvent = false;
+  bool hasRightEvent = false;
+  VPUTraceEvent leftEvent = {};
+  VPUTraceEvent rightEvent = {};
+  std::vector<VPUTraceEvent> context;
+  std::vector<std::string> stateDifferences;
+};
+
+// Compares two event streams as they arrive and stops at the first event that
+// differs. Only unmatched events and the last few matched ones are kept.
+class VPUTraceDiffer
+{
+  public:
+    explicit VPUTraceDiffer(
+      std::size_t contextEvents = VPU_TRACE_DIFF_CONTEXT_EVENTS);
+    void addLeft(const VPUTraceEvent &event);
+    void addRight(const VPUTraceEvent &event);
+    void finish();
+    bool diverged() const;
+    const VPUTraceDivergence &divergence() const;
+
+  private:
+    std::deque<VPUTraceEvent> leftEvents;
+    std::deque<VPUTraceEvent> rightEvents;
+    VPUTraceRingBuffer context;
+    VPUTraceDivergence result;
+
+    void compare();
+    void diverge(const VPUTraceEvent *left, const VPUTraceEvent *right);
+};
+
+bool vpuTraceEventsEqual(const VPUTraceEvent &left, const VPUTraceEvent &right);
+
+std::vector<std::string> diffVPUState(const VPU &left, const VPU &right);
+
+// Runs the same program on both VPUs one cycle at a time and compares their
+// traces as they are produced. A divergence carries a state diff of both
+// VPUs taken at the cycle it was found. Identical traces that still end in
+// different states are reported as a divergence with no events.
+VPUTraceDivergence diffVPUPrograms(
+  VPU *left,
+  VPU *right,
+  const VPUProgramRunConfig &config,
+  std::size_t contextEvents = VPU_TRACE_DIFF_CONTEXT_EVENTS);
+
+VPUTraceDivergence diffVPUBinaryTraces(
+  std::istream &left,
+  std::istream &right,
+  std::size_t contextEvents = VPU_TRACE_DIFF_CONTEXT_EVENTS);
+
+void writeVPUTraceDivergence(
+  std::ostream &output,
+  const VPUTraceDivergence &divergence);
+
+#endif
@@ -0,0 +1,233 @@
+#include "vpu_trace_file.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "save_state.hpp"
+
+VPUTraceFile::VPUTraceFile(const std::string &path)
+{
+  fileDescriptor = ::open(path.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+  {
+    throw std::runtime_error("Unable to open VU trace file.");
+  }
+
+  try
+  {
+    struct stat status;
+    if (::fstat(fileDescriptor, &status) != 0)
+    {
+      throw std::runtime_error("Unable to open VU trace file.");
+    }
+    mappingSize = static_cast<std::size_t>(status.st_size);
+    if (mappingSize < VPU_BINARY_TRACE_HEADER_SIZE)
+    {
+      throw std::runtime_error("VU binary trace has an invalid header.");
+    }
+
+    void *address = ::mmap(
+      nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (address == MAP_FAILED)
+    {
+      throw std::runtime_error("Unable to map VU trace file.");
+    }
+    mapping = static_cast<const std::uint8_t *>(address);
+
+    traceHeader = decodeVPUBinaryTraceHeader(mapping, mappingSize);
+    std::size_t recordBytes = mappingSize - VPU_BINARY_TRACE_HEADER_SIZE;
+    if (recordBytes % VPU_BINARY_TRACE_RECORD_SIZE != 0)
+    {
+      throw std::runtime_error("VU binary trace ends with a partial record.");
+    }
+    records = recordBytes / VPU_BINARY_TRACE_RECORD_SIZE;
+
+    sparseCycles.reserve(records / VPU_TRACE_FILE_INDEX_STRIDE + 1);
+    for (std::size_t index = 0; index < records;
+      index += VPU_TRACE_FILE_INDEX_STRIDE)
+    {
+      sparseCycles.push_back(cycleAt(index));
+    }
+  }
+  catch (...)
+  {
+    close();
+    throw;
+  }
+}
+
+VPUTraceFile::~VPUTraceFile()
+{
+  close();
+}
+
+const VPUBinaryTraceHeader &VPUTraceFile::header() const
+{
+  return traceHeader;
+}
+
+std::size_t VPUTraceFile::eventCount() const
+{
+  return records;
+}
+
+VPUTraceEvent VPUTraceFile::event(std::size_t index) const
+{
+  if (index >= records)
+  {
+    throw std::out_of_range("VU trace event is out of range.");
+  }
+
+  VPUTraceEvent event;
+  decodeVPUTraceRecord(
+    mapping + VPU_BINARY_TRACE_HEADER_SIZE +
+      index * VPU_BINARY_TRACE_RECORD_SIZE,
+    &event);
+  return event;
+}
+
+std::size_t VPUTraceFile::firstEventAtOrAfter(std::uint64_t cycle) const
+{
+  std::size_t stride = std::lower_bound(
+    sparseCycles.begin(),
+    sparseCycles.end(),
+    cycle) - sparseCycles.begin();
+  if (stride == 0)
+  {
+    return 0;
+  }
+
+  std::size_t first = (stride - 1) * VPU_TRACE_FILE_INDEX_STRIDE;
+  std::size_t last =
+    std::min(stride * VPU_TRACE_FILE_INDEX_STRIDE, records);
+  while (first < last)
+  {
+    std::size_t middle = first + (last - first) / 2;
+    if (cycleAt(middle) < cycle)
+    {
+      first = middle + 1;
+    }
+    else
+    {
+      last = middle;
+    }
+  }
+
+  return first;
+}
+
+void VPUTraceFile::eventsInCycleRange(
+  std::uint64_t firstCycle,
+  std::uint64_t lastCycle,
+  const VPUTraceEventVisitor &visitor) const
+{
+  for (std::size_t index = firstEventAtOrAfter(firstCycle);
+    index < records && cycleAt(index) <= lastCycle;
+    index++)
+  {
+    visitor(event(index));
+  }
+}
+
+void VPUTraceFile::issuesAt(
+  std::uint16_t instructionAddress,
+  const VPUTraceEventVisitor &visitor) const
+{
+  for (std::size_t index = 0; index < records; index++)
+  {
+    VPUTraceEvent candidate = event(index);
+    if (candidate.type == VPUTraceEventType::InstructionIssued &&
+      candidate.instructionAddress == instructionAddress)
+    {
+      visitor(candidate);
+    }
+  }
+}
+
+void VPUTraceFile::writebacksTo(
+  VPUStallRegisterClass registerClass,
+  std::uint8_t registerID,
+  std::uint8_t fieldMask,
+  const VPUTraceEventVisitor &visitor) const
+{
+  for (std::size_t index = 0; index < records; index++)
+  {
+    VPUTraceEvent candidate = event(index);
+    if (candidate.type == VPUTraceEventType::PipelineWriteback &&
+      candidate.destinationRegister == registerID &&
+      vpuWritebackRegisterClass(candidate.opCode) == registerClass &&
+      (fieldMask == 0 || (candidate.destinationFieldMask & fieldMask) != 0))
+    {
+      visitor(candidate);
+    }
+  }
+}
+
+std::vector<VPUTraceStallSpan> VPUTraceFile::stallSpansLongerThan(
+  std::uint64_t cycles) const
+{
+  std::vector<VPUTraceStallSpan> spans;
+  VPUTraceStallSpan span;
+  bool spanOpen = false;
+  for (std::size_t index = 0; index <= records; index++)
+  {
+    VPUTraceEvent candidate = {};
+    bool stall = false;
+    if (index < records)
+    {
+      candidate = event(index);
+      stall = candidate.type == VPUTraceEventType::PipelineStall;
+    }
+    if (index < records && !stall)
+    {
+      continue;
+    }
+
+    if (spanOpen && stall &&
+      candidate.instructionAddress == span.instructionAddress &&
+      candidate.cycle <= span.lastCycle + 1)
+    {
+      span.lastCycle = candidate.cycle;
+      continue;
+    }
+
+    if (spanOpen && span.lastCycle - span.firstCycle + 1 > cycles)
+    {
+      spans.push_back(span);
+    }
+    spanOpen = stall;
+    span.instructionAddress = candidate.instructionAddress;
+    span.firstCycle = candidate.cycle;
+    span.lastCycle = candidate.cycle;
+  }
+
+  return spans;
+}
+
+std::uint64_t VPUTraceFile::cycleAt(std::size_t index) const
+{
+  SaveStateReader reader(
+    mapping + VPU_BINARY_TRACE_HEADER_SIZE +
+      index * VPU_BINARY_TRACE_RECORD_SIZE + 16,
+    8);
+  return reader.readU64();
+}
+
+void VPUTraceFile::close()
+{
+  if (mapping != nullptr)
+  {
+    ::munmap(const_cast<std::uint8_t *>(mapping), mappingSize);
+    mapping = nullptr;
+  }
+  if (fileDescriptor >= 0)
+  {
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef VPU_TRACE_FILE_H
+#define VPU_TRACE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "vpu_binary_trace.hpp"
+
+#define VPU_TRACE_FILE_INDEX_STRIDE 1024
+
+struct VPUTraceStallSpan
+{
+  std::uint16_t instructionAddress = 0;
+  std::uint64_t firstCycle = 0;
+  std::uint64_t lastCycle = 0;
+};
+
+using VPUTraceEventVisitor = std::function<void(const VPUTraceEvent &)>;
+
+// Read-only view of a binary trace file mapped into memory. Records are
+// decoded on demand, and a sparse index of every
+// VPU_TRACE_FILE_INDEX_STRIDE-th cycle narrows cycle lookups before a binary
+// search over the mapped records. Cycle queries assume events are in cycle
+// order, as the runner writes them.
+class VPUTraceFile
+{
+  public:
+    explicit VPUTraceFile(const std::string &path);
+    ~VPUTraceFile();
+    VPUTraceFile(const VPUTraceFile &) = delete;
+    VPUTraceFile &operator=(const VPUTraceFile &) = delete;
+
+    const VPUBinaryTraceHeader &header() const;
+    std::size_t eventCount() const;
+    VPUTraceEvent event(std::size_t index) const;
+    std::size_t firstEventAtOrAfter(std::uint64_t cycle) const;
+
+    void eventsInCycleRange(
+      std::uint64_t firstCycle,
+      std::uint64_t lastCycle,
+      const VPUTraceEventVisitor &visitor) const;
+    void issuesAt(
+      std::uint16_t instructionAddress,
+      const VPUTraceEventVisitor &visitor) const;
+    void writebacksTo(
+      VPUStallRegisterClass registerClass,
+      std::uint8_t registerID,
+      std::uint8_t fieldMask,
+      const VPUTraceEventVisitor &visitor) const;
+    std::vector<VPUTraceStallSpan> stallSpansLongerThan(
+      std::uint64_t cycles) const;
+
+  private:
+    int fileDescriptor = -1;
+    const std::uint8_t *mapping = nullptr;
+    std::size_t mappingSize = 0;
+    VPUBinaryTraceHeader traceHeader;
+    std::size_t records = 0;
+    std::vector<std::uint64_t> sparseCycles;
+
+    std::uint64_t cycleAt(std::size_t index) const;
+    void close();
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "vpu_trace_output.hpp"
+
+#include <ostream>
+#include <stdexcept>
+
+VPUTraceOutput::VPUTraceOutput(
+  std::ostream *output,
+  VPUTraceOutputFormat format,
+  const VPUBinaryTraceHeader &header) :
+  output(output)
+{
+  if (output == nullptr)
+  {
+    throw std::invalid_argument("VU trace output requires a stream.");
+  }
+
+  switch (format)
+  {
+    case VPUTraceOutputFormat::JsonLines:
+      break;
+    case VPUTraceOutputFormat::Binary:
+      binaryWriter.reset(new VPUBinaryTraceWriter(output, header));
+      break;
+    case VPUTraceOutputFormat::Compressed:
+      encoder.reset(new VPUTraceEncoder(output, header));
+      break;
+  }
+}
+
+void VPUTraceOutput::write(const VPUTraceEvent &event)
+{
+  if (encoder)
+  {
+    encoder->write(event);
+  }
+  else if (binaryWriter)
+  {
+    binaryWriter->write(event);
+  }
+  else
+  {
+    writeVPUTraceEventJsonLine(*output, event);
+  }
+}
+
+void VPUTraceOutput::finish()
+{
+  if (encoder)
+  {
+    encoder->finish();
+  }
+  output->flush();
+}
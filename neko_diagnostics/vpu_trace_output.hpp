@@ -0,0 +1,29 @@
+#ifndef VPU_TRACE_OUTPUT_H
+#define VPU_TRACE_OUTPUT_H
+
+#include <iosfwd>
+#include <memory>
+
+#include "vpu_binary_trace.hpp"
+#include "vpu_program_runner.hpp"
+#include "vpu_trace_codec.hpp"
+
+// Writes trace events to a stream in any VPUTraceOutputFormat. finish() must
+// be called once the last event is written.
+class VPUTraceOutput
+{
+  public:
+    VPUTraceOutput(
+      std::ostream *output,
+      VPUTraceOutputFormat format,
+      const VPUBinaryTraceHeader &header);
+    void write(const VPUTraceEvent &event);
+    void finish();
+
+  private:
+    std::ostream *output;
+    std::unique_ptr<VPUBinaryTraceWriter> binaryWriter;
+    std::unique_ptr<VPUTraceEncoder> encoder;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "vpu_trace_ring_buffer.hpp"
+
+#include <stdexcept>
+
+VPUTraceRingBuffer::VPUTraceRingBuffer(std::size_t capacity)
+{
+  if (capacity == 0)
+  {
+    throw std::invalid_argument(
+      "VU trace ring buffer capacity must be greater than zero.");
+  }
+
+  slots.resize(capacity);
+}
+
+void VPUTraceRingBuffer::push(const VPUTraceEvent &event)
+{
+  slots[next] = event;
+  next = next + 1 == slots.size() ? 0 : next + 1;
+  if (count == slots.size())
+  {
+    dropped++;
+  }
+  else
+  {
+    count++;
+  }
+}
+
+void VPUTraceRingBuffer::clear()
+{
+  next = 0;
+  count = 0;
+  dropped = 0;
+}
+
+std::size_t VPUTraceRingBuffer::capacity() const
+{
+  return slots.size();
+}
+
+std::size_t VPUTraceRingBuffer::size() const
+{
+  return count;
+}
+
+std::uint64_t VPUTraceRingBuffer::droppedEvents() const
+{
+  return dropped;
+}
+
+std::vector<VPUTraceEvent> VPUTraceRingBuffer::events() const
+{
+  std::vector<VPUTraceEvent> ordered;
+  ordered.reserve(count);
+  std::size_t first = (next + slots.size() - count) % slots.size();
+  for (std::size_t event = 0; event < count; event++)
+  {
+    ordered.push_back(slots[(first + event) % slots.size()]);
+  }
+
+  return ordered;
+}
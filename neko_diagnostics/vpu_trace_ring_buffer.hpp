@@ -0,0 +1,29 @@
+#ifndef VPU_TRACE_RING_BUFFER_H
+#define VPU_TRACE_RING_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vpu.hpp"
+
+// Keeps the most recent capacity events and counts the ones it overwrote.
+class VPUTraceRingBuffer
+{
+  public:
+    explicit VPUTraceRingBuffer(std::size_t capacity);
+    void push(const VPUTraceEvent &event);
+    void clear();
+    std::size_t capacity() const;
+    std::size_t size() const;
+    std::uint64_t droppedEvents() const;
+    std::vector<VPUTraceEvent> events() const;
+
+  private:
+    std::vector<VPUTraceEvent> slots;
+    std::size_t next = 0;
+    std::size_t count = 0;
+    std::uint64_t dropped = 0;
+};
+
+#endif
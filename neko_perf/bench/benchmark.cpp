@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <ostream>
+#include <utility>
+
+#include "allocation_tracker.hpp"
+#include "benchmark.hpp"
+#include "stop_watch.hpp"
+
+namespace
+{
+  struct RegisteredBenchmark
+  {
+    std::string name;
+    std::string group;
+    BenchmarkFunction function;
+  };
+
+  struct Sample
+  {
+    double nanosecondsPerUnit;
+    PerfCounterReading counters;
+    AllocationCounts allocations;
+    double units;
+  };
+
+  std::vector<RegisteredBenchmark> &registeredBenchmarks()
+  {
+    static std::vector<RegisteredBenchmark> benchmarks;
+    return benchmarks;
+  }
+
+  std::vector<BenchmarkSuiteFunction> &registeredSuites()
+  {
+    static std::vector<BenchmarkSuiteFunction> suites;
+    return suites;
+  }
+
+  double timeRun(const BenchmarkFunction &function, BenchmarkState *state)
+  {
+    StopWatch watch;
+    watch.start();
+    function(*state);
+    return watch.elapsedNanoseconds();
+  }
+
+  uint64_t calibrateIterations(const BenchmarkFunction &function, const BenchmarkOptions &options)
+  {
+    uint64_t iterations = 1;
+    while (true)
+    {
+      BenchmarkState state(iterations);
+      double elapsed = timeRun(function, &state);
+      if (elapsed >= options.minimumSampleNanoseconds)
+      {
+        return iterations;
+      }
+
+      double scale = elapsed > 0 ? options.minimumSampleNanoseconds / elapsed : 10;
+      iterations = static_cast<uint64_t>(iterations * std::min(10.0, std::max(2.0, scale * 1.2)));
+    }
+  }
+
+  void warmUp(const BenchmarkFunction &function, uint64_t iterations, const BenchmarkOptions &options)
+  {
+    double elapsed = 0;
+    while (elapsed < options.warmupNanoseconds)
+    {
+      BenchmarkState state(iterations);
+      elapsed += timeRun(function, &state);
+    }
+  }
+
+  double percentile(const std::vector<double> &sorted, double fraction)
+  {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+  }
+
+  void summarize(std::vector<Sample> *samples, BenchmarkResult *result)
+  {
+    std::sort(samples->begin(), samples->end(), [](const Sample &left, const Sample &right) {
+      return left.nanosecondsPerUnit < right.nanosecondsPerUnit;
+    });
+
+    for (const Sample &sample : *samples)
+    {
+      result->samples.push_back(sample.nanosecondsPerUnit);
+      result->mean += sample.nanosecondsPerUnit;
+    }
+    result->mean /= samples->size();
+
+    double variance = 0;
+    for (double sample : result->samples)
+    {
+      variance += (sample - result->mean) * (sample - result->mean);
+    }
+    result->stddev = samples->size() > 1 ? std::sqrt(variance / (samples->size() - 1)) : 0;
+
+    size_t middle = samples->size() / 2;
+    result->median = samples->size() % 2 == 1 ?
+      result->samples[middle] :
+      (result->samples[middle - 1] + result->samples[middle]) / 2;
+    result->p95 = percentile(result->samples, 0.95);
+    result->counters = (*samples)[middle].counters;
+    result->allocationsPerUnit = (*samples)[middle].allocations.allocations / (*samples)[middle].units;
+    result->allocatedBytesPerUnit = (*samples)[middle].allocations.bytes / (*samples)[middle].units;
+  }
+
+  void writeJsonString(std::ostream &output, const std::string &value)
+  {
+    output << '"';
+    for (char character : value)
+    {
+      if (character == '"' || character == '\\')
+      {
+        output << '\\';
+      }
+      output << character;
+    }
+    output << '"';
+  }
+
+  void writeThroughput(std::ostream &output, double unitsPerSecond, double referenceClock)
+  {
+    output << ",\"units_per_second\":" << unitsPerSecond;
+    if (referenceClock > 0)
+    {
+      output << ",\"effective_mhz\":" << unitsPerSecond / 1e6
+        << ",\"realtime_ratio\":" << unitsPerSecond / referenceClock;
+    }
+  }
+
+  void writeScaling(std::ostream &output, const BenchmarkResult &result, const std::vector<BenchmarkResult> &results)
+  {
+    double perThread = 1e9 / result.median / result.threads;
+    output << ",\"threads\":" << result.threads
+      << ",\"units_per_second_per_thread\":" << perThread;
+    for (const BenchmarkResult &single : results)
+    {
+      if (single.group == result.group && single.threads == 1)
+      {
+        output << ",\"scaling_efficiency\":" << perThread * single.median / 1e9;
+        break;
+      }
+    }
+  }
+
+  void writeGroupJson(std::ostream &output, const std::vector<BenchmarkResult> &results)
+  {
+    std::vector<std::string> groups;
+    for (const BenchmarkResult &result : results)
+    {
+      if (!result.group.empty() && result.threads == 0 && std::find(groups.begin(), groups.end(), result.group) == groups.end())
+      {
+        groups.push_back(result.group);
+      }
+    }
+
+    output << ",\"groups\":[";
+    for (size_t index = 0; index < groups.size(); index++)
+    {
+      double units = 0;
+      double nanoseconds = 0;
+      const BenchmarkResult *first = nullptr;
+      size_t members = 0;
+      for (const BenchmarkResult &result : results)
+      {
+        if (result.group != groups[index] || result.threads > 0)
+        {
+          continue;
+        }
+
+        double unitsPerIteration = result.unitsPerSample / result.iterations;
+        units += unitsPerIteration;
+        nanoseconds += result.median * unitsPerIteration;
+        first = first ? first : &result;
+        members++;
+      }
+
+      output << (index == 0 ? "" : ",") << "{\"name\":";
+      writeJsonString(output, groups[index]);
+      output << ",\"unit\":";
+      writeJsonString(output, first->unitName);
+      output << ",\"benchmarks\":" << members
+        << ",\"median_ns\":" << nanoseconds / units;
+      writeThroughput(output, units * 1e9 / nanoseconds, first->referenceClock);
+      output << "}";
+    }
+    output << "]";
+  }
+}
+
+BenchmarkState::BenchmarkState(uint64_t iterations) :
+  iterationCount(iterations),
+  unitCount(static_cast<double>(iterations)),
+  unitLabel("iteration"),
+  referenceHertz(0),
+  threadCount(0)
+{
+}
+
+uint64_t BenchmarkState::iterations() const
+{
+  return iterationCount;
+}
+
+void BenchmarkState::setUnits(double units, const char *unitName)
+{
+  unitCount = units;
+  unitLabel = unitName;
+}
+
+void BenchmarkState::setReferenceClock(double hertz)
+{
+  referenceHertz = hertz;
+}
+
+void BenchmarkState::setThreads(unsigned int threads)
+{
+  threadCount = threads;
+}
+
+double BenchmarkState::units() const
+{
+  return unitCount;
+}
+
+const char *BenchmarkState::unitName() const
+{
+  return unitLabel;
+}
+
+double BenchmarkState::referenceClock() const
+{
+  return referenceHertz;
+}
+
+unsigned int BenchmarkState::threads() const
+{
+  return threadCount;
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char *name, BenchmarkFunction function)
+{
+  registerBenchmark(name, "", function);
+}
+
+BenchmarkSuiteRegistration::BenchmarkSuiteRegistration(BenchmarkSuiteFunction suite)
+{
+  registeredSuites().push_back(suite);
+}
+
+void registerBenchmark(const std::string &name, const std::string &group, BenchmarkFunction function)
+{
+  registeredBenchmarks().push_back({name, group, function});
+}
+
+std::vector<BenchmarkResult> runBenchmarks(const BenchmarkOptions &options, PerfCounters *counters)
+{
+  for (BenchmarkSuiteFunction suite : registeredSuites())
+  {
+    suite(options);
+  }
+  registeredSuites().clear();
+
+  std::vector<RegisteredBenchmark> benchmarks = registeredBenchmarks();
+  std::stable_sort(benchmarks.begin(), benchmarks.end(), [](const RegisteredBenchmark &left, const RegisteredBenchmark &right) {
+    return left.group + "/" + left.name < right.group + "/" + right.name;
+  });
+
+  std::vector<BenchmarkResult> results;
+  for (const RegisteredBenchmark &benchmark : benchmarks)
+  {
+    if (benchmark.name.find(options.filter) == std::string::npos)
+    {
+      continue;
+    }
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.group = benchmark.group;
+    result.iterations = calibrateIterations(benchmark.function, options);
+    warmUp(benchmark.function, result.iterations, options);
+
+    std::vector<Sample> samples;
+    for (int sampleIndex = 0; sampleIndex < std::max(1, options.sampleCount); sampleIndex++)
+    {
+      BenchmarkState state(result.iterations);
+      StopWatch watch;
+      AllocationCounts allocationsBefore = threadAllocationCounts();
+      counters->start();
+      watch.start();
+      benchmark.function(state);
+      double elapsed = watch.elapsedNanoseconds();
+      Sample sample = {elapsed / state.units(), counters->stop(), threadAllocationCounts() - allocationsBefore, state.units()};
+      for (int counter = 0; counter < PERF_COUNTER_COUNT; counter++)
+      {
+        sample.counters.values[counter] /= state.units();
+      }
+      samples.push_back(sample);
+      result.unitName = state.unitName();
+      result.unitsPerSample = state.units();
+      result.referenceClock = state.referenceClock();
+      result.threads = state.threads();
+    }
+
+    summarize(&samples, &result);
+    results.push_back(std::move(result));
+  }
+
+  return results;
+}
+
+BenchmarkHost currentBenchmarkHost()
+{
+  BenchmarkHost host;
+  host.cpuModel = "unknown";
+  std::ifstream cpuInfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuInfo, line))
+  {
+    if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos)
+    {
+      host.cpuModel = line.substr(line.find_first_not_of(" \t", line.find(':') + 1));
+      break;
+    }
+  }
+
+#if defined(__clang__)
+  host.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+  host.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+  host.compiler = "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+  host.compiler = "unknown";
+#endif
+  return host;
+}
+
+void writeBenchmarkJson(std::ostream &output, const BenchmarkHost &host, const std::vector<BenchmarkResult> &results)
+{
+  output << "{\"format_version\":" << BENCHMARK_JSON_FORMAT_VERSION << ",\"host\":{\"cpu\":";
+  writeJsonString(output, host.cpuModel);
+  output << ",\"compiler\":";
+  writeJsonString(output, host.compiler);
+  output << "},\"benchmarks\":[";
+  for (size_t index = 0; index < results.size(); index++)
+  {
+    const BenchmarkResult &result = results[index];
+    output << (index == 0 ? "" : ",") << "{\"name\":";
+    writeJsonString(output, result.name);
+    output << ",\"unit\":";
+    writeJsonString(output, result.unitName);
+    if (!result.group.empty())
+    {
+      output << ",\"group\":";
+      writeJsonString(output, result.group);
+    }
+    output << ",\"iterations\":" << result.iterations
+      << ",\"units_per_sample\":" << result.unitsPerSample
+      << ",\"samples\":" << result.samples.size()
+      << ",\"median_ns\":" << result.median
+      << ",\"p95_ns\":" << result.p95
+      << ",\"mean_ns\":" << result.mean
+      << ",\"stddev_ns\":" << result.stddev
+      << ",\"samples_ns\":[";
+    for (size_t sample = 0; sample < result.samples.size(); sample++)
+    {
+      output << (sample == 0 ? "" : ",") << result.samples[sample];
+    }
+    output << "]";
+    writeThroughput(output, 1e9 / result.median, result.referenceClock);
+    if (result.threads > 0)
+    {
+      writeScaling(output, result, results);
+    }
+    output << ",\"allocations_per_unit\":" << result.allocationsPerUnit
+      << ",\"allocated_bytes_per_unit\":" << result.allocatedBytesPerUnit;
+    output << ",\"counters\":{";
+    bool firstCounter = true;
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; counter++)
+    {
+      if (!result.counters.available[counter])
+      {
+        continue;
+      }
+      output << (firstCounter ? "" : ",") << "\"" << perfCounterName(static_cast<PerfCounter>(counter)) << "\":" << result.counters.values[counter];
+      firstCounter = false;
+    }
+    output << "}}";
+  }
+  output << "]";
+  writeGroupJson(output, results);
+  output << "}\n";
+}
@@ -0,0 +1,133 @@
+#ifndef benchmark_hpp
+#define benchmark_hpp
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "perf_counters.hpp"
+
+#define BENCHMARK_JSON_FORMAT_VERSION 1
+
+// Keeps the compiler from proving a benchmark's result is unused.
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory()
+{
+  asm volatile("" : : : "memory");
+}
+
+class BenchmarkState
+{
+  public:
+    explicit BenchmarkState(uint64_t iterations);
+    uint64_t iterations() const;
+    // Results are normalised per unit; one unit per iteration by default.
+    void setUnits(double units, const char *unitName);
+    // Clock rate of the emulated hardware when the units are its cycles.
+    void setReferenceClock(double hertz);
+    // Host threads that shared the work, for per-thread scaling efficiency.
+    void setThreads(unsigned int threads);
+    double units() const;
+    const char *unitName() const;
+    double referenceClock() const;
+    unsigned int threads() const;
+  private:
+    uint64_t iterationCount;
+    double unitCount;
+    const char *unitLabel;
+    double referenceHertz;
+    unsigned int threadCount;
+};
+
+struct BenchmarkOptions
+{
+  std::string filter;
+  int sampleCount = 15;
+  double minimumSampleNanoseconds = 2000000;
+  double warmupNanoseconds = 20000000;
+  // Largest thread count for scaling benchmarks; 0 uses every hardware thread.
+  unsigned int maxThreads = 0;
+};
+
+typedef std::function<void(BenchmarkState &state)> BenchmarkFunction;
+typedef void (*BenchmarkSuiteFunction)(const BenchmarkOptions &options);
+
+struct BenchmarkResult
+{
+  std::string name;
+  std::string group;
+  std::string unitName;
+  double referenceClock = 0;
+  unsigned int threads = 0;
+  uint64_t iterations = 0;
+  double unitsPerSample = 0;
+  std::vector<double> samples;
+  double median = 0;
+  double p95 = 0;
+  double mean = 0;
+  double stddev = 0;
+  PerfCounterReading counters;
+  // Heap activity of the median sample on the benchmark thread, per unit.
+  double allocationsPerUnit = 0;
+  double allocatedBytesPerUnit = 0;
+};
+
+// Results are only comparable between runs on the same CPU model built by the
+// same compiler.
+struct BenchmarkHost
+{
+  std::string cpuModel;
+  std::string compiler;
+};
+
+class BenchmarkRegistration
+{
+  public:
+    BenchmarkRegistration(const char *name, BenchmarkFunction function);
+};
+
+// Suites run before the benchmarks and register benchmarks whose names are
+// only known at run time, such as one per fixture or per opcode.
+class BenchmarkSuiteRegistration
+{
+  public:
+    explicit BenchmarkSuiteRegistration(BenchmarkSuiteFunction suite);
+};
+
+#define NEKO_BENCHMARK(benchmarkName) \
+  static void benchmarkName(BenchmarkState &state); \
+  static BenchmarkRegistration benchmarkName##Registration(#benchmarkName, benchmarkName); \
+  static void benchmarkName(BenchmarkState &state)
+
+#define NEKO_BENCHMARK_SUITE(suiteName) \
+  static void suiteName(const BenchmarkOptions &); \
+  static BenchmarkSuiteRegistration suiteName##Registration(suiteName); \
+  static void suiteName(const BenchmarkOptions &)
+
+// For suites that size themselves from the run options, such as a thread
+// count limit.
+#define NEKO_BENCHMARK_SUITE_WITH_OPTIONS(suiteName, optionsName) \
+  static void suiteName(const BenchmarkOptions &optionsName); \
+  static BenchmarkSuiteRegistration suiteName##Registration(suiteName); \
+  static void suiteName(const BenchmarkOptions &optionsName)
+
+// Benchmarks in the same group are also reported together, weighting each
+// member by one iteration. In groups of threaded benchmarks each member is
+// instead compared with the single-thread member.
+void registerBenchmark(const std::string &name, const std::string &group, BenchmarkFunction function);
+
+// Sizes each benchmark so one sample lasts at least minimumSampleNanoseconds,
+// warms it up, then times sampleCount samples. Sample times are nanoseconds
+// per unit and counters are the median sample's values per unit.
+std::vector<BenchmarkResult> runBenchmarks(const BenchmarkOptions &options, PerfCounters *counters);
+BenchmarkHost currentBenchmarkHost();
+void writeBenchmarkJson(std::ostream &output, const BenchmarkHost &host, const std::vector<BenchmarkResult> &results);
+
+#endif
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "benchmark_comparison.hpp"
+
+namespace
+{
+  enum class JsonType
+  {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object
+  };
+
+  struct JsonValue
+  {
+    JsonType type = JsonType::Null;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue *member(const std::string &name) const
+    {
+      for (const std::pair<std::string, JsonValue> &entry : members)
+      {
+        if (entry.first == name)
+        {
+          return &entry.second;
+        }
+      }
+      return nullptr;
+    }
+  };
+
+  // Reads the subset of JSON that writeBenchmarkJson emits: no unicode
+  // escapes, numbers in strtod syntax.
+  class JsonReader
+  {
+    public:
+      explicit JsonReader(const std::string &text) : text(text), position(0)
+      {
+      }
+
+      JsonValue readDocument()
+      {
+        JsonValue value = readValue();
+        skipSpace();
+        if (position != text.size())
+        {
+          fail();
+        }
+        return value;
+      }
+
+    private:
+      const std::string &text;
+      size_t position;
+
+      [[noreturn]] void fail() const
+      {
+        throw std::runtime_error("Benchmark baseline is not valid JSON.");
+      }
+
+      void skipSpace()
+      {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+        {
+          position++;
+        }
+      }
+
+      void expect(char character)
+      {
+        skipSpace();
+        if (position >= text.size() || text[position] != character)
+        {
+          fail();
+        }
+        position++;
+      }
+
+      bool consume(char character)
+      {
+        skipSpace();
+        if (position < text.size() && text[position] == character)
+        {
+          position++;
+          return true;
+        }
+        return false;
+      }
+
+      bool consumeWord(const char *word)
+      {
+        std::string expected(word);
+        if (text.compare(position, expected.size(), expected) == 0)
+        {
+          position += expected.size();
+          return true;
+        }
+        return false;
+      }
+
+      std::string readString()
+      {
+        expect('"');
+        std::string value;
+        while (position < text.size() && text[position] != '"')
+        {
+          if (text[position] == '\\')
+          {
+            position++;
+            if (position >= text.size())
+            {
+              fail();
+            }
+          }
+          value += text[position++];
+        }
+        expect('"');
+        return value;
+      }
+
+      JsonValue readValue()
+      {
+        skipSpace();
+        if (position >= text.size())
+        {
+          fail();
+        }
+
+        JsonValue value;
+        char next = text[position];
+        if (next == '{')
+        {
+          value.type = JsonType::Object;
+          position++;
+          if (!consume('}'))
+          {
+            do
+            {
+              std::string name = readString();
+              expect(':');
+              value.members.emplace_back(name, readValue());
+            } while (consume(','));
+            expect('}');
+          }
+        }
+        else if (next == '[')
+        {
+          value.type = JsonType::Array;
+          position++;
+          if (!consume(']'))
+          {
+            do
+            {
+              value.items.push_back(readValue());
+            } while (consume(','));
+            expect(']');
+          }
+        }
+        else if (next == '"')
+        {
+          value.type = JsonType::String;
+          value.text = readString();
+        }
+        else if (consumeWord("true"))
+        {
+          value.type = JsonType::Boolean;
+          value.number = 1;
+        }
+        else if (consumeWord("false"))
+        {
+          value.type = JsonType::Boolean;
+        }
+        else if (consumeWord("null"))
+        {
+          value.type = JsonType::Null;
+        }
+        else
+        {
+          const char *start = text.c_str() + position;
+          char *end = nullptr;
+          value.type = JsonType::Number;
+          value.number = std::strtod(start, &end);
+          if (end == start)
+          {
+            fail();
+          }
+          position += end - start;
+        }
+        return value;
+      }
+  };
+
+  const JsonValue &requireMember(const JsonValue &object, const std::string &name, JsonType type)
+  {
+    const JsonValue *value = object.type == JsonType::Object ? object.member(name) : nullptr;
+    if (value == nullptr || value->type != type)
+    {
+      throw std::runtime_error("Benchmark baseline is missing \"" + name + "\".");
+    }
+    return *value;
+  }
+
+  // Two-sided p-value from the normal approximation to the U statistic, with
+  // tie and continuity corrections.
+  double mannWhitneyPValue(const std::vector<double> &first, const std::vector<double> &second)
+  {
+    if (first.empty() || second.empty())
+    {
+      return 1;
+    }
+
+    std::vector<std::pair<double, int>> combined;
+    for (double sample : first)
+    {
+      combined.emplace_back(sample, 0);
+    }
+    for (double sample : second)
+    {
+      combined.emplace_back(sample, 1);
+    }
+    std::sort(combined.begin(), combined.end());
+
+    double firstRankSum = 0;
+    double tieCorrection = 0;
+    for (size_t start = 0; start < combined.size();)
+    {
+      size_t end = start;
+      while (end < combined.size() && combined[end].first == combined[start].first)
+      {
+        end++;
+      }
+
+      double rank = (start + 1 + end) / 2.0;
+      for (size_t index = start; index < end; index++)
+      {
+        firstRankSum += combined[index].second == 0 ? rank : 0;
+      }
+      double ties = static_cast<double>(end - start);
+      tieCorrection += ties * ties * ties - ties;
+      start = end;
+    }
+
+    double firstCount = static_cast<double>(first.size());
+    double secondCount = static_cast<double>(second.size());
+    double total = firstCount + secondCount;
+    double u = firstRankSum - firstCount * (firstCount + 1) / 2;
+    double mean = firstCount * secondCount / 2;
+    double variance = firstCount * secondCount / 12 * ((total + 1) - tieCorrection / (total * (total - 1)));
+    if (variance <= 0)
+    {
+      return 1;
+    }
+
+    double z = std::max(0.0, std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+  }
+}
+
+BenchmarkBaseline readBenchmarkBaseline(std::istream &input)
+{
+  std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  JsonValue document = JsonReader(text).readDocument();
+
+  double version = requireMember(document, "format_version", JsonType::Number).number;
+  if (version != BENCHMARK_JSON_FORMAT_VERSION)
+  {
+    throw std::runtime_error("Benchmark baseline format version " + std::to_string(static_cast<int>(version)) + " is not supported.");
+  }
+
+  BenchmarkBaseline baseline;
+  const JsonValue &host = requireMember(document, "host", JsonType::Object);
+  baseline.host.cpuModel = requireMember(host, "cpu", JsonType::String).text;
+  baseline.host.compiler = requireMember(host, "compiler", JsonType::String).text;
+
+  for (const JsonValue &benchmark : requireMember(document, "benchmarks", JsonType::Array).items)
+  {
+    BenchmarkBaselineEntry entry;
+    entry.name = requireMember(benchmark, "name", JsonType::String).text;
+    entry.unitName = requireMember(benchmark, "unit", JsonType::String).text;
+    entry.median = requireMember(benchmark, "median_ns", JsonType::Number).number;
+    for (const JsonValue &sample : requireMember(benchmark, "samples_ns", JsonType::Array).items)
+    {
+      entry.samples.push_back(sample.number);
+    }
+    baseline.benchmarks.push_back(entry);
+  }
+  return baseline;
+}
+
+BenchmarkComparisonReport compareBenchmarks(const BenchmarkBaseline &baseline, const BenchmarkHost &host, const std::vector<BenchmarkResult> &results, const BenchmarkComparisonOptions &options)
+{
+  BenchmarkComparisonReport report;
+  report.comparable = baseline.host.cpuModel == host.cpuModel && baseline.host.compiler == host.compiler;
+
+  for (const BenchmarkResult &result : results)
+  {
+    auto entry = std::find_if(baseline.benchmarks.begin(), baseline.benchmarks.end(), [&](const BenchmarkBaselineEntry &candidate) {
+      return candidate.name == result.name && candidate.unitName == result.unitName;
+    });
+    if (entry == baseline.benchmarks.end())
+    {
+      report.missingFromBaseline.push_back(result.name);
+      continue;
+    }
+
+    BenchmarkComparison row;
+    row.name = result.name;
+    row.baselineMedian = entry->median;
+    row.currentMedian = result.median;
+    row.change = entry->median > 0 ? result.median / entry->median - 1 : 0;
+    row.pValue = mannWhitneyPValue(entry->samples, result.samples);
+    row.regression = report.comparable && row.change > options.threshold && row.pValue < options.significance;
+    report.rows.push_back(row);
+  }
+  return report;
+}
+
+bool hasBenchmarkRegression(const BenchmarkComparisonReport &report)
+{
+  return std::any_of(report.rows.begin(), report.rows.end(), [](const BenchmarkComparison &row) {
+    return row.regression;
+  });
+}
+
+void writeBenchmarkComparison(std::ostream &output, const BenchmarkBaseline &baseline, const BenchmarkComparisonReport &report)
+{
+  if (!report.comparable)
+  {
+    output << "Baseline was recorded on " << baseline.host.cpuModel << " with " << baseline.host.compiler << "; results are not comparable" << std::endl;
+  }
+
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-40s %14s %14s %9s %9s", "benchmark", "baseline ns", "current ns", "change", "p-value");
+  output << line << std::endl;
+  for (const BenchmarkComparison &row : report.rows)
+  {
+    std::snprintf(line, sizeof(line), "%-40s %14.3f %14.3f %+8.1f%% %9.4f%s", row.name.c_str(), row.baselineMedian, row.currentMedian, row.change * 100, row.pValue, row.regression ? "  REGRESSION" : "");
+    output << line << std::endl;
+  }
+  for (const std::string &name : report.missingFromBaseline)
+  {
+    output << name << " is not in the baseline" << std::endl;
+  }
+}
@@ -0,0 +1,61 @@
+#ifndef benchmark_comparison_hpp
+#define benchmark_comparison_hpp
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct BenchmarkBaselineEntry
+{
+  std::string name;
+  std::string unitName;
+  std::vector<double> samples;
+  double median = 0;
+};
+
+struct BenchmarkBaseline
+{
+  BenchmarkHost host;
+  std::vector<BenchmarkBaselineEntry> benchmarks;
+};
+
+struct BenchmarkComparisonOptions
+{
+  // Slowdowns smaller than this fraction of the baseline median never count.
+  double threshold = 0.05;
+  // Two-sided p-value below which a difference is treated as real.
+  double significance = 0.01;
+};
+
+struct BenchmarkComparison
+{
+  std::string name;
+  double baselineMedian = 0;
+  double currentMedian = 0;
+  double change = 0;
+  double pValue = 1;
+  bool regression = false;
+};
+
+struct BenchmarkComparisonReport
+{
+  bool comparable = true;
+  std::vector<BenchmarkComparison> rows;
+  std::vector<std::string> missingFromBaseline;
+};
+
+// Reads a file written by writeBenchmarkJson. Throws when the file is not
+// valid JSON or uses another format version.
+BenchmarkBaseline readBenchmarkBaseline(std::istream &input);
+
+// Samples are compared with a Mann-Whitney U test, so a regression needs both
+// a median slowdown past the threshold and a significant shift between the
+// sample sets. Runs on another host are marked as not comparable and never
+// report regressions.
+BenchmarkComparisonReport compareBenchmarks(const BenchmarkBaseline &baseline, const BenchmarkHost &host, const std::vector<BenchmarkResult> &results, const BenchmarkComparisonOptions &options);
+bool hasBenchmarkRegression(const BenchmarkComparisonReport &report);
+void writeBenchmarkComparison(std::ostream &output, const BenchmarkBaseline &baseline, const BenchmarkComparisonReport &report);
+
+#endif
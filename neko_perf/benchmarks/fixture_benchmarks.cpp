@@ -0,0 +1,31 @@
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_program_runner.hpp"
+
+NEKO_BENCHMARK_SUITE(fixture_benchmarks)
+{
+  for (const vpu_integration::IntegrationFixture &fixture : vpu_integration::integrationFixtures())
+  {
+    VPUProgramRunConfig config = fixture.config;
+    registerBenchmark("fixture_" + fixture.name, "fixtures", [config](BenchmarkState &state) {
+      VPU vpu;
+      VPUResetOptions resetOptions;
+      resetOptions.keepMicroMemory = true;
+      uint64_t emulatedCycles = 0;
+
+      for (uint64_t i = 0; i < state.iterations(); i++)
+      {
+        vpu.reset(resetOptions);
+        VPUProgramRunResult result = runVPUProgram(&vpu, config);
+        emulatedCycles += result.elapsedCycles;
+        doNotOptimize(result.outputMemory.data());
+      }
+
+      state.setUnits(emulatedCycles, "VU cycle");
+      state.setReferenceClock(VPU_CLOCK_HZ);
+    });
+  }
+}
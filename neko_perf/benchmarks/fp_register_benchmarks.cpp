@@ -0,0 +1,58 @@
+#include "benchmark.hpp"
+#include "fp_register.hpp"
+
+NEKO_BENCHMARK(fp_register_add)
+{
+  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
+  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
+  FPRegister reg3;
+
+  for (uint64_t i = 0; i < state.iterations(); i++)
+  {
+    doNotOptimize(reg1);
+    reg3.storeAdd(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    doNotOptimize(reg3);
+  }
+}
+
+NEKO_BENCHMARK(fp_register_sub)
+{
+  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
+  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
+  FPRegister reg3;
+
+  for (uint64_t i = 0; i < state.iterations(); i++)
+  {
+    doNotOptimize(reg1);
+    reg3.storeSub(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    doNotOptimize(reg3);
+  }
+}
+
+NEKO_BENCHMARK(fp_register_mul)
+{
+  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
+  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
+  FPRegister reg3;
+
+  for (uint64_t i = 0; i < state.iterations(); i++)
+  {
+    doNotOptimize(reg1);
+    reg3.storeMul(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    doNotOptimize(reg3);
+  }
+}
+
+NEKO_BENCHMARK(fp_register_div)
+{
+  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
+  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
+  FPRegister reg3;
+
+  for (uint64_t i = 0; i < state.iterations(); i++)
+  {
+    doNotOptimize(reg1);
+    reg3.storeDiv(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    doNotOptimize(reg3);
+  }
+}
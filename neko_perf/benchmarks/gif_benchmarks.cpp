@@ -0,0 +1,90 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "gif.hpp"
+
+#define GIF_BENCHMARK_PACKETS 16
+#define GIF_BENCHMARK_NLOOP 64
+
+namespace
+{
+  // Stands in for the GS: folds every write into a checksum so the parser's
+  // output cannot be optimised away.
+  class SinkHandler : public GIFPacketHandler
+  {
+    public:
+      uint64_t checksum = 0;
+
+      void gifTag(const GIFTag &tag) override
+      {
+        checksum += tag.nloop;
+      }
+
+      void writeRegister(uint8_t address, uint64_t value) override
+      {
+        checksum += address ^ value;
+      }
+
+      void writeImage(const uint8_t *data, size_t qwords) override
+      {
+        checksum += data[0] + qwords;
+      }
+  };
+
+  void appendDoublewords(std::vector<uint8_t> *chain, uint64_t low, uint64_t high)
+  {
+    size_t offset = chain->size();
+    chain->resize(offset + GIF_QWORD_BYTES);
+    memcpy(chain->data() + offset, &low, 8);
+    memcpy(chain->data() + offset + 8, &high, 8);
+  }
+
+  // A chain of GIF_BENCHMARK_PACKETS packets of GIF_BENCHMARK_NLOOP loops,
+  // the last one carrying EOP. PACKED packets are RGBAQ+XYZ2 triangle strips.
+  std::vector<uint8_t> packetChain(uint8_t flg)
+  {
+    uint64_t nreg = flg == GIF_FLG_IMAGE ? 1 : 2;
+    uint64_t regs = GIF_REG_RGBAQ | GIF_REG_XYZ2 << 4;
+    size_t dataQwords = flg == GIF_FLG_REGLIST ? GIF_BENCHMARK_NLOOP : GIF_BENCHMARK_NLOOP * nreg;
+
+    std::vector<uint8_t> chain;
+    for (uint64_t packet = 0; packet < GIF_BENCHMARK_PACKETS; packet++)
+    {
+      uint64_t eop = packet + 1 == GIF_BENCHMARK_PACKETS ? 1 : 0;
+      appendDoublewords(&chain, GIF_BENCHMARK_NLOOP | eop << 15 | static_cast<uint64_t>(flg) << 58 | nreg << 60, regs);
+      for (uint64_t qword = 0; qword < dataQwords; qword++)
+      {
+        appendDoublewords(&chain, qword * 0x0001000100010001, qword << 36 | 0x80);
+      }
+    }
+    return chain;
+  }
+}
+
+NEKO_BENCHMARK_SUITE(gif_benchmarks)
+{
+  const std::pair<const char *, uint8_t> modes[] = {
+    {"packed", GIF_FLG_PACKED},
+    {"reglist", GIF_FLG_REGLIST},
+    {"image", GIF_FLG_IMAGE}
+  };
+
+  for (const std::pair<const char *, uint8_t> &mode : modes)
+  {
+    std::vector<uint8_t> chain = packetChain(mode.second);
+    registerBenchmark(std::string("gif_") + mode.first, "gif", [chain](BenchmarkState &state) {
+      SinkHandler handler;
+      GIF gif(&handler);
+      size_t qwords = chain.size() / GIF_QWORD_BYTES;
+      for (uint64_t i = 0; i < state.iterations(); i++)
+      {
+        gif.processPacketChain(chain.data(), qwords);
+      }
+
+      doNotOptimize(handler.checksum);
+      state.setUnits(static_cast<double>(state.iterations()) * qwords, "qword");
+    });
+  }
+}
@@ -0,0 +1,225 @@
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "vpu.hpp"
+#include "vpu_disassembler.hpp"
+#include "vpu_opcodes.hpp"
+#include "vpu_register_ids.hpp"
+
+#define OPCODE_BENCHMARK_INSTANCES 1000
+#define OPCODE_BENCHMARK_CYCLE_BUDGET 100000
+#define OPCODE_BENCHMARK_ROTATION 8
+#define VPU_TYPE3_ESCAPE 0x3c
+
+namespace
+{
+  enum class OperandPattern
+  {
+    Independent,
+    Dependent
+  };
+
+  struct OpcodeStream
+  {
+    std::vector<uint8_t> microProgram;
+    std::vector<std::pair<int, int>> intRegisters;
+  };
+
+  // Returns the lower and upper words for one instance; a second pair is
+  // emitted after it when the instance needs a delay-slot filler.
+  typedef std::function<std::vector<uint32_t>(int instance)> InstanceWords;
+
+  void appendWord(std::vector<uint8_t> *program, uint32_t word)
+  {
+    program->push_back(word & 0xff);
+    program->push_back((word >> 8) & 0xff);
+    program->push_back((word >> 16) & 0xff);
+    program->push_back((word >> 24) & 0xff);
+  }
+
+  std::vector<uint8_t> unrolledProgram(const InstanceWords &instanceWords)
+  {
+    std::vector<uint8_t> program;
+    for (int instance = 0; instance < OPCODE_BENCHMARK_INSTANCES; instance++)
+    {
+      for (uint32_t word : instanceWords(instance))
+      {
+        appendWord(&program, word);
+      }
+    }
+    appendWord(&program, VPU_LOWER_NOP);
+    appendWord(&program, VPU_E_BIT | VPU_NOP);
+    appendWord(&program, VPU_LOWER_NOP);
+    appendWord(&program, VPU_NOP);
+    return program;
+  }
+
+  std::string mnemonic(const std::string &disassembly)
+  {
+    return disassembly.substr(0, disassembly.find_first_of(". "));
+  }
+
+  uint32_t rotatingRegister(uint32_t base, int instance)
+  {
+    return base + instance % OPCODE_BENCHMARK_ROTATION;
+  }
+
+  // Independent instances read VF01 and write a rotating destination, so no
+  // instance waits on an earlier one; dependent instances all use VF03.
+  uint32_t upperWord(uint16_t opCode, bool type1, OperandPattern pattern, int instance)
+  {
+    uint32_t fs = VPU_REGISTER_VF03;
+    uint32_t ft = VPU_REGISTER_VF03;
+    uint32_t fd = VPU_REGISTER_VF03;
+    if (pattern == OperandPattern::Independent)
+    {
+      fs = VPU_REGISTER_VF01;
+      ft = rotatingRegister(VPU_REGISTER_VF16, instance);
+      fd = rotatingRegister(VPU_REGISTER_VF08, instance);
+    }
+
+    uint32_t word = VPU_DEST_ALL_FIELDS | (ft << VPU_FT_REG_SHIFT) | (fs << VPU_FS_REG_SHIFT) | opCode;
+    return type1 ? word | (fd << VPU_FD_REG_SHIFT) : word;
+  }
+
+  uint32_t lowerRegisters(uint32_t it, uint32_t is)
+  {
+    return (it << 16) | (is << 11);
+  }
+
+  void runStream(const OpcodeStream &stream, BenchmarkState &state)
+  {
+    VPU vpu(VPUType::VU1);
+    VPUResetOptions resetOptions;
+    resetOptions.keepMicroMemory = true;
+    vpu.uploadMicroInstructions(stream.microProgram);
+
+    for (uint64_t i = 0; i < state.iterations(); i++)
+    {
+      vpu.reset(resetOptions);
+      for (int registerID = VPU_REGISTER_VF01; registerID <= VPU_REGISTER_VF31; registerID++)
+      {
+        vpu.loadFPRegister(registerID, 1.5 + registerID, -2.25, 0.75 * registerID, 3.0);
+      }
+      for (const std::pair<int, int> &value : stream.intRegisters)
+      {
+        vpu.loadIntRegister(value.first, value.second);
+      }
+
+      vpu.startMicroMode();
+      vpu.run(OPCODE_BENCHMARK_CYCLE_BUDGET);
+      if (vpu.getState() == VPU_STATE_RUN)
+      {
+        throw std::runtime_error("Opcode benchmark program did not terminate.");
+      }
+    }
+
+    doNotOptimize(vpu);
+    state.setUnits(static_cast<double>(state.iterations()) * OPCODE_BENCHMARK_INSTANCES, "instruction");
+  }
+
+  void registerStream(const std::string &name, const OpcodeStream &stream)
+  {
+    registerBenchmark(name, "opcodes", [stream](BenchmarkState &state) {
+      runStream(stream, state);
+    });
+  }
+
+  void registerUpperOpcode(uint16_t opCode, bool type1)
+  {
+    std::string name = "opcode_" + mnemonic(disassembleVPUUpperInstruction(upperWord(opCode, type1, OperandPattern::Dependent, 0)));
+    for (OperandPattern pattern : {OperandPattern::Independent, OperandPattern::Dependent})
+    {
+      OpcodeStream stream;
+      stream.microProgram = unrolledProgram([=](int instance) {
+        return std::vector<uint32_t>({VPU_LOWER_NOP, upperWord(opCode, type1, pattern, instance)});
+      });
+      registerStream(name + (pattern == OperandPattern::Independent ? "_independent" : "_dependent"), stream);
+    }
+  }
+
+  // Lower instances pair with an upper NOP. Pattern-specific register values
+  // keep loads and stores inside VU1 data memory.
+  void registerLowerOpcode(const std::function<uint32_t(OperandPattern pattern, int instance)> &lowerWord, const std::vector<std::pair<int, int>> &independentRegisters)
+  {
+    std::string name = "opcode_" + mnemonic(disassembleVPULowerInstruction(lowerWord(OperandPattern::Dependent, 0)));
+    for (OperandPattern pattern : {OperandPattern::Independent, OperandPattern::Dependent})
+    {
+      OpcodeStream stream;
+      stream.microProgram = unrolledProgram([=](int instance) {
+        return std::vector<uint32_t>({lowerWord(pattern, instance), VPU_NOP});
+      });
+      if (pattern == OperandPattern::Independent)
+      {
+        stream.intRegisters = independentRegisters;
+      }
+      registerStream(name + (pattern == OperandPattern::Independent ? "_independent" : "_dependent"), stream);
+    }
+  }
+
+  // Branches always carry their delay slot. Jumps land on the next instance
+  // because the delay slot advances the target register by one instance.
+  void registerBranchOpcode(uint32_t branchWord, uint32_t delaySlotWord, const std::string &suffix)
+  {
+    OpcodeStream stream;
+    stream.microProgram = unrolledProgram([=](int) {
+      return std::vector<uint32_t>({branchWord, VPU_NOP, delaySlotWord, VPU_NOP});
+    });
+    stream.intRegisters = {{VPU_REGISTER_VI01, 16}, {VPU_REGISTER_VI02, 16}};
+    registerStream("opcode_" + mnemonic(disassembleVPULowerInstruction(branchWord)) + suffix, stream);
+  }
+
+  uint32_t independentOr(OperandPattern pattern, uint32_t base, int instance)
+  {
+    return pattern == OperandPattern::Independent ? rotatingRegister(base, instance) : VPU_REGISTER_VI03;
+  }
+
+  uint32_t sourceOr(OperandPattern pattern, uint32_t source)
+  {
+    return pattern == OperandPattern::Independent ? source : VPU_REGISTER_VI03;
+  }
+}
+
+NEKO_BENCHMARK_SUITE(opcode_benchmarks)
+{
+  for (uint16_t opCode : type1OpCodeList)
+  {
+    // ADDAx-ADDAw have no FD field; setting one would decode as MSUBAx-w.
+    registerUpperOpcode(opCode, (opCode & VPU_TYPE3_ESCAPE) != VPU_TYPE3_ESCAPE);
+  }
+  for (uint16_t opCode : type3OpCodeList)
+  {
+    registerUpperOpcode(opCode, false);
+  }
+
+  registerLowerOpcode([](OperandPattern pattern, int instance) {
+    return VPU_IADD_ENCODING | lowerRegisters(sourceOr(pattern, VPU_REGISTER_VI02), sourceOr(pattern, VPU_REGISTER_VI01)) | (independentOr(pattern, VPU_REGISTER_VI08, instance) << 6);
+  }, {});
+  registerLowerOpcode([](OperandPattern pattern, int instance) {
+    return VPU_ISUBIU_ENCODING | lowerRegisters(independentOr(pattern, VPU_REGISTER_VI08, instance), sourceOr(pattern, VPU_REGISTER_VI01)) | 1;
+  }, {});
+  registerLowerOpcode([](OperandPattern pattern, int instance) {
+    return VPU_ILW_ENCODING | VPU_DEST_X_BIT | lowerRegisters(independentOr(pattern, VPU_REGISTER_VI08, instance), sourceOr(pattern, VPU_REGISTER_VI01));
+  }, {});
+  registerLowerOpcode([](OperandPattern pattern, int instance) {
+    return VPU_LQ_ENCODING | VPU_DEST_ALL_FIELDS | lowerRegisters(independentOr(pattern, VPU_REGISTER_VF08, instance), sourceOr(pattern, VPU_REGISTER_VI01));
+  }, {});
+  registerLowerOpcode([](OperandPattern pattern, int instance) {
+    return VPU_MFIR_ENCODING | VPU_DEST_ALL_FIELDS | lowerRegisters(independentOr(pattern, VPU_REGISTER_VF08, instance), sourceOr(pattern, VPU_REGISTER_VI01));
+  }, {});
+  registerLowerOpcode([](OperandPattern pattern, int instance) {
+    return VPU_SQI_ENCODING | VPU_DEST_ALL_FIELDS | lowerRegisters(independentOr(pattern, VPU_REGISTER_VI08, instance), sourceOr(pattern, VPU_REGISTER_VF01));
+  }, {
+    {VPU_REGISTER_VI08, 0}, {VPU_REGISTER_VI09, 128}, {VPU_REGISTER_VI10, 256}, {VPU_REGISTER_VI11, 384},
+    {VPU_REGISTER_VI12, 512}, {VPU_REGISTER_VI13, 640}, {VPU_REGISTER_VI14, 768}, {VPU_REGISTER_VI15, 896}
+  });
+
+  uint32_t advanceTarget = VPU_IADD_ENCODING | lowerRegisters(VPU_REGISTER_VI02, VPU_REGISTER_VI01) | (VPU_REGISTER_VI01 << 6);
+  registerBranchOpcode(VPU_IBNE_ENCODING | lowerRegisters(VPU_REGISTER_VI01, VPU_REGISTER_VI01), VPU_LOWER_NOP, "_not_taken");
+  registerBranchOpcode(VPU_JR_ENCODING | lowerRegisters(0, VPU_REGISTER_VI01), advanceTarget, "_chain");
+  registerBranchOpcode(VPU_JALR_ENCODING | lowerRegisters(VPU_REGISTER_VI03, VPU_REGISTER_VI01), advanceTarget, "_chain");
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "neko_system.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_program_runner.hpp"
+
+#define SCALING_BENCHMARK_FIXTURE "vector_kernel"
+
+namespace
+{
+  // Each thread owns a VPU it constructs itself and runs the fixture for the
+  // full iteration count, so ideal scaling keeps per-thread throughput flat.
+  void runFixtureThreads(const VPUProgramRunConfig &config, unsigned int threadCount, BenchmarkState &state)
+  {
+    std::vector<uint64_t> emulatedCycles(threadCount);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (unsigned int thread = 0; thread < threadCount; thread++)
+    {
+      threads.emplace_back([&config, &emulatedCycles, &state, thread]() {
+        VPU vpu;
+        VPUResetOptions resetOptions;
+        resetOptions.keepMicroMemory = true;
+        uint64_t cycles = 0;
+        for (uint64_t i = 0; i < state.iterations(); i++)
+        {
+          vpu.reset(resetOptions);
+          VPUProgramRunResult result = runVPUProgram(&vpu, config);
+          cycles += result.elapsedCycles;
+          doNotOptimize(result.outputMemory.data());
+        }
+        emulatedCycles[thread] = cycles;
+      });
+    }
+    for (std::thread &thread : threads)
+    {
+      thread.join();
+    }
+
+    uint64_t totalCycles = 0;
+    for (uint64_t cycles : emulatedCycles)
+    {
+      totalCycles += cycles;
+    }
+    state.setUnits(totalCycles, "VU cycle");
+    state.setReferenceClock(VPU_CLOCK_HZ);
+    state.setThreads(threadCount);
+  }
+
+  void loadFixture(VPU *vpu, const VPUProgramRunConfig &config)
+  {
+    for (const VPUDataMemoryWrite &write : config.inputMemory)
+    {
+      vpu->writeDataMemory(write.address, write.data);
+    }
+    vpu->startMicroMode(config.startAddress);
+  }
+
+  // Runs the fixture on VU0 and VU1 together inside one NekoSystem, so the
+  // parallel variant pays the handoff cost at every slice end. Idle VUs keep
+  // counting cycles, so the system runs only as long as the fixture does.
+  void runSystemFixture(const VPUProgramRunConfig &config, SchedulerExecution execution, BenchmarkState &state)
+  {
+    VPU reference;
+    uint64_t fixtureCycles = runVPUProgram(&reference, config).elapsedCycles;
+
+    NekoSystem system;
+    system.scheduler().setExecution(execution);
+    system.vu0().uploadMicroInstructions(config.microProgram);
+    system.vu1().uploadMicroInstructions(config.microProgram);
+    VPUResetOptions resetOptions;
+    resetOptions.keepMicroMemory = true;
+
+    for (uint64_t i = 0; i < state.iterations(); i++)
+    {
+      system.resetVU(VPUType::VU0, resetOptions);
+      system.resetVU(VPUType::VU1, resetOptions);
+      loadFixture(&system.vu0(), config);
+      loadFixture(&system.vu1(), config);
+      system.runUntil(system.masterTick() + fixtureCycles * NEKO_VU_CLOCK_DIVIDER);
+      if (system.vu0().getState() == VPU_STATE_RUN || system.vu1().getState() == VPU_STATE_RUN)
+      {
+        throw std::runtime_error("System benchmark fixture did not terminate.");
+      }
+    }
+
+    doNotOptimize(system.vu1());
+    state.setUnits(static_cast<double>(state.iterations()) * fixtureCycles * 2, "VU cycle");
+    state.setReferenceClock(VPU_CLOCK_HZ);
+    state.setThreads(execution == SchedulerExecution::Parallel ? 2 : 1);
+  }
+}
+
+NEKO_BENCHMARK_SUITE_WITH_OPTIONS(scaling_benchmarks, options)
+{
+  unsigned int maxThreads = options.maxThreads;
+  if (maxThreads == 0)
+  {
+    maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<unsigned int> threadCounts;
+  for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+  {
+    threadCounts.push_back(threads);
+  }
+  threadCounts.push_back(maxThreads);
+
+  for (const vpu_integration::IntegrationFixture &fixture : vpu_integration::integrationFixtures())
+  {
+    if (fixture.name != SCALING_BENCHMARK_FIXTURE)
+    {
+      continue;
+    }
+
+    VPUProgramRunConfig config = fixture.config;
+    for (unsigned int threads : threadCounts)
+    {
+      registerBenchmark("scaling_" + fixture.name + "_threads_" + std::to_string(threads), "scaling_" + fixture.name, [config, threads](BenchmarkState &state) {
+        runFixtureThreads(config, threads, state);
+      });
+    }
+    registerBenchmark("scaling_system_" + fixture.name + "_serial", "scaling_system_" + fixture.name, [config](BenchmarkState &state) {
+      runSystemFixture(config, SchedulerExecution::Serial, state);
+    });
+    registerBenchmark("scaling_system_" + fixture.name + "_parallel", "scaling_system_" + fixture.name, [config](BenchmarkState &state) {
+      runSystemFixture(config, SchedulerExecution::Parallel, state);
+    });
+  }
+}
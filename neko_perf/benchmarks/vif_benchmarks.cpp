@@ -0,0 +1,71 @@
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "vif.hpp"
+
+#define VIF_BENCHMARK_UNPACKS 4
+#define VIF_BENCHMARK_UNPACK_QWORDS 256
+
+namespace
+{
+  struct UnpackCase
+  {
+    const char *name;
+    VIFUnpackFormat format;
+    bool masked;
+  };
+
+  // Fills VU1 data memory with back-to-back 256-qword UNPACKs, the shape of a
+  // VIF1 DMA chain feeding vertex data.
+  std::vector<uint32_t> unpackStream(const UnpackCase &unpack)
+  {
+    std::vector<uint32_t> stream = {
+      VIF_CMD_STCYCL << 24 | 0x0101,
+      VIF_CMD_STMASK << 24, 0x5555aaff
+    };
+    size_t dataWords = (VIF_BENCHMARK_UNPACK_QWORDS * vifUnpackElementBytes(unpack.format) + 3) / 4;
+    for (uint32_t block = 0; block < VIF_BENCHMARK_UNPACKS; block++)
+    {
+      uint32_t command = VIF_CMD_UNPACK | static_cast<uint32_t>(unpack.format) | (unpack.masked ? VIF_UNPACK_MASK_BIT : 0);
+      stream.push_back(command << 24 | block * VIF_BENCHMARK_UNPACK_QWORDS);
+      for (size_t word = 0; word < dataWords; word++)
+      {
+        stream.push_back(static_cast<uint32_t>(word * 0x01010101));
+      }
+    }
+    return stream;
+  }
+}
+
+NEKO_BENCHMARK_SUITE(vif_benchmarks)
+{
+  const UnpackCase cases[] = {
+    {"S_32", VIFUnpackFormat::S32, false},
+    {"S_16", VIFUnpackFormat::S16, false},
+    {"V2_32", VIFUnpackFormat::V2_32, false},
+    {"V3_32", VIFUnpackFormat::V3_32, false},
+    {"V3_16", VIFUnpackFormat::V3_16, false},
+    {"V4_32", VIFUnpackFormat::V4_32, false},
+    {"V4_16", VIFUnpackFormat::V4_16, false},
+    {"V4_8", VIFUnpackFormat::V4_8, false},
+    {"V4_5", VIFUnpackFormat::V4_5, false},
+    {"V4_32_masked", VIFUnpackFormat::V4_32, true}
+  };
+
+  for (const UnpackCase &unpack : cases)
+  {
+    std::vector<uint32_t> stream = unpackStream(unpack);
+    registerBenchmark(std::string("vif_unpack_") + unpack.name, "vif_unpack", [stream](BenchmarkState &state) {
+      VPU vpu(VPUType::VU1);
+      VIF vif(&vpu);
+      for (uint64_t i = 0; i < state.iterations(); i++)
+      {
+        vif.write(stream.data(), stream.size());
+      }
+
+      doNotOptimize(vpu.dataMemory()[0]);
+      state.setUnits(static_cast<double>(state.iterations()) * VIF_BENCHMARK_UNPACKS * VIF_BENCHMARK_UNPACK_QWORDS, "qword");
+    });
+  }
+}
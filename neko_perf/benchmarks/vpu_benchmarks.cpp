@@ -0,0 +1,75 @@
+#include <vector>
+
+#include "benchmark.hpp"
+#include "vpu.hpp"
+#include "vpu_opcodes.hpp"
+#include "vpu_register_ids.hpp"
+
+#define VPU_BENCHMARK_LOOP_COUNT 1000
+
+namespace
+{
+  // ADD.xyzw VF03, VF01, VF02 | ISUBIU VI01, VI01, 1
+  // ADD.xyzw VF04, VF03, VF02 | IBNE VI01, VI00, loop
+  // NOP
+  // NOP[E]
+  // NOP
+  vector<uint8_t> vpuLoopProgram()
+  {
+    uint32_t add3 = VPU_DEST_ALL_FIELDS | (VPU_REGISTER_VF02 << VPU_FT_REG_SHIFT) | (VPU_REGISTER_VF01 << VPU_FS_REG_SHIFT) | (VPU_REGISTER_VF03 << VPU_FD_REG_SHIFT) | VPU_ADD;
+    uint32_t add4 = VPU_DEST_ALL_FIELDS | (VPU_REGISTER_VF02 << VPU_FT_REG_SHIFT) | (VPU_REGISTER_VF03 << VPU_FS_REG_SHIFT) | (VPU_REGISTER_VF04 << VPU_FD_REG_SHIFT) | VPU_ADD;
+    uint32_t isubiu = VPU_ISUBIU_ENCODING | (VPU_REGISTER_VI01 << 16) | (VPU_REGISTER_VI01 << 11) | 1;
+    uint32_t ibne = VPU_IBNE_ENCODING | (VPU_REGISTER_VI01 << 16) | (VPU_REGISTER_VI00 << 11) | (static_cast<uint16_t>(-2) & 0x7ff);
+    uint32_t words[] = {
+      isubiu, add3,
+      ibne, add4,
+      VPU_LOWER_NOP, VPU_NOP,
+      VPU_LOWER_NOP, VPU_E_BIT | VPU_NOP,
+      VPU_LOWER_NOP, VPU_NOP
+    };
+
+    vector<uint8_t> program;
+    for (uint32_t word : words)
+    {
+      program.push_back(word & 0xff);
+      program.push_back((word >> 8) & 0xff);
+      program.push_back((word >> 16) & 0xff);
+      program.push_back((word >> 24) & 0xff);
+    }
+    return program;
+  }
+}
+
+NEKO_BENCHMARK(vpu_construct)
+{
+  for (uint64_t i = 0; i < state.iterations(); i++)
+  {
+    VPU vpu;
+    doNotOptimize(vpu);
+  }
+}
+
+NEKO_BENCHMARK(vpu_loop)
+{
+  VPU vpu;
+  VPUResetOptions resetOptions;
+  resetOptions.keepMicroMemory = true;
+  vpu.uploadMicroInstructions(vpuLoopProgram());
+  uint64_t emulatedCycles = 0;
+
+  for (uint64_t i = 0; i < state.iterations(); i++)
+  {
+    vpu.reset(resetOptions);
+    vpu.loadIntRegister(VPU_REGISTER_VI01, VPU_BENCHMARK_LOOP_COUNT);
+    vpu.startMicroMode();
+    while (vpu.getState() == VPU_STATE_RUN)
+    {
+      vpu.tick();
+    }
+    emulatedCycles += vpu.elapsedCycles();
+  }
+
+  doNotOptimize(vpu);
+  state.setUnits(emulatedCycles, "VU cycle");
+  state.setReferenceClock(VPU_CLOCK_HZ);
+}
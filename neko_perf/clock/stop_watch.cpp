@@ -7,10 +7,7 @@ void StopWatch::start()
   startTime = std::chrono::high_resolution_clock::now();
 }
 
-double StopWatch::elapsedCycles()
+double StopWatch::elapsedNanoseconds()
 {
-  double elapsedTime = std::chrono::nanoseconds(std::chrono::high_resolution_clock::now() - startTime).count();
-  double cyclesPerNanosecond = 0.294;
-
-  return elapsedTime * cyclesPerNanosecond;
+  return std::chrono::nanoseconds(std::chrono::high_resolution_clock::now() - startTime).count();
 }
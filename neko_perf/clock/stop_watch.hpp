@@ -7,7 +7,7 @@ class StopWatch
 {
   public:
     void start();
-    double elapsedCycles();
+    double elapsedNanoseconds();
   private:
     std::chrono::high_resolution_clock::time_point startTime;
 };
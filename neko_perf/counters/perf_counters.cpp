@@ -0,0 +1,161 @@
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+  struct CounterConfig
+  {
+    std::uint32_t type;
+    std::uint64_t config;
+  };
+
+  const CounterConfig counterConfigs[PERF_COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {
+      PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_L1D |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+    },
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}
+  };
+
+  // Members of a group are enabled, disabled and multiplexed together with
+  // their leader, so ratios between them cover the same time window.
+  int openCounter(const CounterConfig &counter, int groupLeader)
+  {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = counter.type;
+    attributes.config = counter.config;
+    attributes.disabled = groupLeader < 0 ? 1 : 0;
+    attributes.inherit = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP |
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(
+      syscall(__NR_perf_event_open, &attributes, 0, -1, groupLeader, 0));
+  }
+#endif
+}
+
+PerfCounters::PerfCounters()
+{
+  descriptors.fill(-1);
+#ifdef __linux__
+  descriptors[0] = openCounter(counterConfigs[0], -1);
+  for (int counter = 1; counter < PERF_COUNTER_COUNT && descriptors[0] >= 0; counter++)
+  {
+    descriptors[counter] = openCounter(counterConfigs[counter], descriptors[0]);
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for (int descriptor : descriptors)
+  {
+    if (descriptor >= 0)
+    {
+      close(descriptor);
+    }
+  }
+#endif
+}
+
+bool PerfCounters::anyAvailable() const
+{
+  for (int descriptor : descriptors)
+  {
+    if (descriptor >= 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+  if (descriptors[0] >= 0)
+  {
+    ioctl(descriptors[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(descriptors[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+PerfCounterReading PerfCounters::stop()
+{
+  PerfCounterReading reading;
+#ifdef __linux__
+  if (descriptors[0] < 0)
+  {
+    return reading;
+  }
+  ioctl(descriptors[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  // member count, time enabled, time running, then one value per member in
+  // the order the members joined the group
+  std::uint64_t values[3 + PERF_COUNTER_COUNT];
+  ssize_t bytes = read(descriptors[0], values, sizeof(values));
+  if (bytes < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) ||
+      bytes != static_cast<ssize_t>((3 + values[0]) * sizeof(std::uint64_t)) ||
+      values[2] == 0)
+  {
+    return reading;
+  }
+
+  // Scale up a group the kernel multiplexed off the PMU for part of the run.
+  std::uint64_t member = 0;
+  for (int counter = 0; counter < PERF_COUNTER_COUNT && member < values[0]; counter++)
+  {
+    if (descriptors[counter] < 0)
+    {
+      continue;
+    }
+
+    reading.available[counter] = true;
+    reading.values[counter] =
+      static_cast<double>(values[3 + member]) * values[1] / values[2];
+    member++;
+  }
+#endif
+
+  return reading;
+}
+
+const char *perfCounterName(PerfCounter counter)
+{
+  switch (counter)
+  {
+    case PerfCounter::Cycles:
+      return "cycles";
+    case PerfCounter::Instructions:
+      return "instructions";
+    case PerfCounter::BranchMisses:
+      return "branch-misses";
+    case PerfCounter::L1DataMisses:
+      return "L1-dcache-load-misses";
+    case PerfCounter::LastLevelCacheMisses:
+      return "LLC-misses";
+  }
+
+  return "unknown";
+}
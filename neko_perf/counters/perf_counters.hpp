@@ -0,0 +1,45 @@
+#ifndef perf_counters_hpp
+#define perf_counters_hpp
+
+#include <array>
+#include <cstdint>
+
+#define PERF_COUNTER_COUNT 5
+
+enum class PerfCounter
+{
+  Cycles,
+  Instructions,
+  BranchMisses,
+  L1DataMisses,
+  LastLevelCacheMisses
+};
+
+struct PerfCounterReading
+{
+  std::array<bool, PERF_COUNTER_COUNT> available = {};
+  std::array<double, PERF_COUNTER_COUNT> values = {};
+};
+
+// Host hardware counters read through Linux perf_event_open as one group led
+// by the cycle counter. They count the constructing thread and every thread it
+// creates afterwards, so construct them before any benchmark threads. Counters
+// the kernel or CPU refuses stay unavailable, and every counter is unavailable
+// on other platforms or when the cycle counter cannot be opened.
+class PerfCounters
+{
+  public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    bool anyAvailable() const;
+    void start();
+    PerfCounterReading stop();
+  private:
+    std::array<int, PERF_COUNTER_COUNT> descriptors;
+};
+
+const char *perfCounterName(PerfCounter counter);
+
+#endif
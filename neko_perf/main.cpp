@@ -1,102 +1,114 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 
-#include "fp_register.hpp"
-#include "floating_point_ops.hpp"
-#include "stop_watch.hpp"
-#include "vpu.hpp"
+#include "benchmark.hpp"
+#include "benchmark_comparison.hpp"
+#include "perf_counters.hpp"
 
 using namespace std;
 
-void runFPPerf();
-void runFPAddPerf();
-void runFPSubPerf();
-void runFPMulPerf();
-void runFPDivPerf();
-void runVPUPerf();
+#define USAGE "usage: neko_perf [--filter substring] [--samples count] [--min-sample-ms ms] [--max-threads count] [--output file] [--baseline file] [--threshold percent]"
 
+// Results are written as JSON to stdout, or to --output. With --baseline the
+// run is compared against an earlier output file and the exit status is 2
+// when any benchmark regressed by more than --threshold percent.
 int main(int argc, const char * argv[])
 {
-  runFPPerf();
-  runVPUPerf();
-}
-
-void runFPPerf()
-{
-  runFPAddPerf();
-  runFPSubPerf();
-  runFPMulPerf();
-  runFPDivPerf();
-}
-
-void runFPAddPerf()
-{
-  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
-  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
-  FPRegister reg3;
-
-  StopWatch watch;
-  watch.start();
-
-  for (int i = 0; i < 10000; i++)
+  BenchmarkOptions options;
+  BenchmarkComparisonOptions comparisonOptions;
+  const char *outputPath = nullptr;
+  const char *baselinePath = nullptr;
+  for (int arg = 1; arg < argc; arg++)
   {
-    reg3.storeAdd(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    if (strcmp(argv[arg], "--filter") == 0 && arg + 1 < argc)
+    {
+      options.filter = argv[++arg];
+    }
+    else if (strcmp(argv[arg], "--samples") == 0 && arg + 1 < argc)
+    {
+      options.sampleCount = atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--min-sample-ms") == 0 && arg + 1 < argc)
+    {
+      options.minimumSampleNanoseconds = atof(argv[++arg]) * 1000000;
+    }
+    else if (strcmp(argv[arg], "--max-threads") == 0 && arg + 1 < argc)
+    {
+      options.maxThreads = atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "--output") == 0 && arg + 1 < argc)
+    {
+      outputPath = argv[++arg];
+    }
+    else if (strcmp(argv[arg], "--baseline") == 0 && arg + 1 < argc)
+    {
+      baselinePath = argv[++arg];
+    }
+    else if (strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc)
+    {
+      comparisonOptions.threshold = atof(argv[++arg]) / 100;
+    }
+    else
+    {
+      cerr << USAGE << endl;
+      return 1;
+    }
   }
 
-  printf("It took %f cycles to add two FP Registers\n", watch.elapsedCycles() / 10000);
-}
-
-void runFPSubPerf()
-{
-  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
-  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
-  FPRegister reg3;
-
-  StopWatch watch;
-  watch.start();
-
-  for (int i = 0; i < 10000; i++)
+  BenchmarkBaseline baseline;
+  if (baselinePath)
   {
-    reg3.storeSub(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    ifstream baselineFile(baselinePath);
+    if (!baselineFile)
+    {
+      cerr << "Could not open benchmark baseline " << baselinePath << endl;
+      return 1;
+    }
+
+    try
+    {
+      baseline = readBenchmarkBaseline(baselineFile);
+    }
+    catch (const runtime_error &error)
+    {
+      cerr << error.what() << endl;
+      return 1;
+    }
   }
 
-  printf("It took %f cycles to subtract two FP Registers\n", watch.elapsedCycles() / 10000);
-}
-
-void runFPMulPerf()
-{
-  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
-  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
-  FPRegister reg3;
-
-  StopWatch watch;
-  watch.start();
-
-  for (int i = 0; i < 10000; i++)
+  PerfCounters perfCounters;
+  if (!perfCounters.anyAvailable())
   {
-    reg3.storeMul(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    cerr << "Host performance counters are unavailable; reporting wall-clock time only" << endl;
   }
 
-  printf("It took %f cycles to multiply two FP Registers\n", watch.elapsedCycles() / 10000);
-}
-
-void runFPDivPerf()
-{
-  FPRegister reg1(1.0f, 2.0f, 3.0f, 4.0f);
-  FPRegister reg2(2.0f, 3.0f, 4.0f, 5.0f);
-  FPRegister reg3;
-
-  StopWatch watch;
-  watch.start();
-
-  for (int i = 0; i < 10000; i++)
+  BenchmarkHost host = currentBenchmarkHost();
+  vector<BenchmarkResult> results = runBenchmarks(options, &perfCounters);
+  if (outputPath)
   {
-    reg3.storeDiv(&reg1, &reg2, FP_REGISTER_ALL_FIELDS);
+    ofstream outputFile(outputPath);
+    writeBenchmarkJson(outputFile, host, results);
+    if (!outputFile)
+    {
+      cerr << "Could not write benchmark results to " << outputPath << endl;
+      return 1;
+    }
+  }
+  else
+  {
+    writeBenchmarkJson(cout, host, results);
   }
 
-  printf("It took %f cycles to divide two FP Registers\n", watch.elapsedCycles() / 10000);
-}
-
-void runVPUPerf()
-{
-  VPU vpu;
+  if (baselinePath)
+  {
+    BenchmarkComparisonReport report = compareBenchmarks(baseline, host, results, comparisonOptions);
+    writeBenchmarkComparison(cerr, baseline, report);
+    if (hasBenchmarkRegression(report))
+    {
+      return 2;
+    }
+  }
 }
@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "catch.hpp"
+#include "gif.hpp"
+
+namespace
+{
+  typedef std::pair<std::uint8_t, std::uint64_t> RegisterWrite;
+
+  class RecordingHandler : public GIFPacketHandler
+  {
+    public:
+      std::vector<GIFTag> tags;
+      std::vector<RegisterWrite> writes;
+      std::vector<std::pair<const std::uint8_t *, std::size_t>> images;
+
+      void gifTag(const GIFTag &tag) override
+      {
+        tags.push_back(tag);
+      }
+
+      void writeRegister(std::uint8_t address, std::uint64_t value) override
+      {
+        writes.push_back(RegisterWrite(address, value));
+      }
+
+      void writeImage(const std::uint8_t *data, std::size_t qwords) override
+      {
+        images.push_back(std::make_pair(data, qwords));
+      }
+  };
+
+  void appendDoublewords(
+    std::vector<std::uint8_t> *packet,
+    std::uint64_t low,
+    std::uint64_t high)
+  {
+    std::size_t offset = packet->size();
+    packet->resize(offset + 16);
+    std::memcpy(packet->data() + offset, &low, 8);
+    std::memcpy(packet->data() + offset + 8, &high, 8);
+  }
+
+  void appendWords(
+    std::vector<std::uint8_t> *packet,
+    std::uint32_t x,
+    std::uint32_t y,
+    std::uint32_t z,
+    std::uint32_t w)
+  {
+    appendDoublewords(
+      packet,
+      x | static_cast<std::uint64_t>(y) << 32,
+      z | static_cast<std::uint64_t>(w) << 32);
+  }
+
+  void appendTag(
+    std::vector<std::uint8_t> *packet,
+    std::uint16_t nloop,
+    bool eop,
+    std::uint8_t flg,
+    std::uint8_t nreg,
+    std::uint64_t regs,
+    bool pre = false,
+    std::uint16_t prim = 0)
+  {
+    std::uint64_t low = nloop | static_cast<std::uint64_t>(eop) << 15 |
+      static_cast<std::uint64_t>(pre) << 46 |
+      static_cast<std::uint64_t>(prim) << 47 |
+      static_cast<std::uint64_t>(flg) << 58 |
+      static_cast<std::uint64_t>(nreg & 0xf) << 60;
+    appendDoublewords(packet, low, regs);
+  }
+}
+
+TEST_CASE("GIF")
+{
+  RecordingHandler handler;
+  GIF gif(&handler);
+  std::vector<std::uint8_t> packet;
+
+  SECTION("Tags decode every field")
+  {
+    appendTag(&packet, 0x7fff, true, GIF_FLG_REGLIST, 0, 0x123456789abcdef0,
+      true, 0x7ff);
+    GIFTag tag = decodeGIFTag(packet.data());
+
+    REQUIRE(tag.nloop == 0x7fff);
+    REQUIRE(tag.eop);
+    REQUIRE(tag.pre);
+    REQUIRE(tag.prim == 0x7ff);
+    REQUIRE(tag.flg == GIF_FLG_REGLIST);
+    REQUIRE(tag.nreg == 16);
+    REQUIRE(tag.reg(0) == 0x0);
+    REQUIRE(tag.reg(15) == 0x1);
+  }
+
+  SECTION("PACKED data converts to GS register writes")
+  {
+    appendTag(&packet, 1, false, GIF_FLG_PACKED, 8, 0xfea45123,
+      true, 0x13);
+    appendWords(&packet, 0x12341234, 0x56785678, 0, 0);
+    appendWords(&packet, 0x3f000000, 0x3f800000, 0x40000000, 0);
+    appendWords(&packet, 1, 2, 3, 4);
+    appendWords(&packet, 0x1234, 0x5678, 0x9abcdef0, 0);
+    appendWords(&packet, 0x10, 0x20, 0x12345670, 0x8ab0);
+    appendWords(&packet, 0, 0, 0, 0x120);
+    appendWords(&packet, 0x55667788, 0x11223344, 0x3f, 0);
+    appendWords(&packet, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff);
+    appendTag(&packet, 1, true, GIF_FLG_PACKED, 1, GIF_REG_RGBAQ);
+    appendWords(&packet, 5, 6, 7, 8);
+
+    REQUIRE(gif.processPacketChain(packet.data(), packet.size() / 16) == 11);
+    REQUIRE(handler.writes == std::vector<RegisterWrite>({
+      {GIF_REG_PRIM, 0x13},
+      {GIF_REG_UV, 0x16781234},
+      {GIF_REG_ST, 0x3f8000003f000000},
+      {GIF_REG_RGBAQ, 0x4000000004030201},
+      {GIF_REG_XYZ2, 0x9abcdef056781234},
+      {GS_REG_XYZF3, 0xab23456700200010},
+      {GIF_REG_FOG, 0x1200000000000000},
+      {0x3f, 0x1122334455667788},
+      {GIF_REG_RGBAQ, 0x3f80000008070605}
+    }));
+  }
+
+  SECTION("REGLIST data passes doublewords through")
+  {
+    appendTag(&packet, 1, true, GIF_FLG_REGLIST, 3,
+      GIF_REG_PRIM | GIF_REG_AD << 4 | 0x6 << 8);
+    appendDoublewords(&packet, 0x1111, 0x2222);
+    appendDoublewords(&packet, 0x3333, 0x4444);
+
+    REQUIRE(gif.processPacket(packet.data(), packet.size() / 16) == 3);
+    REQUIRE(handler.writes == std::vector<RegisterWrite>({
+      {GIF_REG_PRIM, 0x1111},
+      {0x6, 0x3333}
+    }));
+  }
+
+  SECTION("IMAGE data is handed over in place")
+  {
+    appendTag(&packet, 3, true, GIF_FLG_IMAGE, 1, 0);
+    for (int qword = 0; qword < 3; qword++)
+    {
+      appendWords(&packet, qword, qword, qword, qword);
+    }
+
+    REQUIRE(gif.processPacket(packet.data(), packet.size() / 16) == 4);
+    REQUIRE(handler.images.size() == 1);
+    REQUIRE(handler.images[0].first == packet.data() + 16);
+    REQUIRE(handler.images[0].second == 3);
+  }
+
+  SECTION("Chains stop after the EOP tag")
+  {
+    appendTag(&packet, 1, false, GIF_FLG_IMAGE, 1, 0);
+    appendWords(&packet, 0, 0, 0, 0);
+    appendTag(&packet, 0, false, GIF_FLG_PACKED, 1, 0);
+    appendTag(&packet, 1, true, GIF_FLG_REGLIST, 1, GIF_REG_PRIM);
+    appendDoublewords(&packet, 7, 0);
+    appendTag(&packet, 1, true, GIF_FLG_IMAGE, 1, 0);
+
+    REQUIRE(gif.processPacketChain(packet.data(), packet.size() / 16) == 5);
+    REQUIRE(handler.tags.size() == 3);
+    REQUIRE(handler.writes == std::vector<RegisterWrite>({{GIF_REG_PRIM, 7}}));
+  }
+
+  SECTION("Packets that overrun the buffer are rejected")
+  {
+    appendTag(&packet, 2, false, GIF_FLG_PACKED, 1, 0);
+    appendWords(&packet, 0, 0, 0, 0);
+    appendWords(&packet, 0, 0, 0, 0);
+
+    REQUIRE_THROWS_WITH(
+      gif.processPacket(packet.data(), 2),
+      "GIF packet exceeds its buffer.");
+    REQUIRE_THROWS_WITH(
+      gif.processPacketChain(packet.data(), 3),
+      "GIF packet exceeds its buffer.");
+    REQUIRE(handler.tags.size() == 1);
+  }
+}
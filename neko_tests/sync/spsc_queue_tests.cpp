@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <thread>
+
+#include "catch.hpp"
+#include "spsc_queue.hpp"
+
+TEST_CASE("SPSC Queue")
+{
+  SECTION("Capacity is rounded up to a power of two")
+  {
+    SPSCQueue<int> queue(5);
+
+    REQUIRE(queue.capacity() == 8);
+    REQUIRE_THROWS_WITH(
+      SPSCQueue<int>(0),
+      "SPSC queue capacity must be greater than zero.");
+  }
+
+  SECTION("Values come out in order and a full queue rejects pushes")
+  {
+    SPSCQueue<int> queue(4);
+    int value = 0;
+
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.tryPop(&value));
+    for (int index = 0; index < 4; index++)
+    {
+      REQUIRE(queue.tryPush(index));
+    }
+    REQUIRE_FALSE(queue.tryPush(4));
+
+    for (int index = 0; index < 4; index++)
+    {
+      REQUIRE(queue.tryPop(&value));
+      REQUIRE(value == index);
+    }
+    REQUIRE(queue.empty());
+    REQUIRE(queue.tryPush(5));
+    REQUIRE(queue.tryPop(&value));
+    REQUIRE(value == 5);
+  }
+
+  SECTION("A producer and consumer thread exchange every value in order")
+  {
+    constexpr std::uint32_t valueCount = 200000;
+    SPSCQueue<std::uint32_t> queue(64);
+    std::thread producer([&queue]() {
+      for (std::uint32_t value = 0; value < valueCount; value++)
+      {
+        while (!queue.tryPush(value))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+    bool ordered = true;
+    std::uint32_t expected = 0;
+    while (expected < valueCount)
+    {
+      std::uint32_t value;
+      if (queue.tryPop(&value))
+      {
+        ordered = ordered && value == expected;
+        expected++;
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+  }
+}
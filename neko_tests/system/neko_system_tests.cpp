@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <vector>
+
+#include "catch.hpp"
+#include "neko_system.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+
+namespace
+{
+  void loadFixture(
+    VPU *vpu,
+    const vpu_integration::IntegrationFixture &fixture)
+  {
+    vpu->uploadMicroInstructions(fixture.config.microProgram);
+    for (const VPUDataMemoryWrite &write : fixture.config.inputMemory)
+    {
+      vpu->writeDataMemory(write.address, write.data);
+    }
+    vpu->startMicroMode(fixture.config.startAddress);
+  }
+
+  std::vector<std::uint8_t> outputOf(
+    const VPU &vpu,
+    const vpu_integration::IntegrationFixture &fixture)
+  {
+    return vpu.readDataMemory(
+      fixture.config.outputAddress,
+      fixture.config.outputSize);
+  }
+}
+
+TEST_CASE("Neko System")
+{
+  std::vector<vpu_integration::IntegrationFixture> fixtures =
+    vpu_integration::integrationFixtures();
+
+  SECTION("The VUs run at half the master clock")
+  {
+    NekoSystem system;
+    VPU standalone;
+    loadFixture(&system.vu0(), fixtures[0]);
+    loadFixture(&standalone, fixtures[0]);
+
+    system.runUntil(2 * 10 + 1);
+    standalone.run(10);
+
+    REQUIRE(NEKO_VU_CLOCK_DIVIDER == 2);
+    REQUIRE(system.masterTick() == 21);
+    REQUIRE(system.vu0().elapsedCycles() == 10);
+    REQUIRE(system.vu0().programCounter() == standalone.programCounter());
+  }
+
+  SECTION("Slice granularity does not change VU results")
+  {
+    for (std::uint64_t slice : {1, 7, 4096})
+    {
+      NekoSystem system(slice);
+      loadFixture(&system.vu0(), fixtures[0]);
+      loadFixture(&system.vu1(), fixtures[4]);
+
+      system.runUntil(20000);
+
+      VPU vu0;
+      VPU vu1(VPUType::VU1);
+      loadFixture(&vu0, fixtures[0]);
+      loadFixture(&vu1, fixtures[4]);
+      vu0.run(fixtures[0].config.cycleBudget);
+      vu1.run(fixtures[4].config.cycleBudget);
+
+      CAPTURE(slice);
+      REQUIRE(system.vu0().getState() == VPU_STATE_READY);
+      REQUIRE(system.vu1().getState() == VPU_STATE_READY);
+      REQUIRE(outputOf(system.vu0(), fixtures[0]) == outputOf(vu0, fixtures[0]));
+      REQUIRE(outputOf(system.vu1(), fixtures[4]) == outputOf(vu1, fixtures[4]));
+      REQUIRE(system.vu0().elapsedCycles() == 10000);
+    }
+  }
+
+  SECTION("A VU started later begins at the current master tick")
+  {
+    NekoSystem system;
+    system.runUntil(1000);
+    loadFixture(&system.vu1(), fixtures[0]);
+
+    system.scheduler().schedule(1010, [&system](std::uint64_t) {
+      REQUIRE(system.vu1().elapsedCycles() == 505);
+    });
+    system.runUntil(1010);
+
+    REQUIRE(system.vu1().getState() == VPU_STATE_RUN);
+  }
+
+  SECTION("Resetting a VU keeps it on the master timeline")
+  {
+    NekoSystem system;
+    system.runUntil(1000);
+    system.resetVU(VPUType::VU0);
+    loadFixture(&system.vu0(), fixtures[0]);
+
+    system.runUntil(1020);
+
+    REQUIRE(system.vu0().elapsedCycles() == 10);
+  }
+
+  SECTION("A reset VU that runs ahead of its old cycle stays on the timeline")
+  {
+    NekoSystem system;
+    system.runUntil(1000);
+    system.resetVU(VPUType::VU0);
+    loadFixture(&system.vu0(), fixtures[0]);
+    system.vu0().run(600);
+
+    system.runUntil(2400);
+
+    REQUIRE(system.vu0().elapsedCycles() == 700);
+  }
+
+  SECTION("Parallel VUs match serial interleaving")
+  {
+    for (std::uint64_t slice : {1, 64, 4096})
+    {
+      NekoSystem serial(slice);
+      NekoSystem parallel(slice);
+      parallel.scheduler().setExecution(SchedulerExecution::Parallel);
+      for (NekoSystem *system : {&serial, &parallel})
+      {
+        loadFixture(&system->vu0(), fixtures[0]);
+        loadFixture(&system->vu1(), fixtures[4]);
+        system->runUntil(5000);
+        loadFixture(&system->vu0(), fixtures[2]);
+        system->runUntil(40000);
+      }
+
+      CAPTURE(slice);
+      REQUIRE(parallel.vu0().saveState() == serial.vu0().saveState());
+      REQUIRE(parallel.vu1().saveState() == serial.vu1().saveState());
+      REQUIRE(parallel.masterTick() == serial.masterTick());
+    }
+  }
+}
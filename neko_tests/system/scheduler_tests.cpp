@@ -0,0 +1,202 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "scheduler.hpp"
+
+namespace
+{
+  class RecordingComponent : public SchedulerComponent
+  {
+    public:
+      RecordingComponent(
+        const std::string &name,
+        std::vector<std::string> *log,
+        std::uint64_t attention = SCHEDULER_NEVER) :
+        name(name),
+        log(log),
+        attention(attention)
+      {
+      }
+
+      std::uint64_t advanceTo(std::uint64_t tick) override
+      {
+        log->push_back(name + "@" + std::to_string(tick));
+        return attention;
+      }
+
+    private:
+      std::string name;
+      std::vector<std::string> *log;
+      std::uint64_t attention;
+  };
+
+  class FailingComponent : public SchedulerComponent
+  {
+    public:
+      explicit FailingComponent(const std::string &message) :
+        message(message)
+      {
+      }
+
+      std::uint64_t advanceTo(std::uint64_t) override
+      {
+        throw std::runtime_error(message);
+      }
+
+    private:
+      std::string message;
+  };
+}
+
+TEST_CASE("Scheduler")
+{
+  std::vector<std::string> log;
+
+  SECTION("Components advance in slices of the configured granularity")
+  {
+    Scheduler scheduler(100);
+    RecordingComponent first("a", &log);
+    RecordingComponent second("b", &log);
+    scheduler.addComponent(&first);
+    scheduler.addComponent(&second);
+
+    scheduler.runUntil(250);
+
+    REQUIRE(log == std::vector<std::string>({
+      "a@100", "b@100", "a@200", "b@200", "a@250", "b@250"
+    }));
+    REQUIRE(scheduler.now() == 250);
+  }
+
+  SECTION("Events end slices and tied events fire in scheduling order")
+  {
+    Scheduler scheduler(1000);
+    RecordingComponent component("a", &log);
+    scheduler.addComponent(&component);
+    scheduler.schedule(40, [&log](std::uint64_t tick) {
+      log.push_back("second@" + std::to_string(tick));
+    });
+    scheduler.schedule(30, [&log](std::uint64_t tick) {
+      log.push_back("first@" + std::to_string(tick));
+    });
+    scheduler.schedule(40, [&log](std::uint64_t tick) {
+      log.push_back("third@" + std::to_string(tick));
+    });
+
+    scheduler.runUntil(50);
+
+    REQUIRE(log == std::vector<std::string>({
+      "a@30", "first@30", "a@40", "second@40", "third@40", "a@50"
+    }));
+  }
+
+  SECTION("Events can schedule further events")
+  {
+    Scheduler scheduler(1000);
+    scheduler.schedule(10, [&](std::uint64_t tick) {
+      log.push_back("outer@" + std::to_string(tick));
+      scheduler.schedule(tick, [&log](std::uint64_t innerTick) {
+        log.push_back("inner@" + std::to_string(innerTick));
+      });
+    });
+
+    scheduler.runUntil(20);
+
+    REQUIRE(log == std::vector<std::string>({"outer@10", "inner@10"}));
+  }
+
+  SECTION("A component's attention tick ends the slice")
+  {
+    Scheduler scheduler(1000);
+    RecordingComponent waiting("a", &log, 1070);
+    RecordingComponent other("b", &log);
+    scheduler.addComponent(&waiting);
+    scheduler.addComponent(&other);
+
+    scheduler.runUntil(100);
+
+    REQUIRE(log == std::vector<std::string>({
+      "a@100", "b@100"
+    }));
+
+    log.clear();
+    scheduler.runUntil(2000);
+
+    REQUIRE(log == std::vector<std::string>({
+      "a@1070", "b@1070", "a@2000", "b@2000"
+    }));
+  }
+
+  SECTION("Parallel components stop at the same slice ends as serial ones")
+  {
+    std::vector<std::string> otherLog;
+    Scheduler scheduler(1000);
+    RecordingComponent first("a", &log);
+    RecordingComponent second("b", &otherLog, 1070);
+    scheduler.addComponent(&first);
+    scheduler.addComponent(&second);
+    scheduler.setExecution(SchedulerExecution::Parallel);
+    scheduler.schedule(500, [&](std::uint64_t tick) {
+      log.push_back("event@" + std::to_string(tick));
+      otherLog.push_back("event@" + std::to_string(tick));
+    });
+
+    scheduler.runUntil(2000);
+
+    REQUIRE(scheduler.execution() == SchedulerExecution::Parallel);
+    REQUIRE(log == std::vector<std::string>({
+      "a@500", "event@500", "a@1070", "a@2000"
+    }));
+    REQUIRE(otherLog == std::vector<std::string>({
+      "b@500", "event@500", "b@1070", "b@2000"
+    }));
+  }
+
+  SECTION("Parallel failures surface in component order")
+  {
+    Scheduler scheduler;
+    RecordingComponent first("a", &log);
+    FailingComponent second("second failed");
+    FailingComponent third("third failed");
+    scheduler.addComponent(&first);
+    scheduler.addComponent(&second);
+    scheduler.addComponent(&third);
+    scheduler.setExecution(SchedulerExecution::Parallel);
+
+    REQUIRE_THROWS_WITH(scheduler.runUntil(10), "second failed");
+    REQUIRE(log == std::vector<std::string>({"a@10"}));
+
+    scheduler.setExecution(SchedulerExecution::Serial);
+    REQUIRE_THROWS_WITH(scheduler.runUntil(20), "second failed");
+  }
+
+  SECTION("Serial failures surface in component order")
+  {
+    Scheduler scheduler;
+    FailingComponent first("first failed");
+    RecordingComponent second("b", &log);
+    FailingComponent third("third failed");
+    scheduler.addComponent(&first);
+    scheduler.addComponent(&second);
+    scheduler.addComponent(&third);
+
+    REQUIRE_THROWS_WITH(scheduler.runUntil(10), "first failed");
+    REQUIRE(log == std::vector<std::string>({"b@10"}));
+  }
+
+  SECTION("Invalid slices and past events are rejected")
+  {
+    Scheduler scheduler;
+    scheduler.runUntil(10);
+
+    REQUIRE_THROWS_WITH(
+      scheduler.setSliceTicks(0),
+      "Scheduler slices must be at least one tick.");
+    REQUIRE_THROWS_WITH(
+      scheduler.schedule(9, [](std::uint64_t) {}),
+      "Scheduler events cannot be scheduled in the past.");
+  }
+}
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_opcodes.hpp"
+#include "vu1_worker.hpp"
+
+namespace
+{
+  void submitFixture(
+    VU1Worker *worker,
+    const vpu_integration::IntegrationFixture &fixture)
+  {
+    worker->uploadMicroProgram(0, fixture.config.microProgram);
+    for (const VPUDataMemoryWrite &write : fixture.config.inputMemory)
+    {
+      worker->writeDataMemory(write.address, write.data);
+    }
+    worker->start(
+      fixture.config.startAddress,
+      fixture.config.outputAddress,
+      fixture.config.outputSize);
+  }
+
+  VPU runStandalone(const vpu_integration::IntegrationFixture &fixture)
+  {
+    VPU vpu(VPUType::VU1);
+    vpu.uploadMicroInstructions(fixture.config.microProgram);
+    for (const VPUDataMemoryWrite &write : fixture.config.inputMemory)
+    {
+      vpu.writeDataMemory(write.address, write.data);
+    }
+    vpu.startMicroMode(fixture.config.startAddress);
+    vpu.run(fixture.config.cycleBudget);
+    return vpu;
+  }
+}
+
+TEST_CASE("VU1 Worker")
+{
+  std::vector<vpu_integration::IntegrationFixture> fixtures =
+    vpu_integration::integrationFixtures();
+
+  SECTION("Queued programs publish their outputs in order")
+  {
+    VU1Worker worker;
+    for (const vpu_integration::IntegrationFixture &fixture : fixtures)
+    {
+      submitFixture(&worker, fixture);
+    }
+    worker.synchronize();
+
+    for (const vpu_integration::IntegrationFixture &fixture : fixtures)
+    {
+      VPU expected = runStandalone(fixture);
+      VU1Output output;
+      CAPTURE(fixture.name);
+      REQUIRE(worker.tryReadOutput(&output));
+      REQUIRE(output.startAddress == fixture.config.startAddress);
+      REQUIRE(output.elapsedCycles == expected.elapsedCycles());
+      REQUIRE(output.terminationPosition == expected.terminationPosition());
+      REQUIRE(output.data == expected.readDataMemory(
+        fixture.config.outputAddress,
+        fixture.config.outputSize));
+    }
+
+    VU1Output extra;
+    REQUIRE_FALSE(worker.tryReadOutput(&extra));
+  }
+
+  SECTION("A small output ring holds the worker until it is drained")
+  {
+    VU1WorkerOptions options;
+    options.commandCapacity = 1;
+    options.outputCapacity = 1;
+    VU1Worker worker(options);
+    worker.uploadMicroProgram(0, fixtures[0].config.microProgram);
+
+    std::vector<VU1Output> received;
+    for (int program = 0; program < 4; program++)
+    {
+      worker.start(0);
+      VU1Output output;
+      while (worker.tryReadOutput(&output))
+      {
+        received.push_back(output);
+      }
+    }
+    while (received.size() < 4)
+    {
+      VU1Output output;
+      if (worker.tryReadOutput(&output))
+      {
+        received.push_back(output);
+      }
+    }
+    worker.synchronize();
+
+    REQUIRE(received.size() == 4);
+    REQUIRE(worker.vu().getState() != VPU_STATE_RUN);
+  }
+
+  SECTION("An idle worker sleeps instead of spinning")
+  {
+    VU1Worker worker;
+    worker.synchronize();
+    std::clock_t before = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double cpuSeconds =
+      static_cast<double>(std::clock() - before) / CLOCKS_PER_SEC;
+
+    REQUIRE(cpuSeconds < 0.05);
+  }
+
+  SECTION("Worker failures are rethrown by synchronize")
+  {
+    VU1Worker worker;
+    std::vector<std::uint8_t> instructions;
+    const std::uint32_t words[] = {0x04000000, VPU_E_BIT | VPU_NOP};
+    for (std::uint32_t word : words)
+    {
+      for (int shift = 0; shift < 32; shift += 8)
+      {
+        instructions.push_back((word >> shift) & 0xff);
+      }
+    }
+    worker.uploadMicroProgram(0, instructions);
+    worker.start(0);
+
+    REQUIRE_THROWS_WITH(
+      worker.synchronize(),
+      "Unsupported VU lower instruction.");
+  }
+}
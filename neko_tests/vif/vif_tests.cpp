@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "catch.hpp"
+#include "vif.hpp"
+#include "vpu_opcodes.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+
+namespace
+{
+  std::uint32_t vifCode(
+    std::uint8_t command,
+    std::uint8_t num = 0,
+    std::uint16_t immediate = 0)
+  {
+    return (static_cast<std::uint32_t>(command) << 24) | (num << 16) | immediate;
+  }
+
+  void appendBytes(
+    std::vector<std::uint32_t> *stream,
+    const std::vector<std::uint8_t> &bytes)
+  {
+    std::vector<std::uint32_t> words((bytes.size() + 3) / 4);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    stream->insert(stream->end(), words.begin(), words.end());
+  }
+
+  // Uploads and starts a fixture the way a VIF1 DMA chain would.
+  std::vector<std::uint32_t> fixtureStream(
+    const vpu_integration::IntegrationFixture &fixture)
+  {
+    std::vector<std::uint32_t> stream;
+    const std::vector<std::uint8_t> &program = fixture.config.microProgram;
+    for (size_t offset = 0; offset < program.size(); offset += 256 * 8)
+    {
+      size_t size = std::min<size_t>(program.size() - offset, 256 * 8);
+      stream.push_back(vifCode(
+        VIF_CMD_MPG,
+        static_cast<std::uint8_t>(size / 8),
+        static_cast<std::uint16_t>(offset / 8)));
+      appendBytes(&stream, std::vector<std::uint8_t>(
+        program.begin() + offset,
+        program.begin() + offset + size));
+    }
+
+    stream.push_back(vifCode(VIF_CMD_STCYCL, 0, 0x0101));
+    for (const VPUDataMemoryWrite &write : fixture.config.inputMemory)
+    {
+      REQUIRE(write.address % 16 == 0);
+      REQUIRE(write.data.size() % 16 == 0);
+      stream.push_back(vifCode(
+        VIF_CMD_UNPACK | static_cast<std::uint8_t>(VIFUnpackFormat::V4_32),
+        static_cast<std::uint8_t>(write.data.size() / 16),
+        static_cast<std::uint16_t>(write.address / 16)));
+      appendBytes(&stream, write.data);
+    }
+    stream.push_back(vifCode(
+      VIF_CMD_MSCAL, 0, fixture.config.startAddress / 8));
+    return stream;
+  }
+
+  std::vector<std::uint32_t> qwordAt(VPU *vpu, size_t qword)
+  {
+    std::vector<std::uint32_t> lanes(4);
+    std::memcpy(lanes.data(), vpu->dataMemory() + qword * 16, 16);
+    return lanes;
+  }
+}
+
+TEST_CASE("VIF")
+{
+  VPU vpu(VPUType::VU1);
+  VIF vif(&vpu);
+
+  SECTION("MPG, UNPACK and MSCAL run fixtures like direct uploads")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      VPU target(VPUType::VU1);
+      VIF targetVIF(&target);
+      std::vector<std::uint32_t> stream = fixtureStream(fixture);
+      REQUIRE(targetVIF.write(stream.data(), stream.size()) == stream.size());
+      target.run(fixture.config.cycleBudget);
+
+      VPU expected(VPUType::VU1);
+      expected.uploadMicroInstructions(fixture.config.microProgram);
+      for (const VPUDataMemoryWrite &write : fixture.config.inputMemory)
+      {
+        expected.writeDataMemory(write.address, write.data);
+      }
+      expected.startMicroMode(fixture.config.startAddress);
+      expected.run(fixture.config.cycleBudget);
+
+      CAPTURE(fixture.name);
+      REQUIRE(target.saveState() == expected.saveState());
+    }
+  }
+
+  SECTION("Streams may be split at any word")
+  {
+    std::vector<std::uint32_t> stream = {
+      vifCode(VIF_CMD_STCYCL, 0, 0x0101),
+      vifCode(VIF_CMD_UNPACK | 0xa, 5, VIF_UNPACK_UNSIGNED_BIT | 2),
+      0x04030201, 0x08070605, 0x0c0b0a09, 0x000f0e0d,
+      vifCode(VIF_CMD_STROW), 1, 2, 3, 4
+    };
+    VPU whole(VPUType::VU1);
+    VIF wholeVIF(&whole);
+    wholeVIF.write(stream.data(), stream.size());
+
+    for (const std::uint32_t &word : stream)
+    {
+      REQUIRE(vif.write(&word, 1) == 1);
+    }
+
+    REQUIRE(vpu.saveState() == whole.saveState());
+    REQUIRE(qwordAt(&vpu, 2) == std::vector<std::uint32_t>({1, 2, 3, 0}));
+    REQUIRE(qwordAt(&vpu, 6) == std::vector<std::uint32_t>({13, 14, 15, 0}));
+    REQUIRE(vif.unpackRegisters().row[3] == 4);
+  }
+
+  SECTION("Skipping and filling writes follow CL and WL")
+  {
+    std::vector<std::uint32_t> stream = {
+      vifCode(VIF_CMD_STCYCL, 0, 0x0204),
+      vifCode(VIF_CMD_UNPACK | 0x0, 4, 10), 1, 2, 3, 4,
+      vifCode(VIF_CMD_STROW), 7, 7, 7, 7,
+      vifCode(VIF_CMD_STCYCL, 0, 0x0301),
+      vifCode(VIF_CMD_UNPACK | 0x0, 6, 20), 5, 6
+    };
+    REQUIRE(vif.write(stream.data(), stream.size()) == stream.size());
+
+    REQUIRE(qwordAt(&vpu, 10)[0] == 1);
+    REQUIRE(qwordAt(&vpu, 11)[0] == 2);
+    REQUIRE(qwordAt(&vpu, 12)[0] == 0);
+    REQUIRE(qwordAt(&vpu, 14)[0] == 3);
+    REQUIRE(qwordAt(&vpu, 15)[0] == 4);
+    REQUIRE(qwordAt(&vpu, 20)[0] == 5);
+    REQUIRE(qwordAt(&vpu, 21)[0] == 7);
+    REQUIRE(qwordAt(&vpu, 22)[0] == 7);
+    REQUIRE(qwordAt(&vpu, 23)[0] == 6);
+    REQUIRE(qwordAt(&vpu, 25)[0] == 7);
+    REQUIRE(qwordAt(&vpu, 26)[0] == 0);
+  }
+
+  SECTION("Masks select data, row, column or protection per lane")
+  {
+    std::vector<std::uint32_t> stream = {
+      vifCode(VIF_CMD_STCYCL, 0, 0x0202),
+      vifCode(VIF_CMD_STROW), 10, 20, 30, 40,
+      vifCode(VIF_CMD_STCOL), 100, 200, 300, 400,
+      vifCode(VIF_CMD_STMASK), 0x0000e480,
+      vifCode(VIF_CMD_UNPACK | VIF_UNPACK_MASK_BIT | 0xc, 2, 0),
+      1, 2, 3, 4, 5, 6, 7, 8
+    };
+    std::uint32_t old = 0xdeadbeef;
+    std::memcpy(vpu.dataMemory() + 16 + 12, &old, 4);
+    REQUIRE(vif.write(stream.data(), stream.size()) == stream.size());
+
+    REQUIRE(qwordAt(&vpu, 0) == std::vector<std::uint32_t>({1, 2, 3, 100}));
+    REQUIRE(qwordAt(&vpu, 1) == std::vector<std::uint32_t>({5, 20, 200, 0xdeadbeef}));
+  }
+
+  SECTION("Offset and difference modes add the row register")
+  {
+    std::vector<std::uint32_t> stream = {
+      vifCode(VIF_CMD_STCYCL, 0, 0x0101),
+      vifCode(VIF_CMD_STROW), 10, 20, 30, 40,
+      vifCode(VIF_CMD_STMOD, 0, VIF_MODE_OFFSET),
+      vifCode(VIF_CMD_UNPACK | 0x4, 1, 0), 1, 2,
+      vifCode(VIF_CMD_STMOD, 0, VIF_MODE_DIFFERENCE),
+      vifCode(VIF_CMD_UNPACK | 0x0, 2, 1), 1, 2
+    };
+    REQUIRE(vif.write(stream.data(), stream.size()) == stream.size());
+
+    REQUIRE(qwordAt(&vpu, 0) == std::vector<std::uint32_t>({11, 22, 31, 42}));
+    REQUIRE(qwordAt(&vpu, 1) == std::vector<std::uint32_t>({11, 21, 31, 41}));
+    REQUIRE(qwordAt(&vpu, 2) == std::vector<std::uint32_t>({13, 23, 33, 43}));
+    REQUIRE(vif.unpackRegisters().row[0] == 13);
+  }
+
+  SECTION("VIF1 double buffers through BASE, OFFSET and MSCAL")
+  {
+    std::vector<std::uint32_t> program = {
+      VPU_LOWER_NOP, VPU_E_BIT | VPU_NOP, VPU_LOWER_NOP, VPU_NOP
+    };
+    std::vector<std::uint8_t> programBytes(program.size() * 4);
+    std::memcpy(programBytes.data(), program.data(), programBytes.size());
+    vpu.uploadMicroInstructions(programBytes);
+
+    std::vector<std::uint32_t> stream = {
+      vifCode(VIF_CMD_BASE, 0, 100),
+      vifCode(VIF_CMD_OFFSET, 0, 200),
+      vifCode(VIF_CMD_ITOP, 0, 7),
+      vifCode(VIF_CMD_STCYCL, 0, 0x0101),
+      vifCode(VIF_CMD_UNPACK | 0x0, 1, VIF_UNPACK_TOPS_BIT | 1), 9,
+      vifCode(VIF_CMD_MSCAL, 0, 0),
+      vifCode(VIF_CMD_UNPACK | 0x0, 1, VIF_UNPACK_TOPS_BIT | 1), 8,
+      vifCode(VIF_CMD_FLUSH),
+      vifCode(VIF_CMD_MSCAL, 0, 0)
+    };
+
+    size_t consumed = vif.write(stream.data(), stream.size());
+    REQUIRE(consumed == stream.size() - 2);
+    REQUIRE(vif.waitingForVU());
+    REQUIRE(vif.top() == 100);
+    REQUIRE(vif.itop() == 7);
+    REQUIRE(vif.tops() == 300);
+    REQUIRE(qwordAt(&vpu, 101)[0] == 9);
+    REQUIRE(qwordAt(&vpu, 301)[0] == 8);
+
+    vpu.run(100);
+    consumed += vif.write(stream.data() + consumed, stream.size() - consumed);
+    REQUIRE(consumed == stream.size());
+    REQUIRE_FALSE(vif.waitingForVU());
+    REQUIRE(vif.top() == 300);
+    REQUIRE(vif.tops() == 100);
+  }
+
+  SECTION("Unsupported commands and formats are rejected")
+  {
+    VPU vu0;
+    VIF vif0(&vu0);
+    std::uint32_t base = vifCode(VIF_CMD_BASE, 0, 1);
+    std::uint32_t direct = vifCode(0x50, 0, 1);
+    std::uint32_t badFormat = vifCode(VIF_CMD_UNPACK | 0x3, 1, 0);
+    std::uint32_t noCycle = vifCode(VIF_CMD_UNPACK, 1, 0);
+
+    REQUIRE_THROWS_WITH(vif0.write(&base, 1), "Unsupported VIF command.");
+    REQUIRE_THROWS_WITH(vif.write(&direct, 1), "Unsupported VIF command.");
+    REQUIRE_THROWS_WITH(
+      vif.write(&badFormat, 1),
+      "Unsupported VIF UNPACK format.");
+    REQUIRE_THROWS_WITH(
+      vif.write(&noCycle, 1),
+      "VIF UNPACK needs a nonzero write cycle length.");
+  }
+}
@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+#include "vif_unpack.hpp"
+
+namespace
+{
+  const VIFUnpackFormat allFormats[] = {
+    VIFUnpackFormat::S32, VIFUnpackFormat::S16, VIFUnpackFormat::S8,
+    VIFUnpackFormat::V2_32, VIFUnpackFormat::V2_16, VIFUnpackFormat::V2_8,
+    VIFUnpackFormat::V3_32, VIFUnpackFormat::V3_16, VIFUnpackFormat::V3_8,
+    VIFUnpackFormat::V4_32, VIFUnpackFormat::V4_16, VIFUnpackFormat::V4_8,
+    VIFUnpackFormat::V4_5
+  };
+
+  std::vector<std::uint32_t> unpackOne(
+    VIFUnpackFormat format,
+    bool zeroExtend,
+    const std::vector<std::uint8_t> &source)
+  {
+    std::vector<std::uint8_t> qword(16);
+    vifUnpackElements(format, zeroExtend, source.data(), qword.data(), 1);
+    std::vector<std::uint32_t> lanes(4);
+    std::memcpy(lanes.data(), qword.data(), 16);
+    return lanes;
+  }
+
+  std::vector<std::uint8_t> randomBytes(std::mt19937 *random, size_t size)
+  {
+    std::vector<std::uint8_t> bytes(size);
+    for (std::uint8_t &byte : bytes)
+    {
+      byte = static_cast<std::uint8_t>((*random)());
+    }
+    return bytes;
+  }
+}
+
+TEST_CASE("VIF Unpack Kernels")
+{
+  SECTION("Formats expand to the documented lanes")
+  {
+    REQUIRE(unpackOne(VIFUnpackFormat::S16, false, {0x01, 0x80}) ==
+      std::vector<std::uint32_t>(4, 0xffff8001));
+    REQUIRE(unpackOne(VIFUnpackFormat::S16, true, {0x01, 0x80}) ==
+      std::vector<std::uint32_t>(4, 0x8001));
+    REQUIRE(unpackOne(VIFUnpackFormat::V2_8, false, {0x7f, 0xff}) ==
+      std::vector<std::uint32_t>({0x7f, 0xffffffff, 0x7f, 0xffffffff}));
+    REQUIRE(unpackOne(VIFUnpackFormat::V3_8, true, {1, 2, 3}) ==
+      std::vector<std::uint32_t>({1, 2, 3, 0}));
+    REQUIRE(unpackOne(VIFUnpackFormat::V4_5, false, {0x21, 0x84}) ==
+      std::vector<std::uint32_t>({0x08, 0x08, 0x08, 0x80}));
+  }
+
+  SECTION("Element sizes follow the format")
+  {
+    REQUIRE(vifUnpackElementBytes(VIFUnpackFormat::S8) == 1);
+    REQUIRE(vifUnpackElementBytes(VIFUnpackFormat::V3_16) == 6);
+    REQUIRE(vifUnpackElementBytes(VIFUnpackFormat::V4_32) == 16);
+    REQUIRE(vifUnpackElementBytes(VIFUnpackFormat::V4_5) == 2);
+    REQUIRE(isVIFUnpackFormat(0xf));
+    REQUIRE_FALSE(isVIFUnpackFormat(0x3));
+    REQUIRE_FALSE(isVIFUnpackFormat(0xb));
+  }
+
+  SECTION("Vector kernels match the scalar reference")
+  {
+    std::mt19937 random(49);
+    for (VIFUnpackFormat format : allFormats)
+    {
+      for (bool zeroExtend : {false, true})
+      {
+        for (size_t count = 0; count <= 9; count++)
+        {
+          size_t elementBytes = vifUnpackElementBytes(format);
+          std::vector<std::uint8_t> source =
+            randomBytes(&random, count * elementBytes);
+          std::vector<std::uint8_t> fast(count * 16);
+          std::vector<std::uint8_t> reference(count * 16);
+
+          vifUnpackElements(
+            format, zeroExtend, source.data(), fast.data(), count);
+          vifUnpackElementsScalar(
+            format, zeroExtend, source.data(), reference.data(), count);
+
+          int formatBits = static_cast<int>(format);
+          CAPTURE(formatBits);
+          CAPTURE(zeroExtend);
+          CAPTURE(count);
+          REQUIRE(fast == reference);
+        }
+      }
+    }
+  }
+
+  SECTION("Masked writes match the scalar reference")
+  {
+    std::mt19937 random(3);
+    for (int trial = 0; trial < 200; trial++)
+    {
+      VIFUnpackRegisters registers;
+      registers.mask = random();
+      registers.mode = random() % 3;
+      for (int lane = 0; lane < 4; lane++)
+      {
+        registers.row[lane] = random();
+        registers.column[lane] = random();
+      }
+      VIFUnpackRegisters referenceRegisters = registers;
+
+      size_t count = 1 + random() % 8;
+      bool masked = random() % 2 == 0;
+      bool filling = random() % 4 == 0;
+      unsigned int writeLength = 1 + random() % 6;
+      unsigned int cycle = random() % writeLength;
+      std::vector<std::uint8_t> expanded = randomBytes(&random, count * 16);
+      std::vector<std::uint8_t> fast = randomBytes(&random, count * 16);
+      std::vector<std::uint8_t> reference = fast;
+
+      vifWriteUnpacked(
+        &registers, masked, filling ? nullptr : expanded.data(),
+        fast.data(), count, cycle, writeLength);
+      vifWriteUnpackedScalar(
+        &referenceRegisters, masked, filling ? nullptr : expanded.data(),
+        reference.data(), count, cycle, writeLength);
+
+      CAPTURE(trial);
+      REQUIRE(fast == reference);
+      REQUIRE(std::memcmp(
+        registers.row, referenceRegisters.row, sizeof(registers.row)) == 0);
+    }
+  }
+}
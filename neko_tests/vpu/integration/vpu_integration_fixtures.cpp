@@ -0,0 +1,128 @@
+#include "vpu_integration_fixtures.hpp"
+
+#include <cstdint>
+
+#include "vpu_integration_test_utils.hpp"
+
+namespace vpu_integration
+{
+  namespace
+  {
+    void appendSentinels(std::vector<std::uint8_t> *memory, std::uint8_t count)
+    {
+      for (std::uint8_t output = 0; output < count; output++)
+      {
+        appendQword(memory, 0xdead0001, 0xdead0002, 0xdead0003, 0xdead0004);
+      }
+    }
+
+    IntegrationFixture fixture(
+      const std::string &name,
+      const std::string &fileName,
+      const std::vector<std::uint8_t> &initialMemory,
+      std::uint32_t cycleBudget,
+      std::size_t outputAddress,
+      std::size_t outputSize)
+    {
+      IntegrationFixture result;
+      result.name = name;
+      result.config.microProgram = readBinary(fileName);
+      result.config.inputMemory.push_back({0, initialMemory});
+      result.config.cycleBudget = cycleBudget;
+      result.config.outputAddress = outputAddress;
+      result.config.outputSize = outputSize;
+      return result;
+    }
+  }
+
+  std::vector<IntegrationFixture> integrationFixtures()
+  {
+    std::vector<IntegrationFixture> fixtures;
+
+    std::vector<std::uint8_t> integerFill;
+    appendWord(&integerFill, 3);
+    appendWord(&integerFill, 0x10);
+    appendWord(&integerFill, 3);
+    appendWord(&integerFill, 0);
+    fixtures.push_back(fixture(
+      "integer_fill", "integer_fill.bin", integerFill, 200, 0, 3 * 16));
+
+    std::vector<std::uint8_t> laneMasks;
+    appendQword(&laneMasks, 1, 2, 0x7f, 0);
+    appendQword(&laneMasks, 0x11111111, 0x22222222, 0x33333333, 0x44444444);
+    appendQword(&laneMasks, 0xa0, 0xa1, 0xa2, 0xa3);
+    appendQword(&laneMasks, 0xb0, 0xb1, 0xb2, 0xb3);
+    appendQword(&laneMasks, 0xc0, 0xc1, 0xc2, 0xc3);
+    appendQword(&laneMasks, 0xd0, 0xd1, 0xd2, 0xd3);
+    appendQword(&laneMasks, 0xe0, 0xe1, 0xe2, 0xe3);
+    fixtures.push_back(fixture(
+      "lane_masks", "lane_masks.bin", laneMasks, 200, 2 * 16, 5 * 16));
+
+    std::vector<std::uint8_t> branchPaths;
+    appendQword(&branchPaths, 1, 2, 1, 0);
+    appendSentinels(&branchPaths, 1);
+    fixtures.push_back(fixture(
+      "branch_paths", "branch_paths.bin", branchPaths, 200, 16, 16));
+
+    std::vector<std::uint8_t> indirectCalls;
+    appendQword(&indirectCalls, 13 * 8, 1, 17 * 8, 1);
+    appendSentinels(&indirectCalls, 1);
+    fixtures.push_back(fixture(
+      "indirect_calls", "indirect_calls.bin", indirectCalls, 200, 16, 16));
+
+    std::vector<std::uint8_t> vectorMath;
+    appendQword(&vectorMath, 1, 2, 3, 0);
+    appendQword(&vectorMath, 0x3f800000, 0x40000000, 0x40800000, 0x41000000);
+    appendQword(&vectorMath, 0x3f000000, 0x3f800000, 0x40000000, 0x40800000);
+    appendSentinels(&vectorMath, 3);
+    fixtures.push_back(fixture(
+      "vector_math", "vector_math.bin", vectorMath, 200, 3 * 16, 3 * 16));
+
+    std::vector<std::uint8_t> dualIssue;
+    appendQword(&dualIssue, 1, 2, 3, 1);
+    appendQword(&dualIssue, 0x3f800000, 0x40800000, 0x41000000, 0x41800000);
+    appendQword(&dualIssue, 0x3f000000, 0x40000000, 0x41800000, 0x41000000);
+    appendSentinels(&dualIssue, 7);
+    fixtures.push_back(fixture(
+      "dual_issue", "dual_issue.bin", dualIssue, 200, 3 * 16, 7 * 16));
+
+    std::vector<std::uint8_t> branchTermination;
+    appendQword(&branchTermination, 1, 2, 1, 0);
+    appendSentinels(&branchTermination, 1);
+    fixtures.push_back(fixture(
+      "termination_branch",
+      "termination.bin",
+      branchTermination,
+      100,
+      16,
+      16));
+
+    std::vector<std::uint8_t> delaySlotTermination;
+    appendQword(&delaySlotTermination, 0, 0, 0, 0);
+    appendQword(&delaySlotTermination, 1, 2, 2, 0);
+    appendSentinels(&delaySlotTermination, 1);
+    fixtures.push_back(fixture(
+      "termination_delay_slot",
+      "termination.bin",
+      delaySlotTermination,
+      100,
+      2 * 16,
+      16));
+    fixtures.back().config.startAddress = 10 * 8;
+
+    std::vector<std::uint8_t> vectorKernel;
+    appendQword(&vectorKernel, 3, 5, 8, 1);
+    appendQword(&vectorKernel, 0x40000000, 0x3f000000, 0x40800000, 0x3e800000);
+    appendQword(&vectorKernel, 0x3f800000, 0xbf800000, 0x40000000, 0x3f000000);
+    appendQword(&vectorKernel, 0, 0, 0, 0);
+    appendQword(&vectorKernel, 0x41200000, 0x41200000, 0x41200000, 0x41200000);
+    appendQword(&vectorKernel, 0xbf800000, 0x40800000, 0x3f800000, 0x41000000);
+    appendQword(&vectorKernel, 0x40400000, 0x41f00000, 0xbf800000, 0x42c80000);
+    appendQword(&vectorKernel, 0x41200000, 0xc0800000, 0x40400000, 0xc1000000);
+    appendSentinels(&vectorKernel, 3);
+    fixtures.push_back(fixture(
+      "vector_kernel", "vector_kernel.bin", vectorKernel, 500, 8 * 16, 3 * 16));
+
+    return fixtures;
+  }
+}
@@ -0,0 +1,20 @@
+#ifndef VPU_INTEGRATION_FIXTURES_H
+#define VPU_INTEGRATION_FIXTURES_H
+
+#include <string>
+#include <vector>
+
+#include "vpu_program_runner.hpp"
+
+namespace vpu_integration
+{
+  struct IntegrationFixture
+  {
+    std::string name;
+    VPUProgramRunConfig config;
+  };
+
+  std::vector<IntegrationFixture> integrationFixtures();
+}
+
+#endif
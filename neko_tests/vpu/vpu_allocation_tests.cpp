@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <vector>
+
+#include "allocation_tracker.hpp"
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_profiler.hpp"
+#include "vpu_trace_ring_buffer.hpp"
+
+namespace
+{
+  void loadFixture(
+    VPU *vpu,
+    const vpu_integration::IntegrationFixture &fixture)
+  {
+    vpu->uploadMicroInstructions(fixture.config.microProgram);
+    for (const VPUDataMemoryWrite &write : fixture.config.inputMemory)
+    {
+      vpu->writeDataMemory(write.address, write.data);
+    }
+    vpu->startMicroMode(fixture.config.startAddress);
+  }
+}
+
+TEST_CASE("VPU Allocation Tracking")
+{
+  SECTION("Allocations and frees on this thread are counted")
+  {
+    AllocationCounts counts = countAllocations([]() {
+      std::vector<std::uint8_t> *volatile bytes =
+        new std::vector<std::uint8_t>(100);
+      delete bytes;
+    });
+
+    REQUIRE(counts.allocations == 2);
+    REQUIRE(counts.deallocations == 2);
+    REQUIRE(counts.bytes >= 100 + sizeof(std::vector<std::uint8_t>));
+  }
+
+  SECTION("Allocating inside a no-allocation scope throws")
+  {
+    REQUIRE_THROWS_WITH(
+      requireNoAllocations("The test body", []() {
+        int *volatile value = new int(1);
+        delete value;
+      }),
+      "The test body allocated 1 times.");
+    REQUIRE_NOTHROW(requireNoAllocations("The test body", []() {}));
+  }
+
+  SECTION("Running a loaded fixture does not allocate")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      VPU vpu;
+      loadFixture(&vpu, fixture);
+
+      CAPTURE(fixture.name);
+      REQUIRE_NOTHROW(requireNoAllocations("VPU::run()", [&]() {
+        vpu.run(fixture.config.cycleBudget);
+      }));
+      REQUIRE(vpu.getState() == VPU_STATE_READY);
+    }
+  }
+
+  SECTION("Tracing stall reasons into a ring buffer does not allocate")
+  {
+    VPUTraceRingBuffer ring(64);
+    VPU vpu;
+    vpu.setTraceCallback([&ring](const VPUTraceEvent &event) {
+      ring.push(event);
+    }, true);
+    vpu_integration::IntegrationFixture fixture =
+      vpu_integration::integrationFixtures()[0];
+    loadFixture(&vpu, fixture);
+
+    REQUIRE_NOTHROW(requireNoAllocations("Traced VPU::run()", [&]() {
+      vpu.run(fixture.config.cycleBudget);
+    }));
+    REQUIRE(ring.size() > 0);
+  }
+
+  SECTION("Profiling a run does not allocate")
+  {
+    VPU vpu;
+    VPUProfiler profiler(vpu.microMemorySize());
+    vpu.setTraceCallback([&profiler](const VPUTraceEvent &event) {
+      profiler.record(event);
+    }, profiler.collectsStallCauses());
+    vpu_integration::IntegrationFixture fixture =
+      vpu_integration::integrationFixtures().back();
+    loadFixture(&vpu, fixture);
+
+    REQUIRE_NOTHROW(requireNoAllocations("Profiled VPU::run()", [&]() {
+      vpu.run(fixture.config.cycleBudget);
+    }));
+    REQUIRE(profiler.report(fixture.config.microProgram).stallCycles > 0);
+  }
+}
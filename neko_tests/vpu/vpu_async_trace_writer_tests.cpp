@@ -0,0 +1,109 @@
+#include <chrono>
+#include <ctime>
+#include <ios>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_async_trace_writer.hpp"
+#include "vpu_program_runner.hpp"
+
+namespace
+{
+  class FailingBuffer : public std::streambuf
+  {
+    protected:
+      int overflow(int) override
+      {
+        return traits_type::eof();
+      }
+  };
+
+  std::string kernelTrace(bool async, VPUTraceOutputFormat format)
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    std::ostringstream output;
+    config.traceOutput = &output;
+    config.traceOutputFormat = format;
+    config.asyncTraceOutput = async;
+    config.asyncTraceQueueCapacity = 8;
+    VPU vpu;
+    VPUProgramRunResult result = runVPUProgram(&vpu, config);
+    REQUIRE(result.droppedTraceOutputEvents == 0);
+    return output.str();
+  }
+}
+
+TEST_CASE("VPU Async Trace Writer")
+{
+  SECTION("Asynchronous output matches synchronous output in both formats")
+  {
+    REQUIRE(kernelTrace(true, VPUTraceOutputFormat::JsonLines) ==
+      kernelTrace(false, VPUTraceOutputFormat::JsonLines));
+    REQUIRE(kernelTrace(true, VPUTraceOutputFormat::Binary) ==
+      kernelTrace(false, VPUTraceOutputFormat::Binary));
+  }
+
+  SECTION("Drop backpressure accounts for every event it does not write")
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    config.captureTrace = true;
+    std::ostringstream output;
+    config.traceOutput = &output;
+    config.asyncTraceOutput = true;
+    config.asyncTraceQueueCapacity = 1;
+    config.traceBackpressure = VPUTraceBackpressure::Drop;
+    VPU vpu;
+
+    VPUProgramRunResult result = runVPUProgram(&vpu, config);
+
+    std::string trace = output.str();
+    std::size_t writtenEvents = 0;
+    for (char character : trace)
+    {
+      writtenEvents += character == '\n';
+    }
+    REQUIRE(writtenEvents + result.droppedTraceOutputEvents ==
+      result.traceEvents.size());
+  }
+
+  SECTION("An idle writer sleeps instead of spinning")
+  {
+    std::ostringstream output;
+    VPUAsyncTraceWriter writer(&output, VPUAsyncTraceWriterOptions());
+    VPUTraceEvent event = {};
+    writer.write(event);
+    std::clock_t before = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double cpuSeconds =
+      static_cast<double>(std::clock() - before) / CLOCKS_PER_SEC;
+    writer.finish();
+
+    REQUIRE(cpuSeconds < 0.05);
+    REQUIRE(output.str().size() > 0);
+  }
+
+  SECTION("Writer failures are rethrown on the emulation thread")
+  {
+    FailingBuffer buffer;
+    std::ostream output(&buffer);
+    output.exceptions(std::ios::badbit);
+    VPUAsyncTraceWriterOptions options;
+    options.queueCapacity = 2;
+    VPUAsyncTraceWriter writer(&output, options);
+    VPUTraceEvent event = {};
+
+    for (int index = 0; index < 16; index++)
+    {
+      writer.write(event);
+    }
+
+    REQUIRE_THROWS_AS(writer.finish(), std::ios_base::failure);
+    REQUIRE_NOTHROW(writer.finish());
+  }
+}
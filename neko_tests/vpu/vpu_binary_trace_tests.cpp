@@ -0,0 +1,141 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_binary_trace.hpp"
+#include "vpu_program_runner.hpp"
+
+namespace
+{
+  VPUProgramRunConfig kernelConfig()
+  {
+    return vpu_integration::integrationFixtures().back().config;
+  }
+
+  std::string binaryKernelTrace(bool stallReasons = false)
+  {
+    VPUProgramRunConfig config = kernelConfig();
+    config.traceStallReasons = stallReasons;
+    std::ostringstream traceOutput;
+    config.traceOutput = &traceOutput;
+    config.traceOutputFormat = VPUTraceOutputFormat::Binary;
+    VPU vpu;
+    runVPUProgram(&vpu, config);
+    return traceOutput.str();
+  }
+}
+
+TEST_CASE("VPU Binary Trace")
+{
+  SECTION("Records are fixed-size and follow a header naming the VU and program")
+  {
+    VPUProgramRunConfig config = kernelConfig();
+    config.captureTrace = true;
+    VPU vpu;
+    VPUProgramRunResult result = runVPUProgram(&vpu, config);
+    std::istringstream input(binaryKernelTrace());
+
+    VPUBinaryTraceReader reader(&input);
+    std::vector<VPUTraceEvent> events;
+    VPUTraceEvent event;
+    while (reader.read(&event))
+    {
+      events.push_back(event);
+    }
+
+    REQUIRE(input.str().size() == VPU_BINARY_TRACE_HEADER_SIZE +
+      result.traceEvents.size() * VPU_BINARY_TRACE_RECORD_SIZE);
+    REQUIRE(input.str().compare(0, 4, "NKTR") == 0);
+    REQUIRE(reader.header().type == VPUType::VU0);
+    REQUIRE(reader.header().programHash == hashVPUProgram(config.microProgram));
+    REQUIRE(events.size() == result.traceEvents.size());
+    for (std::size_t index = 0; index < events.size(); index++)
+    {
+      const VPUTraceEvent &expected = result.traceEvents[index];
+      REQUIRE(events[index].type == expected.type);
+      REQUIRE(events[index].cycle == expected.cycle);
+      REQUIRE(events[index].instructionAddress == expected.instructionAddress);
+      REQUIRE(events[index].upperInstruction == expected.upperInstruction);
+      REQUIRE(events[index].lowerInstruction == expected.lowerInstruction);
+      REQUIRE(events[index].opCode == expected.opCode);
+      REQUIRE(events[index].destinationRegister ==
+        expected.destinationRegister);
+      REQUIRE(events[index].destinationFieldMask ==
+        expected.destinationFieldMask);
+    }
+  }
+
+  SECTION("Binary traces convert to the JSONL the runner writes directly")
+  {
+    VPUProgramRunConfig config = kernelConfig();
+    std::ostringstream jsonOutput;
+    config.traceOutput = &jsonOutput;
+    VPU vpu;
+    runVPUProgram(&vpu, config);
+    std::istringstream binaryInput(binaryKernelTrace());
+    std::ostringstream convertedOutput;
+
+    std::size_t eventCount =
+      convertVPUBinaryTraceToJsonLines(binaryInput, convertedOutput);
+
+    REQUIRE(eventCount > 0);
+    REQUIRE(convertedOutput.str() == jsonOutput.str());
+  }
+
+  SECTION("Stall reasons survive binary records and JSONL conversion")
+  {
+    VPUProgramRunConfig config = kernelConfig();
+    config.traceStallReasons = true;
+    std::ostringstream jsonOutput;
+    config.traceOutput = &jsonOutput;
+    VPU vpu;
+    runVPUProgram(&vpu, config);
+    std::istringstream binaryInput(binaryKernelTrace(true));
+    std::ostringstream convertedOutput;
+
+    convertVPUBinaryTraceToJsonLines(binaryInput, convertedOutput);
+
+    REQUIRE(jsonOutput.str().find("\"stall_unit\":") != std::string::npos);
+    REQUIRE(convertedOutput.str() == jsonOutput.str());
+    REQUIRE(binaryKernelTrace().size() == binaryKernelTrace(true).size());
+  }
+
+  SECTION("Program hashes distinguish microprograms")
+  {
+    REQUIRE(hashVPUProgram({}) == 0xcbf29ce484222325);
+    REQUIRE(hashVPUProgram({1, 2}) != hashVPUProgram({2, 1}));
+  }
+
+  SECTION("Malformed binary traces are rejected")
+  {
+    std::string trace = binaryKernelTrace();
+
+    std::istringstream badMagic("NKTX" + trace.substr(4));
+    REQUIRE_THROWS_WITH(
+      VPUBinaryTraceReader(&badMagic),
+      "VU binary trace has an invalid header.");
+
+    std::string newerVersion = trace;
+    newerVersion[4] = VPU_BINARY_TRACE_VERSION + 1;
+    std::istringstream badVersion(newerVersion);
+    REQUIRE_THROWS_WITH(
+      VPUBinaryTraceReader(&badVersion),
+      "Unsupported VU binary trace version.");
+
+    std::istringstream partial(trace.substr(0, trace.size() - 1));
+    std::ostringstream output;
+    REQUIRE_THROWS_WITH(
+      convertVPUBinaryTraceToJsonLines(partial, output),
+      "VU binary trace ends with a partial record.");
+
+    std::string unknownType = trace;
+    unknownType[VPU_BINARY_TRACE_HEADER_SIZE] = 0x7f;
+    std::istringstream badType(unknownType);
+    REQUIRE_THROWS_WITH(
+      convertVPUBinaryTraceToJsonLines(badType, output),
+      "VU binary trace contains an unknown event type.");
+  }
+}
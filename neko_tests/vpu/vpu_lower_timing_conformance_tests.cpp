@@ -1300,4 +1300,118 @@ TEST_CASE("VU Lower Timing Conformance Tests")
     vpu.run(30);
     REQUIRE(vpu.fpRegisterValue(VPU_REGISTER_VF06)->x == 3);
   }
+
+  SECTION("Stall events carry a reason only when the trace consumer asks")
+  {
+    std::vector<uint8_t> instructions;
+    appendInstructionPair(
+      &instructions,
+      VPU_NOP,
+      ilw(
+        FP_REGISTER_X_FIELD,
+        VPU_REGISTER_VI01,
+        VPU_REGISTER_VI00,
+        0));
+    appendInstructionPair(
+      &instructions,
+      VPU_NOP,
+      ibne(VPU_REGISTER_VI00, VPU_REGISTER_VI01, 1));
+    appendInstructionPair(&instructions, VPU_NOP);
+    appendInstructionPair(&instructions, VPU_E_BIT | VPU_NOP);
+    appendInstructionPair(&instructions, VPU_NOP);
+
+    for (bool includeStallReasons : {false, true})
+    {
+      VPU vpu;
+      std::vector<VPUTraceEvent> events;
+      vpu.uploadMicroInstructions(instructions);
+      vpu.setTraceCallback([&events](const VPUTraceEvent &event) {
+        events.push_back(event);
+      }, includeStallReasons);
+      vpu.initMicroMode();
+
+      std::vector<VPUTraceEvent> stalls =
+        eventsOfType(events, VPUTraceEventType::PipelineStall);
+      REQUIRE(stalls.size() == 5);
+      for (const VPUTraceEvent &stall : stalls)
+      {
+        CAPTURE(includeStallReasons);
+        if (includeStallReasons)
+        {
+          REQUIRE(stall.stallReason.unit == VPUStallUnit::Lower);
+          REQUIRE(stall.stallReason.registerClass ==
+            VPUStallRegisterClass::Integer);
+          REQUIRE(stall.stallReason.registerID == VPU_REGISTER_VI01);
+          REQUIRE(stall.stallReason.fieldMask == FP_REGISTER_NO_FIELDS);
+          REQUIRE(stall.stallReason.blockingInstructionAddress == 0);
+        }
+        else
+        {
+          REQUIRE(stall.stallReason.unit == VPUStallUnit::None);
+        }
+      }
+    }
+  }
+
+  SECTION("Upper and SQI stall reasons name the blocking lanes and pipeline")
+  {
+    VPU vpu;
+    std::vector<uint8_t> instructions;
+    std::vector<VPUTraceEvent> events;
+    vpu.writeDataMemory(0, wordBytes(0x3f800000));
+
+    appendInstructionPair(
+      &instructions,
+      VPU_NOP,
+      lq(
+        FP_REGISTER_X_FIELD | FP_REGISTER_Y_FIELD,
+        VPU_REGISTER_VF02,
+        VPU_REGISTER_VI00,
+        0));
+    appendInstructionPair(
+      &instructions,
+      add(
+        VPU_DEST_X_BIT | VPU_DEST_Z_BIT,
+        VPU_REGISTER_VF02,
+        VPU_REGISTER_VF03,
+        VPU_REGISTER_VF04));
+    appendInstructionPair(
+      &instructions,
+      VPU_E_BIT | VPU_NOP,
+      sqi(FP_REGISTER_X_FIELD, VPU_REGISTER_VF04, VPU_REGISTER_VI02));
+    appendInstructionPair(&instructions, VPU_NOP);
+
+    vpu.uploadMicroInstructions(instructions);
+    vpu.setTraceCallback([&events](const VPUTraceEvent &event) {
+      events.push_back(event);
+    }, true);
+    vpu.initMicroMode();
+
+    std::vector<VPUTraceEvent> stalls =
+      eventsOfType(events, VPUTraceEventType::PipelineStall);
+    bool upperStall = false;
+    bool lowerStall = false;
+    for (const VPUTraceEvent &stall : stalls)
+    {
+      const VPUStallReason &reason = stall.stallReason;
+      REQUIRE(reason.registerClass == VPUStallRegisterClass::Float);
+      if (reason.unit == VPUStallUnit::Upper)
+      {
+        upperStall = true;
+        REQUIRE(reason.registerID == VPU_REGISTER_VF02);
+        REQUIRE(reason.fieldMask == FP_REGISTER_X_FIELD);
+        REQUIRE(reason.blockingInstructionAddress == 0);
+      }
+      else
+      {
+        lowerStall = true;
+        REQUIRE(reason.unit == VPUStallUnit::Lower);
+        REQUIRE(reason.registerID == VPU_REGISTER_VF04);
+        REQUIRE(reason.fieldMask == FP_REGISTER_X_FIELD);
+        REQUIRE(reason.blockingInstructionAddress == 8);
+      }
+    }
+    REQUIRE(upperStall);
+    REQUIRE(lowerStall);
+  }
 }
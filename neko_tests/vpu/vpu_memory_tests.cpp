@@ -75,6 +75,77 @@ TEST_CASE("VPU Memory Tests")
     REQUIRE(vpu.terminationPosition() == 2);
   }
 
+  SECTION("Micro-memory writes patch instruction pairs at an offset without moving the PC")
+  {
+    VPU vpu;
+    std::vector<uint8_t> program;
+    std::vector<uint8_t> patch;
+    appendInstruction(&program, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&program, VPU_E_BIT | VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&program, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&patch, VPU_E_BIT | VPU_NOP, VPU_LOWER_NOP);
+
+    vpu.uploadMicroInstructions(program);
+    vpu.startMicroMode(8);
+    vpu.stepInstruction();
+
+    REQUIRE(vpu.writeMicroMemory(0, patch) == 1);
+    REQUIRE(vpu.programCounter() == 16);
+  }
+
+  SECTION("Micro-memory writes report only instruction pairs whose contents changed")
+  {
+    VPU vpu;
+    std::vector<uint8_t> program;
+    std::vector<uint8_t> overlay;
+    appendInstruction(&program, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&program, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&program, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&overlay, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&overlay, VPU_E_BIT | VPU_NOP, VPU_LOWER_NOP);
+
+    vpu.uploadMicroInstructions(program);
+
+    REQUIRE(vpu.writeMicroMemory(0, program) == 0);
+    REQUIRE(vpu.writeMicroMemory(8, overlay) == 1);
+    REQUIRE(vpu.writeMicroMemory(8, overlay) == 0);
+  }
+
+  SECTION("Patched instruction pairs are decoded again after they have executed")
+  {
+    VPU vpu;
+    std::vector<uint8_t> program;
+    std::vector<uint8_t> patch;
+    appendInstruction(&program, VPU_E_BIT | VPU_NOP, 0x12010005);
+    appendInstruction(&program, VPU_NOP, VPU_LOWER_NOP);
+    appendInstruction(&patch, VPU_E_BIT | VPU_NOP, 0x12010007);
+
+    vpu.uploadMicroInstructions(program);
+    vpu.initMicroMode();
+    REQUIRE(vpu.intRegisterValue(VPU_REGISTER_VI01) == 0xfffb);
+
+    vpu.writeMicroMemory(0, patch);
+    vpu.initMicroMode();
+    REQUIRE(vpu.intRegisterValue(VPU_REGISTER_VI01) == 0xfff9);
+  }
+
+  SECTION("Micro-memory writes are checked for alignment and capacity")
+  {
+    VPU vpu;
+    std::vector<uint8_t> pair(8, 0);
+
+    REQUIRE_NOTHROW(vpu.writeMicroMemory(vpu.microMemorySize() - 8, pair));
+    REQUIRE_THROWS_WITH(
+      vpu.writeMicroMemory(4, pair),
+      "VU micro-memory address must be 8-byte aligned.");
+    REQUIRE_THROWS_WITH(
+      vpu.writeMicroMemory(vpu.microMemorySize(), pair),
+      "Microprogram exceeds VU micro memory.");
+    REQUIRE_THROWS_WITH(
+      vpu.writeMicroMemory(0, std::vector<uint8_t>(7, 0)),
+      "Microprogram size must be a multiple of 8 bytes.");
+  }
+
   SECTION("Raw lower destination masks map encoded x to the internal x lane")
   {
     VPU vpu;
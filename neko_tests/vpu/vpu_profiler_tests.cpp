@@ -0,0 +1,191 @@
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu/integration/vpu_integration_test_utils.hpp"
+#include "vpu_disassembler.hpp"
+#include "vpu_opcodes.hpp"
+#include "vpu_profiler.hpp"
+
+namespace
+{
+  std::uint64_t countEvents(
+    const std::vector<VPUTraceEvent> &events,
+    VPUTraceEventType type)
+  {
+    std::uint64_t count = 0;
+    for (const VPUTraceEvent &event : events)
+    {
+      count += event.type == type ? 1 : 0;
+    }
+    return count;
+  }
+
+  VPUProfileReport profileFixture(
+    const std::string &name,
+    const VPUProfilerOptions &options = VPUProfilerOptions())
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      if (fixture.name == name)
+      {
+        VPU vpu;
+        VPUProfiler profiler(vpu.microMemorySize(), options);
+        profileVPUProgram(&vpu, fixture.config, &profiler);
+        return profiler.report(fixture.config.microProgram);
+      }
+    }
+    throw std::runtime_error("Unknown fixture.");
+  }
+}
+
+TEST_CASE("VPU Profiler")
+{
+  SECTION("Per-PC counts add up to the events of a traced run")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      VPUProgramRunConfig traced = fixture.config;
+      traced.captureTrace = true;
+      VPU tracedVPU;
+      VPUProgramRunResult expected = runVPUProgram(&tracedVPU, traced);
+
+      VPU vpu;
+      VPUProfiler profiler(vpu.microMemorySize());
+      VPUProgramRunResult result =
+        profileVPUProgram(&vpu, fixture.config, &profiler);
+      VPUProfileReport report = profiler.report(fixture.config.microProgram);
+
+      std::uint64_t writebacks = 0;
+      for (const VPUProfileRow &row : report.rows)
+      {
+        writebacks += row.writebacks;
+      }
+
+      CAPTURE(fixture.name);
+      REQUIRE(result.elapsedCycles == expected.elapsedCycles);
+      REQUIRE(result.outputMemory == expected.outputMemory);
+      REQUIRE(report.issueCycles == countEvents(
+        expected.traceEvents, VPUTraceEventType::InstructionIssued));
+      REQUIRE(report.stallCycles == countEvents(
+        expected.traceEvents, VPUTraceEventType::PipelineStall));
+      REQUIRE(writebacks == countEvents(
+        expected.traceEvents, VPUTraceEventType::PipelineWriteback));
+    }
+  }
+
+  SECTION("Dual-issued pairs are counted separately from single issues")
+  {
+    VPUProfileReport report = profileFixture("dual_issue");
+
+    std::uint64_t dualIssueCycles = 0;
+    for (const VPUProfileRow &row : report.rows)
+    {
+      dualIssueCycles += row.dualIssue ? row.executions : 0;
+    }
+    REQUIRE(report.dualIssueCycles > 0);
+    REQUIRE(report.dualIssueCycles < report.issueCycles);
+    REQUIRE(report.dualIssueCycles == dualIssueCycles);
+  }
+
+  SECTION("Stall cycles are attributed to the blocking register and lanes")
+  {
+    VPUProfilerOptions options;
+    options.collectStallCauses = true;
+    VPUProfileReport report = profileFixture("vector_kernel", options);
+
+    REQUIRE(report.stallCycles > 0);
+    for (const VPUProfileRow &row : report.rows)
+    {
+      std::uint64_t causeCycles = 0;
+      for (const VPUProfileStallCause &cause : row.stallCauses)
+      {
+        REQUIRE(cause.reason.unit != VPUStallUnit::None);
+        REQUIRE(cause.reason.registerClass != VPUStallRegisterClass::None);
+        causeCycles += cause.cycles;
+      }
+
+      CAPTURE(row.instructionAddress);
+      REQUIRE((row.stallCycles == 0 || row.executions > 0));
+      REQUIRE(causeCycles == row.stallCycles);
+    }
+  }
+
+  SECTION("Stall causes are only collected when asked for")
+  {
+    VPUProfileReport report = profileFixture("vector_kernel");
+
+    REQUIRE(report.stallCycles > 0);
+    for (const VPUProfileRow &row : report.rows)
+    {
+      REQUIRE(row.stallCauses.empty());
+    }
+  }
+
+  SECTION("Reports are annotated with disassembly")
+  {
+    std::vector<std::uint8_t> microProgram;
+    vpu_integration::appendWord(&microProgram,
+      VPU_IADD_ENCODING | (2 << 16) | (1 << 11) | (3 << 6));
+    vpu_integration::appendWord(&microProgram,
+      VPU_DEST_ALL_FIELDS | (2 << 16) | (1 << 11) | (3 << 6) | VPU_ADD);
+    VPUProfiler profiler(0x1000);
+    VPUTraceEvent event = {};
+    event.type = VPUTraceEventType::InstructionIssued;
+    profiler.record(event);
+    event.type = VPUTraceEventType::PipelineStall;
+    profiler.record(event);
+
+    VPUProfileReport report = profiler.report(microProgram);
+    std::ostringstream text;
+    writeVPUProfileText(text, report);
+    std::ostringstream json;
+    writeVPUProfileJson(json, report);
+
+    REQUIRE(report.rows.size() == 1);
+    REQUIRE(report.rows[0].dualIssue);
+    REQUIRE(report.rows[0].disassembly ==
+      "ADD.xyzw VF03, VF01, VF02 | IADD VI03, VI01, VI02");
+    REQUIRE(text.str().find(
+      "0x0000            1       1  100.0%   yes           0  ADD.xyzw") !=
+      std::string::npos);
+    REQUIRE(json.str() ==
+      "{\"issue_cycles\":1,\"stall_cycles\":1,\"dual_issue_cycles\":1,"
+      "\"instructions\":[{\"instruction_address\":0,\"executions\":1,"
+      "\"stall_cycles\":1,\"writebacks\":0,\"dual_issue\":true,"
+      "\"disassembly\":\"ADD.xyzw VF03, VF01, VF02 | IADD VI03, VI01, "
+      "VI02\",\"stall_causes\":[]}]}\n");
+  }
+
+  SECTION("Unsupported words and immediates are disassembled without failing")
+  {
+    REQUIRE(disassembleVPUUpperInstruction(VPU_E_BIT | VPU_NOP) == "NOP [E]");
+    REQUIRE(disassembleVPULowerInstruction(0x7fffffff) ==
+      ".word 0x7fffffff");
+    REQUIRE(disassembleVPUInstructionPair(
+      VPU_I_BIT | VPU_NOP, 0x3f800000) == "NOP [I] | LOI 0x3f800000");
+    REQUIRE_FALSE(isVPUDualIssuePair(VPU_NOP, VPU_LOWER_NOP));
+  }
+
+  SECTION("Invalid profiler setups are rejected")
+  {
+    REQUIRE_THROWS_WITH(
+      VPUProfiler(12),
+      "VU profiler memory size must be a power of two of at least 8 bytes.");
+
+    VPUProgramRunConfig config;
+    config.microProgram = std::vector<std::uint8_t>(8, 0);
+    config.captureTrace = true;
+    VPU vpu;
+    VPUProfiler profiler(vpu.microMemorySize());
+    REQUIRE_THROWS_WITH(
+      profileVPUProgram(&vpu, config, &profiler),
+      "VU profiling cannot be combined with trace capture.");
+  }
+}
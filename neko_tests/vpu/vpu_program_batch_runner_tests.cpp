@@ -0,0 +1,158 @@
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_test_utils.hpp"
+#include "vpu_opcodes.hpp"
+#include "vpu_program_batch_runner.hpp"
+
+namespace
+{
+  std::vector<VPUDataMemoryWrite> integerFillInput(
+    std::uint16_t count,
+    std::uint16_t firstValue,
+    std::uint16_t increment)
+  {
+    VPUDataMemoryWrite parameters;
+    vpu_integration::appendWord(&parameters.data, count);
+    vpu_integration::appendWord(&parameters.data, firstValue);
+    vpu_integration::appendWord(&parameters.data, increment);
+    vpu_integration::appendWord(&parameters.data, 0);
+    return {parameters};
+  }
+
+  VPUProgramRunConfig integerFillProgram()
+  {
+    VPUProgramRunConfig config;
+    config.microProgram = vpu_integration::readBinary("integer_fill.bin");
+    config.cycleBudget = 400;
+    config.outputSize = 6 * 16;
+    return config;
+  }
+}
+
+TEST_CASE("VPU Program Batch Runner")
+{
+  SECTION("Input sets produce the same results as serial runs in input order")
+  {
+    VPUProgramRunConfig program = integerFillProgram();
+    std::vector<std::vector<VPUDataMemoryWrite>> inputSets;
+    for (std::uint16_t run = 0; run < 24; run++)
+    {
+      inputSets.push_back(integerFillInput(1 + run % 6, run * 7, run + 1));
+    }
+    VPUProgramBatchOptions options;
+    options.workerCount = 4;
+
+    std::vector<VPUProgramRunResult> results =
+      runVPUProgramBatch(VPUType::VU0, program, inputSets, options);
+
+    REQUIRE(results.size() == inputSets.size());
+    for (std::size_t run = 0; run < inputSets.size(); run++)
+    {
+      VPU vpu;
+      VPUProgramRunResult expected =
+        runVPUProgram(&vpu, program, inputSets[run]);
+
+      CAPTURE(run);
+      REQUIRE(results[run].state == expected.state);
+      REQUIRE(results[run].elapsedCycles == expected.elapsedCycles);
+      REQUIRE(results[run].programCounter == expected.programCounter);
+      REQUIRE(results[run].outputMemory == expected.outputMemory);
+    }
+  }
+
+  SECTION("Workers do not carry state from one job into the next")
+  {
+    VPUProgramRunConfig program = integerFillProgram();
+    std::vector<std::vector<VPUDataMemoryWrite>> inputSets = {
+      integerFillInput(6, 0x40, 1),
+      integerFillInput(1, 0x10, 1)
+    };
+    VPUProgramBatchOptions options;
+    options.workerCount = 1;
+
+    std::vector<VPUProgramRunResult> results =
+      runVPUProgramBatch(VPUType::VU0, program, inputSets, options);
+
+    std::vector<std::uint8_t> secondOutput(
+      results[1].outputMemory.begin() + 16,
+      results[1].outputMemory.end());
+    REQUIRE(secondOutput == std::vector<std::uint8_t>(5 * 16, 0));
+  }
+
+  SECTION("Trace output matches serial runs written in job order")
+  {
+    for (bool async : {false, true})
+    {
+      VPUProgramRunConfig program = integerFillProgram();
+      program.asyncTraceOutput = async;
+      std::vector<std::vector<VPUDataMemoryWrite>> inputSets;
+      for (std::uint16_t run = 0; run < 12; run++)
+      {
+        inputSets.push_back(integerFillInput(1 + run % 6, run, 1));
+      }
+
+      std::ostringstream serial;
+      program.traceOutput = &serial;
+      for (const std::vector<VPUDataMemoryWrite> &inputMemory : inputSets)
+      {
+        VPU vpu;
+        runVPUProgram(&vpu, program, inputMemory);
+      }
+
+      std::ostringstream batch;
+      program.traceOutput = &batch;
+      VPUProgramBatchOptions options;
+      options.workerCount = 4;
+      runVPUProgramBatch(VPUType::VU0, program, inputSets, options);
+
+      CAPTURE(async);
+      REQUIRE(!serial.str().empty());
+      REQUIRE(batch.str() == serial.str());
+    }
+  }
+
+  SECTION("Jobs can target VU0 and VU1 in one batch")
+  {
+    std::vector<VPUProgramBatchJob> jobs(2);
+    for (VPUProgramBatchJob &job : jobs)
+    {
+      vpu_integration::appendWord(&job.config.microProgram, VPU_LOWER_NOP);
+      vpu_integration::appendWord(&job.config.microProgram, VPU_E_BIT | VPU_NOP);
+      vpu_integration::appendWord(&job.config.microProgram, VPU_LOWER_NOP);
+      vpu_integration::appendWord(&job.config.microProgram, VPU_NOP);
+      job.config.cycleBudget = 10;
+      job.config.outputSize = 4;
+    }
+    jobs[1].type = VPUType::VU1;
+    jobs[1].config.outputAddress = 0x3ffc;
+    jobs[1].config.inputMemory.push_back({0x3ffc, {1, 2, 3, 4}});
+
+    std::vector<VPUProgramRunResult> results = runVPUProgramBatch(jobs);
+
+    REQUIRE(results[0].state == VPU_STATE_READY);
+    REQUIRE(results[1].state == VPU_STATE_READY);
+    REQUIRE(results[1].outputMemory == std::vector<std::uint8_t>({1, 2, 3, 4}));
+  }
+
+  SECTION("The first failing job in job order is reported")
+  {
+    std::vector<VPUProgramBatchJob> jobs(8);
+    for (VPUProgramBatchJob &job : jobs)
+    {
+      job.config.microProgram = std::vector<std::uint8_t>(8, 0);
+      job.config.cycleBudget = 10;
+    }
+    jobs[3].config.outputSize = 0x2000;
+    vpu_integration::appendWord(&jobs[5].config.microProgram, 0);
+    VPUProgramBatchOptions options;
+    options.workerCount = 3;
+
+    REQUIRE_THROWS_WITH(
+      runVPUProgramBatch(jobs, options),
+      "VU data-memory read is outside memory.");
+  }
+}
@@ -2,6 +2,7 @@
 #include <vector>
 
 #include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
 #include "vpu_opcodes.hpp"
 #include "vpu_program_runner.hpp"
 
@@ -78,4 +79,99 @@ TEST_CASE("VPU Program Runner Diagnostics")
       "\"lower_instruction\":2147484476,\"opcode\":0,"
       "\"destination_register\":0,\"destination_field_mask\":0}\n");
   }
+
+  SECTION("Checkpoint replay reproduces any trace window of a full run")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      VPUProgramRunConfig fullConfig = fixture.config;
+      fullConfig.captureTrace = true;
+      VPU fullVPU;
+      VPUProgramRunResult fullRun = runVPUProgram(&fullVPU, fullConfig);
+
+      std::vector<VPUProgramCheckpoint> checkpoints;
+      VPU recordingVPU;
+      VPUProgramRunResult recordedRun = recordVPUProgramCheckpoints(
+        &recordingVPU, fixture.config, 7, &checkpoints);
+
+      CAPTURE(fixture.name);
+      REQUIRE(recordedRun.elapsedCycles == fullRun.elapsedCycles);
+      REQUIRE(recordedRun.outputMemory == fullRun.outputMemory);
+      REQUIRE(recordedRun.traceEvents.empty());
+      REQUIRE(checkpoints.size() == (fullRun.elapsedCycles + 6) / 7 + 1);
+      REQUIRE(checkpoints.front().cycle == 0);
+      REQUIRE(checkpoints.back().cycle == fullRun.elapsedCycles);
+
+      for (std::uint32_t start = 0; start < fullRun.elapsedCycles; start += 5)
+      {
+        VPUProgramRunConfig windowConfig = fixture.config;
+        windowConfig.captureTrace = true;
+        windowConfig.traceStartCycle = start;
+        windowConfig.traceEndCycle = start + 9;
+        VPU replayVPU;
+
+        VPUProgramRunResult window =
+          replayVPUTraceWindow(&replayVPU, windowConfig, checkpoints);
+
+        std::vector<VPUTraceEvent> expected;
+        for (const VPUTraceEvent &event : fullRun.traceEvents)
+        {
+          if (event.cycle >= start && event.cycle <= start + 9)
+          {
+            expected.push_back(event);
+          }
+        }
+        CAPTURE(start);
+        REQUIRE(window.traceEvents.size() == expected.size());
+        for (std::size_t event = 0; event < expected.size(); event++)
+        {
+          REQUIRE(window.traceEvents[event].type == expected[event].type);
+          REQUIRE(window.traceEvents[event].cycle == expected[event].cycle);
+          REQUIRE(window.traceEvents[event].instructionAddress ==
+            expected[event].instructionAddress);
+          REQUIRE(window.traceEvents[event].opCode == expected[event].opCode);
+        }
+        if (start + 10 < fullRun.elapsedCycles)
+        {
+          REQUIRE(window.state == VPU_STATE_RUN);
+          REQUIRE(window.elapsedCycles == start + 10);
+        }
+        else
+        {
+          REQUIRE(window.state == fullRun.state);
+          REQUIRE(window.outputMemory == fullRun.outputMemory);
+        }
+      }
+    }
+  }
+
+  SECTION("Checkpoint recording and replay reject unusable arguments")
+  {
+    VPU vpu;
+    VPUProgramRunConfig config;
+    appendInstructionPair(&config.microProgram, VPU_E_BIT | VPU_NOP);
+    appendInstructionPair(&config.microProgram, VPU_NOP);
+    config.cycleBudget = 10;
+    std::vector<VPUProgramCheckpoint> checkpoints;
+
+    REQUIRE_THROWS_WITH(
+      recordVPUProgramCheckpoints(&vpu, config, 0, &checkpoints),
+      "VU checkpoint interval must be greater than zero.");
+    REQUIRE_THROWS_WITH(
+      replayVPUTraceWindow(&vpu, config, checkpoints),
+      "No VU checkpoint precedes the trace window.");
+
+    recordVPUProgramCheckpoints(&vpu, config, 4, &checkpoints);
+    VPUProgramRunConfig otherProgram = config;
+    otherProgram.microProgram[0] ^= 1;
+    REQUIRE_THROWS_WITH(
+      replayVPUTraceWindow(&vpu, otherProgram, checkpoints),
+      "VU checkpoints were recorded for a different program.");
+
+    checkpoints.erase(checkpoints.begin());
+    REQUIRE_THROWS_WITH(
+      replayVPUTraceWindow(&vpu, config, checkpoints),
+      "No VU checkpoint precedes the trace window.");
+  }
 }
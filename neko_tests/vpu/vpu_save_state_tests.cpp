@@ -0,0 +1,219 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_program_runner.hpp"
+#include "vpu_register_ids.hpp"
+
+namespace
+{
+  struct ReferenceRun
+  {
+    std::vector<VPUTraceEvent> traceEvents;
+    std::vector<std::size_t> traceEventsAfterCycle;
+    std::vector<std::uint8_t> finalState;
+    std::vector<std::uint8_t> outputMemory;
+  };
+
+  ReferenceRun runReference(const VPUProgramRunConfig &config)
+  {
+    ReferenceRun reference;
+    VPU vpu;
+    vpu.setTraceCallback([&reference](const VPUTraceEvent &event) {
+      reference.traceEvents.push_back(event);
+    });
+    vpu.uploadMicroInstructions(config.microProgram);
+    for (const VPUDataMemoryWrite &write : config.inputMemory)
+    {
+      vpu.writeDataMemory(write.address, write.data);
+    }
+    vpu.resetCycles();
+    vpu.startMicroMode(config.startAddress);
+
+    reference.traceEventsAfterCycle.push_back(0);
+    while (vpu.getState() == VPU_STATE_RUN &&
+      reference.traceEventsAfterCycle.size() <= config.cycleBudget)
+    {
+      vpu.run(1);
+      reference.traceEventsAfterCycle.push_back(reference.traceEvents.size());
+    }
+
+    vpu.setTraceCallback(VPUTraceCallback());
+    reference.finalState = vpu.saveState();
+    reference.outputMemory =
+      vpu.readDataMemory(config.outputAddress, config.outputSize);
+    return reference;
+  }
+
+  bool sameTraceEvent(const VPUTraceEvent &left, const VPUTraceEvent &right)
+  {
+    return left.type == right.type &&
+      left.cycle == right.cycle &&
+      left.instructionAddress == right.instructionAddress &&
+      left.upperInstruction == right.upperInstruction &&
+      left.lowerInstruction == right.lowerInstruction &&
+      left.opCode == right.opCode &&
+      left.destinationRegister == right.destinationRegister &&
+      left.destinationFieldMask == right.destinationFieldMask;
+  }
+
+  std::vector<std::uint8_t> midProgramState(VPUType type)
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    config.cycleBudget = 40;
+    VPU vpu(type);
+    runVPUProgram(&vpu, config);
+    return vpu.saveState();
+  }
+}
+
+TEST_CASE("VPU Save State")
+{
+  SECTION("Every integration fixture resumes identically from any cycle")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      ReferenceRun reference = runReference(fixture.config);
+      std::size_t totalCycles = reference.traceEventsAfterCycle.size() - 1;
+
+      CAPTURE(fixture.name);
+      for (std::size_t splitCycle = 0; splitCycle <= totalCycles; splitCycle++)
+      {
+        VPUProgramRunConfig firstHalf = fixture.config;
+        firstHalf.cycleBudget = splitCycle;
+        VPU first;
+        runVPUProgram(&first, firstHalf);
+        std::vector<std::uint8_t> state = first.saveState();
+
+        std::vector<VPUTraceEvent> resumedEvents;
+        VPU resumed;
+        resumed.loadState(state);
+        REQUIRE(resumed.saveState() == state);
+        resumed.setTraceCallback([&resumedEvents](const VPUTraceEvent &event) {
+          resumedEvents.push_back(event);
+        });
+        resumed.run(fixture.config.cycleBudget - splitCycle);
+        resumed.setTraceCallback(VPUTraceCallback());
+
+        CAPTURE(splitCycle);
+        std::size_t firstEvent = reference.traceEventsAfterCycle[splitCycle];
+        REQUIRE(resumedEvents.size() ==
+          reference.traceEvents.size() - firstEvent);
+        for (std::size_t event = 0; event < resumedEvents.size(); event++)
+        {
+          CAPTURE(event);
+          REQUIRE(sameTraceEvent(
+            resumedEvents[event],
+            reference.traceEvents[firstEvent + event]));
+        }
+        REQUIRE(resumed.saveState() == reference.finalState);
+        REQUIRE(resumed.readDataMemory(
+          fixture.config.outputAddress,
+          fixture.config.outputSize) == reference.outputMemory);
+      }
+    }
+  }
+
+  SECTION("Saving the same state twice produces identical bytes")
+  {
+    std::vector<std::uint8_t> state = midProgramState(VPUType::VU0);
+    std::vector<std::uint8_t> buffer(3, 0xff);
+
+    VPU vpu;
+    vpu.loadState(state);
+    vpu.saveState(&buffer);
+
+    REQUIRE(buffer == state);
+    REQUIRE(midProgramState(VPUType::VU0) == state);
+  }
+
+  SECTION("Loading a state replaces micro memory and its decoded instructions")
+  {
+    std::vector<std::uint8_t> state = midProgramState(VPUType::VU0);
+    VPU vpu;
+    vpu.uploadMicroInstructions(std::vector<std::uint8_t>(0x1000, 0x5a));
+    vpu.writeDataMemory(0, std::vector<std::uint8_t>(0x1000, 0xa5));
+
+    vpu.loadState(state);
+
+    REQUIRE(vpu.saveState() == state);
+    REQUIRE(vpu.getState() == VPU_STATE_RUN);
+    REQUIRE(vpu.elapsedCycles() == 40);
+  }
+
+  SECTION("States with a bad header, version or VU type are rejected")
+  {
+    std::vector<std::uint8_t> state = midProgramState(VPUType::VU0);
+    VPU vpu;
+
+    std::vector<std::uint8_t> badMagic = state;
+    badMagic[0] ^= 0xff;
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(badMagic),
+      "VU save state has an invalid header.");
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(std::vector<std::uint8_t>(3, 0)),
+      "VU save state has an invalid header.");
+
+    std::vector<std::uint8_t> badVersion = state;
+    badVersion[4] = VPU_SAVE_STATE_VERSION + 1;
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(badVersion),
+      "Unsupported VU save-state version.");
+
+    VPU vu1(VPUType::VU1);
+    REQUIRE_THROWS_WITH(
+      vu1.loadState(state),
+      "VU save state does not match this VU type.");
+  }
+
+  SECTION("States with an invalid execution state or mode are rejected")
+  {
+    // Header, 33 FP registers, 16 VI registers, then I, Q, P, R and the
+    // MAC, status and clipping flags precede the state and mode bytes.
+    const std::size_t stateOffset = 7 + 33 * 20 + 16 * 2 + 4 + 8 + 8 + 4 + 2 +
+      2 + 8;
+    std::vector<std::uint8_t> state = midProgramState(VPUType::VU0);
+    VPU vpu;
+
+    std::vector<std::uint8_t> badState = state;
+    badState[stateOffset] = 0xff;
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(badState),
+      "VU save state contains an invalid execution state.");
+
+    std::vector<std::uint8_t> badMode = state;
+    badMode[stateOffset + 1] = 0;
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(badMode),
+      "VU save state contains an invalid mode.");
+    badMode[stateOffset + 1] = 0xff;
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(badMode),
+      "VU save state contains an invalid mode.");
+  }
+
+  SECTION("Truncated or padded states are rejected and leave the VPU reset")
+  {
+    std::vector<std::uint8_t> state = midProgramState(VPUType::VU1);
+    VPU vpu(VPUType::VU1);
+    std::vector<std::uint8_t> resetState = vpu.saveState();
+
+    std::vector<std::uint8_t> truncated(state.begin(), state.end() - 1);
+    vpu.loadState(state);
+    REQUIRE_THROWS_WITH(vpu.loadState(truncated), "Save state is truncated.");
+    REQUIRE(vpu.saveState() == resetState);
+
+    std::vector<std::uint8_t> padded = state;
+    padded.push_back(0);
+    vpu.loadState(state);
+    REQUIRE_THROWS_WITH(
+      vpu.loadState(padded),
+      "VU save state has trailing data.");
+    REQUIRE(vpu.saveState() == resetState);
+  }
+}
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "vpu.hpp"
+#include "vpu_flags.hpp"
 #include "vpu_opcodes.hpp"
 #include "vpu_register_ids.hpp"
 
@@ -124,12 +125,112 @@ TEST_CASE("VPU State Tests")
 
     SECTION("VPU transitions to Ready state on reset")
     {
-      //WARN("Add this test");
+      std::vector<uint8_t> instructions;
+      appendInstructionPair(&instructions, VPU_NOP);
+      vpu.uploadMicroInstructions(instructions);
+      vpu.startMicroMode();
+      vpu.tick();
+
+      vpu.reset();
+
+      REQUIRE(vpu.getState() == VPU_STATE_READY);
+      REQUIRE(vpu.programCounter() == 0);
+      REQUIRE(vpu.elapsedCycles() == 0);
+      REQUIRE_FALSE(vpu.hasTerminationPosition());
     }
 
     SECTION("VPU control register is initialised on reset")
     {
-      //WARN("Add this test");
+      vpu.setDBitEnabled(true);
+      vpu.setTBitEnabled(true);
+
+      vpu.reset();
+
+      REQUIRE_FALSE(vpu.dBitEnabled());
+      REQUIRE_FALSE(vpu.tBitEnabled());
+    }
+
+    SECTION("Reset restores power-on registers, flags, and memories")
+    {
+      vpu.loadFPRegister(VPU_REGISTER_VF01, 1, 2, 3, 4);
+      vpu.loadFPRegister(VPU_REGISTER_VF02, 1, 1, 1, 1);
+      vpu.loadIntRegister(VPU_REGISTER_VI01, 7);
+      vpu.loadAccumulator(5, 6, 7, 8);
+      vpu.clippingFlags = 0x3f;
+      vpu.writeDataMemory(0, {1, 2, 3, 4});
+      runUpperInstruction(
+        &vpu,
+        VPU_DEST_ALL_FIELDS,
+        VPU_REGISTER_VF01,
+        VPU_REGISTER_VF01,
+        VPU_REGISTER_VF02,
+        VPU_SUB);
+      REQUIRE(vpu.hasMACFlag(VPU_FLAG_ZX));
+
+      vpu.reset();
+
+      REQUIRE(vpu.fpRegisterValue(VPU_REGISTER_VF00)->w == 1);
+      REQUIRE(vpu.fpRegisterValue(VPU_REGISTER_VF01)->x.bits() == 0);
+      REQUIRE(vpu.fpRegisterValue(VPU_REGISTER_VF02)->w.bits() == 0);
+      REQUIRE(vpu.intRegisterValue(VPU_REGISTER_VI01) == 0);
+      REQUIRE(vpu.accumulator.x.bits() == 0);
+      REQUIRE(vpu.clippingFlags == 0);
+      REQUIRE_FALSE(vpu.hasMACFlag(VPU_FLAG_ZX));
+      REQUIRE_FALSE(vpu.hasStatusFlag(VPU_FLAG_ZS));
+      REQUIRE(vpu.readDataMemory(0, 4) == std::vector<uint8_t>(4, 0));
+
+      std::vector<uint8_t> emptyPair(8, 0);
+      REQUIRE(vpu.writeMicroMemory(0, emptyPair) == 0);
+    }
+
+    SECTION("Reset can keep micro memory and data memory")
+    {
+      std::vector<uint8_t> instructions;
+      appendInstructionPair(&instructions, VPU_E_BIT | VPU_NOP);
+      appendInstructionPair(&instructions, VPU_NOP);
+      vpu.uploadMicroInstructions(instructions);
+      vpu.writeDataMemory(16, {9, 8, 7, 6});
+      vpu.initMicroMode();
+
+      VPUResetOptions options;
+      options.keepMicroMemory = true;
+      options.keepDataMemory = true;
+      vpu.reset(options);
+
+      REQUIRE(vpu.writeMicroMemory(0, instructions) == 0);
+      REQUIRE(vpu.readDataMemory(16, 4) == std::vector<uint8_t>({9, 8, 7, 6}));
+      vpu.initMicroMode();
+      REQUIRE(vpu.terminationPosition() == 2);
+    }
+
+    SECTION("Reset stops a running VPU and clears in-flight pipelines")
+    {
+      vpu.loadFPRegister(VPU_REGISTER_VF01, 1, 2, 3, 4);
+      std::vector<uint8_t> instructions;
+      appendInstructionPair(
+        &instructions,
+        VPU_DEST_ALL_FIELDS |
+        (VPU_REGISTER_VF01 << VPU_FT_REG_SHIFT) |
+        (VPU_REGISTER_VF01 << VPU_FS_REG_SHIFT) |
+        (VPU_REGISTER_VF03 << VPU_FD_REG_SHIFT) |
+        VPU_ADD);
+      appendInstructionPair(&instructions, VPU_E_BIT | VPU_NOP);
+      appendInstructionPair(&instructions, VPU_NOP);
+      vpu.uploadMicroInstructions(instructions);
+      vpu.startMicroMode();
+      vpu.tick();
+
+      VPUResetOptions options;
+      options.keepMicroMemory = true;
+      vpu.reset(options);
+      REQUIRE(vpu.getState() == VPU_STATE_READY);
+
+      vpu.loadFPRegister(VPU_REGISTER_VF01, 1, 2, 3, 4);
+      vpu.startMicroMode(8);
+      vpu.run(20);
+
+      REQUIRE(vpu.fpRegisterValue(VPU_REGISTER_VF03)->x.bits() == 0);
+      REQUIRE(vpu.fpRegisterValue(VPU_REGISTER_VF03)->w.bits() == 0);
     }
 
     SECTION("VPU transitions from Ready to Run when a micro subroutine is started")
@@ -351,6 +452,43 @@ TEST_CASE("VPU State Tests")
       REQUIRE_FALSE(vpu.hasTerminationPosition());
     }
 
+    SECTION("runUntil stops at the deadline while the program is running")
+    {
+      std::vector<uint8_t> instructions;
+      for (int pair = 0; pair < 6; pair++)
+      {
+        appendInstructionPair(&instructions, VPU_NOP);
+      }
+      appendInstructionPair(&instructions, VPU_E_BIT | VPU_NOP);
+      appendInstructionPair(&instructions, VPU_NOP);
+      vpu.uploadMicroInstructions(instructions);
+      vpu.startMicroMode();
+
+      REQUIRE(vpu.runUntil(3) == 3);
+      REQUIRE(vpu.elapsedCycles() == 3);
+      REQUIRE(vpu.getState() == VPU_STATE_RUN);
+      REQUIRE(vpu.runUntil(2) == 3);
+
+      uint64_t terminationCycle = vpu.runUntil(100);
+
+      REQUIRE(vpu.getState() == VPU_STATE_READY);
+      REQUIRE(terminationCycle == 9);
+      REQUIRE(vpu.elapsedCycles() == terminationCycle);
+      REQUIRE(vpu.runUntil(100) == VPU_CYCLE_IDLE);
+      REQUIRE(vpu.elapsedCycles() == 100);
+    }
+
+    SECTION("The cycle timeline does not wrap at 32 bits")
+    {
+      uint64_t start = 0x100000000ull + 5;
+      REQUIRE(vpu.runUntil(start) == VPU_CYCLE_IDLE);
+
+      runTerminatingInstruction(&vpu, VPU_E_BIT);
+
+      REQUIRE(vpu.elapsedCycles() > start);
+      REQUIRE(vpu.elapsedCycles() < start + 10);
+    }
+
     SECTION("VPU cannot receive micro program startup from the VIF while in Stop state")
     {
       //WARN("Add this test");
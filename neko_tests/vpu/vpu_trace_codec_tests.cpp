@@ -0,0 +1,263 @@
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_program_runner.hpp"
+#include "vpu_trace_codec.hpp"
+
+namespace
+{
+  bool sameTraceEvent(const VPUTraceEvent &left, const VPUTraceEvent &right)
+  {
+    return left.type == right.type &&
+      left.cycle == right.cycle &&
+      left.instructionAddress == right.instructionAddress &&
+      left.upperInstruction == right.upperInstruction &&
+      left.lowerInstruction == right.lowerInstruction &&
+      left.opCode == right.opCode &&
+      left.destinationRegister == right.destinationRegister &&
+      left.destinationFieldMask == right.destinationFieldMask &&
+      left.stallReason.unit == right.stallReason.unit &&
+      left.stallReason.registerClass == right.stallReason.registerClass &&
+      left.stallReason.registerID == right.stallReason.registerID &&
+      left.stallReason.fieldMask == right.stallReason.fieldMask &&
+      left.stallReason.blockingInstructionAddress ==
+        right.stallReason.blockingInstructionAddress;
+  }
+
+  std::vector<VPUTraceEvent> kernelEvents(bool stallReasons = false)
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    config.captureTrace = true;
+    config.traceStallReasons = stallReasons;
+    VPU vpu;
+    return runVPUProgram(&vpu, config).traceEvents;
+  }
+
+  std::string encode(
+    const std::vector<VPUTraceEvent> &events,
+    std::uint32_t blockEventCount)
+  {
+    std::ostringstream output;
+    VPUBinaryTraceHeader header;
+    header.type = VPUType::VU1;
+    header.programHash = 0x1234;
+    VPUTraceEncoder encoder(&output, header, blockEventCount);
+    for (const VPUTraceEvent &event : events)
+    {
+      encoder.write(event);
+    }
+    encoder.finish();
+    return output.str();
+  }
+
+  VPUTraceEvent syntheticEvent(
+    std::uint64_t cycle,
+    std::uint16_t address,
+    std::uint32_t upper,
+    std::uint32_t lower)
+  {
+    VPUTraceEvent event = {};
+    event.type = VPUTraceEventType::PipelineWriteback;
+    event.cycle = cycle;
+    event.instructionAddress = address;
+    event.upperInstruction = upper;
+    event.lowerInstruction = lower;
+    event.opCode = 0x1ff;
+    event.destinationRegister = 7;
+    event.destinationFieldMask = 0xf;
+    return event;
+  }
+}
+
+TEST_CASE("VPU Trace Codec")
+{
+  SECTION("Fixture traces round-trip and are smaller than fixed records")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      VPUProgramRunConfig config = fixture.config;
+      config.captureTrace = true;
+      std::ostringstream compressed;
+      config.traceOutput = &compressed;
+      config.traceOutputFormat = VPUTraceOutputFormat::Compressed;
+      VPU vpu;
+      VPUProgramRunResult result = runVPUProgram(&vpu, config);
+      std::istringstream input(compressed.str());
+
+      VPUTraceDecoder decoder(&input);
+
+      CAPTURE(fixture.name);
+      REQUIRE(decoder.header().type == VPUType::VU0);
+      REQUIRE(decoder.header().programHash ==
+        hashVPUProgram(config.microProgram));
+      REQUIRE(decoder.eventCount() == result.traceEvents.size());
+      VPUTraceEvent event;
+      for (const VPUTraceEvent &expected : result.traceEvents)
+      {
+        REQUIRE(decoder.read(&event));
+        REQUIRE(sameTraceEvent(event, expected));
+      }
+      REQUIRE_FALSE(decoder.read(&event));
+      REQUIRE(compressed.str().size() * 2 <
+        result.traceEvents.size() * VPU_BINARY_TRACE_RECORD_SIZE);
+    }
+  }
+
+  SECTION("Any event can be reached by index or by cycle")
+  {
+    std::vector<VPUTraceEvent> events = kernelEvents();
+    std::istringstream input(encode(events, 5));
+    VPUTraceDecoder decoder(&input);
+    VPUTraceEvent event;
+
+    REQUIRE(decoder.blockEventCount() == 5);
+    for (std::uint64_t index = events.size(); index-- > 0;)
+    {
+      decoder.seek(index);
+      REQUIRE(decoder.position() == index);
+      REQUIRE(decoder.read(&event));
+      REQUIRE(sameTraceEvent(event, events[index]));
+    }
+
+    for (std::uint32_t cycle = 0; cycle <= events.back().cycle + 1; cycle++)
+    {
+      std::uint64_t expected = 0;
+      while (expected < events.size() && events[expected].cycle < cycle)
+      {
+        expected++;
+      }
+
+      decoder.seekCycle(cycle);
+      CAPTURE(cycle);
+      REQUIRE(decoder.position() == expected);
+    }
+  }
+
+  SECTION("Irregular cycles, addresses and repeated words round-trip")
+  {
+    std::vector<VPUTraceEvent> events = {
+      syntheticEvent(0, 0, 0xaaaa5555, 0xaaaa5555),
+      syntheticEvent(0xfffffff0, 0x3ff8, 0xaaaa5555, 0x12345678),
+      syntheticEvent(0xfffffff0, 0, 0x12345678, 0xaaaa5555),
+      syntheticEvent(3, 0x10, 0, 0)
+    };
+    events[3].type = VPUTraceEventType::ForceBreak;
+    events[3].opCode = 0;
+    std::istringstream input(encode(events, 3));
+    VPUTraceDecoder decoder(&input);
+    VPUTraceEvent event;
+
+    for (const VPUTraceEvent &expected : events)
+    {
+      REQUIRE(decoder.read(&event));
+      REQUIRE(sameTraceEvent(event, expected));
+    }
+
+    std::istringstream empty(encode({}, 3));
+    VPUTraceDecoder emptyDecoder(&empty);
+    REQUIRE(emptyDecoder.eventCount() == 0);
+    REQUIRE_FALSE(emptyDecoder.read(&event));
+    REQUIRE_NOTHROW(emptyDecoder.seekCycle(10));
+  }
+
+  SECTION("Cycles past 2^32 round-trip and stay seekable")
+  {
+    const std::uint64_t boundary = std::uint64_t(1) << 32;
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    VPU vpu;
+    std::vector<VPUTraceEvent> events;
+    vpu.uploadMicroInstructions(config.microProgram);
+    for (const VPUDataMemoryWrite &write : config.inputMemory)
+    {
+      vpu.writeDataMemory(write.address, write.data);
+    }
+    vpu.runUntil(boundary - 8);
+    vpu.setTraceCallback([&events](const VPUTraceEvent &event) {
+      events.push_back(event);
+    });
+    vpu.startMicroMode(config.startAddress);
+    vpu.run(config.cycleBudget);
+    vpu.setTraceCallback(VPUTraceCallback());
+
+    REQUIRE(events.front().cycle < boundary);
+    REQUIRE(events.back().cycle > boundary);
+
+    std::istringstream input(encode(events, 5));
+    VPUTraceDecoder decoder(&input);
+    VPUTraceEvent event;
+    for (const VPUTraceEvent &expected : events)
+    {
+      REQUIRE(decoder.read(&event));
+      REQUIRE(sameTraceEvent(event, expected));
+    }
+
+    std::uint64_t expected = 0;
+    while (events[expected].cycle < boundary)
+    {
+      expected++;
+    }
+    decoder.seekCycle(boundary);
+    REQUIRE(decoder.position() == expected);
+  }
+
+  SECTION("Stall reasons round-trip")
+  {
+    std::vector<VPUTraceEvent> events = kernelEvents(true);
+    std::istringstream input(encode(events, 64));
+    VPUTraceDecoder decoder(&input);
+    VPUTraceEvent event;
+    bool hasStallReason = false;
+
+    for (const VPUTraceEvent &expected : events)
+    {
+      REQUIRE(decoder.read(&event));
+      REQUIRE(sameTraceEvent(event, expected));
+      hasStallReason |= event.stallReason.unit != VPUStallUnit::None;
+    }
+    REQUIRE(hasStallReason);
+  }
+
+  SECTION("Malformed compressed traces and misuse are rejected")
+  {
+    std::vector<VPUTraceEvent> events = kernelEvents();
+    std::string trace = encode(events, 16);
+
+    std::istringstream badMagic("NKTX" + trace.substr(4));
+    REQUIRE_THROWS_WITH(
+      VPUTraceDecoder(&badMagic),
+      "VU compressed trace has an invalid header.");
+
+    std::istringstream truncated(trace.substr(0, trace.size() - 1));
+    REQUIRE_THROWS_WITH(
+      VPUTraceDecoder(&truncated),
+      "VU compressed trace has an invalid index.");
+
+    std::string corrupt = trace;
+    corrupt[VPU_COMPRESSED_TRACE_HEADER_SIZE] = static_cast<char>(0xc0);
+    std::istringstream corruptInput(corrupt);
+    VPUTraceDecoder decoder(&corruptInput);
+    VPUTraceEvent event;
+    REQUIRE_THROWS_WITH(
+      decoder.read(&event),
+      "VU compressed trace block is corrupt.");
+    REQUIRE_THROWS_AS(decoder.seek(events.size() + 1), std::out_of_range);
+
+    std::ostringstream output;
+    VPUTraceEncoder encoder(&output, VPUBinaryTraceHeader());
+    encoder.finish();
+    REQUIRE_THROWS_WITH(
+      encoder.write(events[0]),
+      "VU compressed trace has already been finished.");
+    REQUIRE_THROWS_WITH(
+      VPUTraceEncoder(&output, VPUBinaryTraceHeader(), 0),
+      "VU compressed trace blocks must hold at least one event.");
+  }
+}
@@ -0,0 +1,170 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_binary_trace.hpp"
+#include "vpu_register_ids.hpp"
+#include "vpu_trace_differ.hpp"
+
+namespace
+{
+  VPUTraceEvent issueAt(std::uint32_t cycle, std::uint16_t address)
+  {
+    VPUTraceEvent event = {};
+    event.type = VPUTraceEventType::InstructionIssued;
+    event.cycle = cycle;
+    event.instructionAddress = address;
+    return event;
+  }
+
+  std::string binaryTrace(const VPUProgramRunConfig &fixtureConfig)
+  {
+    VPUProgramRunConfig config = fixtureConfig;
+    std::ostringstream output;
+    config.traceOutput = &output;
+    config.traceOutputFormat = VPUTraceOutputFormat::Binary;
+    VPU vpu;
+    runVPUProgram(&vpu, config);
+    return output.str();
+  }
+
+  bool containsDifference(
+    const VPUTraceDivergence &divergence,
+    const std::string &difference)
+  {
+    for (const std::string &candidate : divergence.stateDifferences)
+    {
+      if (candidate == difference)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+TEST_CASE("VPU Trace Differ")
+{
+  SECTION("The first differing event is reported with its matched context")
+  {
+    VPUTraceDiffer differ(2);
+    for (std::uint16_t address = 0; address < 40; address += 8)
+    {
+      differ.addLeft(issueAt(address / 8, address));
+    }
+    for (std::uint16_t address = 0; address < 32; address += 8)
+    {
+      differ.addRight(issueAt(address / 8, address));
+    }
+    differ.addRight(issueAt(4, 0x100));
+    differ.addRight(issueAt(5, 0x108));
+
+    const VPUTraceDivergence &divergence = differ.divergence();
+
+    REQUIRE(differ.diverged());
+    REQUIRE(divergence.eventIndex == 4);
+    REQUIRE(divergence.hasLeftEvent);
+    REQUIRE(divergence.hasRightEvent);
+    REQUIRE(divergence.leftEvent.instructionAddress == 32);
+    REQUIRE(divergence.rightEvent.instructionAddress == 0x100);
+    REQUIRE(divergence.context.size() == 2);
+    REQUIRE(divergence.context[0].instructionAddress == 16);
+    REQUIRE(divergence.context[1].instructionAddress == 24);
+  }
+
+  SECTION("A stream that ends early diverges when the differ finishes")
+  {
+    VPUTraceDiffer differ;
+    differ.addLeft(issueAt(0, 0));
+    differ.addLeft(issueAt(1, 8));
+    differ.addRight(issueAt(0, 0));
+
+    REQUIRE_FALSE(differ.diverged());
+    differ.finish();
+
+    REQUIRE(differ.diverged());
+    REQUIRE(differ.divergence().eventIndex == 1);
+    REQUIRE(differ.divergence().hasLeftEvent);
+    REQUIRE_FALSE(differ.divergence().hasRightEvent);
+  }
+
+  SECTION("Lockstep runs of identical VPUs match on every fixture")
+  {
+    for (const vpu_integration::IntegrationFixture &fixture :
+      vpu_integration::integrationFixtures())
+    {
+      VPUProgramRunConfig config = fixture.config;
+      config.captureTrace = true;
+      VPU reference;
+      std::size_t eventCount =
+        runVPUProgram(&reference, config).traceEvents.size();
+      VPU left;
+      VPU right;
+
+      VPUTraceDivergence divergence =
+        diffVPUPrograms(&left, &right, fixture.config);
+
+      CAPTURE(fixture.name);
+      REQUIRE_FALSE(divergence.diverged);
+      REQUIRE(divergence.eventIndex == eventCount);
+      REQUIRE(divergence.stateDifferences.empty());
+    }
+  }
+
+  SECTION("Lockstep runs report register and memory differences")
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    VPU left;
+    VPU right;
+    right.loadIntFPRegister(VPU_REGISTER_VF30, 1, 0, 0, 0);
+    right.writeDataMemory(0x200, std::vector<std::uint8_t>(1, 0xab));
+
+    VPUTraceDivergence divergence = diffVPUPrograms(&left, &right, config);
+    std::ostringstream report;
+    writeVPUTraceDivergence(report, divergence);
+
+    REQUIRE(divergence.diverged);
+    REQUIRE_FALSE(divergence.hasLeftEvent);
+    REQUIRE_FALSE(divergence.hasRightEvent);
+    REQUIRE(containsDifference(divergence, "VF30.x: 0x0 != 0x1"));
+    REQUIRE(containsDifference(divergence,
+      "data memory 0x200: 00000000000000000000000000000000 != "
+      "ab000000000000000000000000000000"));
+    REQUIRE(report.str().find("but the states differ") != std::string::npos);
+  }
+
+  SECTION("Binary trace files are compared event by event")
+  {
+    std::vector<vpu_integration::IntegrationFixture> fixtures =
+      vpu_integration::integrationFixtures();
+    std::string kernel = binaryTrace(fixtures.back().config);
+    std::string shorter = kernel.substr(
+      0, kernel.size() - 3 * VPU_BINARY_TRACE_RECORD_SIZE);
+    std::istringstream left(kernel);
+    std::istringstream same(kernel);
+    std::istringstream leftAgain(kernel);
+    std::istringstream truncated(shorter);
+
+    VPUTraceDivergence match = diffVPUBinaryTraces(left, same);
+    VPUTraceDivergence divergence = diffVPUBinaryTraces(leftAgain, truncated);
+    std::ostringstream report;
+    writeVPUTraceDivergence(report, divergence);
+
+    REQUIRE_FALSE(match.diverged);
+    REQUIRE(divergence.diverged);
+    REQUIRE(divergence.eventIndex ==
+      (shorter.size() - VPU_BINARY_TRACE_HEADER_SIZE) /
+        VPU_BINARY_TRACE_RECORD_SIZE);
+    REQUIRE_FALSE(divergence.hasRightEvent);
+    REQUIRE(report.str().find("first divergence at event") == 0);
+    REQUIRE(report.str().find("right: <end of trace>") != std::string::npos);
+
+    std::istringstream kernelTrace(kernel);
+    std::istringstream otherProgram(binaryTrace(fixtures.front().config));
+    REQUIRE(diffVPUBinaryTraces(kernelTrace, otherProgram).diverged);
+  }
+}
@@ -0,0 +1,305 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_opcodes.hpp"
+#include "vpu_program_runner.hpp"
+#include "vpu_trace_file.hpp"
+
+namespace
+{
+  class TemporaryFile
+  {
+    public:
+      TemporaryFile()
+      {
+        char pathTemplate[] = "/tmp/neko_trace_XXXXXX";
+        int descriptor = mkstemp(pathTemplate);
+        REQUIRE(descriptor >= 0);
+        close(descriptor);
+        filePath = pathTemplate;
+      }
+
+      ~TemporaryFile()
+      {
+        std::remove(filePath.c_str());
+      }
+
+      const std::string &path() const
+      {
+        return filePath;
+      }
+
+    private:
+      std::string filePath;
+  };
+
+  VPUTraceEvent traceEvent(
+    VPUTraceEventType type,
+    std::uint64_t cycle,
+    std::uint16_t address)
+  {
+    VPUTraceEvent event = {};
+    event.type = type;
+    event.cycle = cycle;
+    event.instructionAddress = address;
+    return event;
+  }
+
+  void writeTrace(
+    const std::string &path,
+    const std::vector<VPUTraceEvent> &events)
+  {
+    std::ofstream output(path, std::ios::binary);
+    VPUBinaryTraceWriter writer(&output, VPUBinaryTraceHeader());
+    for (const VPUTraceEvent &event : events)
+    {
+      writer.write(event);
+    }
+  }
+
+  std::vector<VPUTraceEvent> writeKernelTrace(const std::string &path)
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    std::ofstream output(path, std::ios::binary);
+    config.captureTrace = true;
+    config.traceOutput = &output;
+    config.traceOutputFormat = VPUTraceOutputFormat::Binary;
+    VPU vpu;
+    return runVPUProgram(&vpu, config).traceEvents;
+  }
+
+  std::vector<VPUTraceEvent> collect(
+    const std::function<void(const VPUTraceEventVisitor &)> &query)
+  {
+    std::vector<VPUTraceEvent> events;
+    query([&events](const VPUTraceEvent &event) {
+      events.push_back(event);
+    });
+    return events;
+  }
+
+  bool sameEvents(
+    const std::vector<VPUTraceEvent> &left,
+    const std::vector<VPUTraceEvent> &right)
+  {
+    if (left.size() != right.size())
+    {
+      return false;
+    }
+    for (std::size_t index = 0; index < left.size(); index++)
+    {
+      if (left[index].type != right[index].type ||
+        left[index].cycle != right[index].cycle ||
+        left[index].instructionAddress != right[index].instructionAddress ||
+        left[index].opCode != right[index].opCode ||
+        left[index].destinationRegister != right[index].destinationRegister)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+TEST_CASE("VPU Trace File")
+{
+  SECTION("A mapped trace exposes every record of a binary trace")
+  {
+    TemporaryFile file;
+    std::vector<VPUTraceEvent> events = writeKernelTrace(file.path());
+
+    VPUTraceFile trace(file.path());
+
+    REQUIRE(trace.header().type == VPUType::VU0);
+    REQUIRE(trace.eventCount() == events.size());
+    std::vector<VPUTraceEvent> mapped;
+    for (std::size_t index = 0; index < trace.eventCount(); index++)
+    {
+      mapped.push_back(trace.event(index));
+    }
+    REQUIRE(sameEvents(mapped, events));
+    REQUIRE_THROWS_AS(trace.event(events.size()), std::out_of_range);
+  }
+
+  SECTION("Cycle lookups agree with a linear scan across index strides")
+  {
+    TemporaryFile file;
+    std::vector<VPUTraceEvent> events;
+    for (std::uint32_t index = 0; index < 5000; index++)
+    {
+      events.push_back(traceEvent(
+        VPUTraceEventType::InstructionIssued, index / 3 * 2, index % 64 * 8));
+    }
+    writeTrace(file.path(), events);
+
+    VPUTraceFile trace(file.path());
+
+    for (std::uint64_t cycle = 0; cycle <= events.back().cycle + 2; cycle++)
+    {
+      std::size_t expected = 0;
+      while (expected < events.size() && events[expected].cycle < cycle)
+      {
+        expected++;
+      }
+      CAPTURE(cycle);
+      REQUIRE(trace.firstEventAtOrAfter(cycle) == expected);
+    }
+
+    std::vector<VPUTraceEvent> range = collect(
+      [&trace](const VPUTraceEventVisitor &visitor) {
+        trace.eventsInCycleRange(1500, 1503, visitor);
+      });
+    std::vector<VPUTraceEvent> expected(
+      events.begin() + 2250, events.begin() + 2256);
+    REQUIRE(sameEvents(range, expected));
+  }
+
+  SECTION("Cycles past 2^32 keep their full width")
+  {
+    TemporaryFile file;
+    const std::uint64_t boundary = std::uint64_t(1) << 32;
+    std::vector<VPUTraceEvent> events;
+    for (std::uint64_t index = 0; index < 3000; index++)
+    {
+      events.push_back(traceEvent(
+        VPUTraceEventType::InstructionIssued, boundary - 1500 + index, 0));
+    }
+    writeTrace(file.path(), events);
+
+    VPUTraceFile trace(file.path());
+
+    REQUIRE(trace.event(2999).cycle == boundary + 1499);
+    REQUIRE(trace.firstEventAtOrAfter(boundary) == 1500);
+    REQUIRE(trace.firstEventAtOrAfter(boundary + 1000) == 2500);
+    REQUIRE(trace.firstEventAtOrAfter(1000) == 0);
+  }
+
+  SECTION("Issue and writeback queries match a filtered capture")
+  {
+    TemporaryFile file;
+    std::vector<VPUTraceEvent> events = writeKernelTrace(file.path());
+    VPUTraceFile trace(file.path());
+    std::vector<VPUTraceEvent> expectedIssues;
+    std::vector<VPUTraceEvent> expectedWritebacks;
+    for (const VPUTraceEvent &event : events)
+    {
+      if (event.type == VPUTraceEventType::InstructionIssued &&
+        event.instructionAddress == 24)
+      {
+        expectedIssues.push_back(event);
+      }
+      if (event.type == VPUTraceEventType::PipelineWriteback &&
+        vpuWritebackRegisterClass(event.opCode) ==
+          VPUStallRegisterClass::Float &&
+        event.destinationRegister == 11 &&
+        (event.destinationFieldMask & FP_REGISTER_Y_FIELD) != 0)
+      {
+        expectedWritebacks.push_back(event);
+      }
+    }
+
+    std::vector<VPUTraceEvent> issues = collect(
+      [&trace](const VPUTraceEventVisitor &visitor) {
+        trace.issuesAt(24, visitor);
+      });
+    std::vector<VPUTraceEvent> writebacks = collect(
+      [&trace](const VPUTraceEventVisitor &visitor) {
+        trace.writebacksTo(
+          VPUStallRegisterClass::Float, 11, FP_REGISTER_Y_FIELD, visitor);
+      });
+
+    REQUIRE_FALSE(expectedIssues.empty());
+    REQUIRE_FALSE(expectedWritebacks.empty());
+    REQUIRE(sameEvents(issues, expectedIssues));
+    REQUIRE(sameEvents(writebacks, expectedWritebacks));
+  }
+
+  SECTION("Writeback queries keep VI and VF registers apart")
+  {
+    TemporaryFile file;
+    std::vector<VPUTraceEvent> events = {
+      traceEvent(VPUTraceEventType::PipelineWriteback, 1, 0),
+      traceEvent(VPUTraceEventType::PipelineWriteback, 2, 8),
+      traceEvent(VPUTraceEventType::PipelineWriteback, 3, 16)
+    };
+    const std::uint16_t opCodes[] = {VPU_IADD, VPU_ADD, VPU_ILW};
+    for (std::size_t index = 0; index < events.size(); index++)
+    {
+      events[index].opCode = opCodes[index];
+      events[index].destinationRegister = 3;
+    }
+    events[1].destinationFieldMask = FP_REGISTER_X_FIELD;
+    events[2].destinationFieldMask = FP_REGISTER_X_FIELD;
+    writeTrace(file.path(), events);
+    VPUTraceFile trace(file.path());
+
+    std::vector<VPUTraceEvent> integer = collect(
+      [&trace](const VPUTraceEventVisitor &visitor) {
+        trace.writebacksTo(VPUStallRegisterClass::Integer, 3, 0, visitor);
+      });
+    std::vector<VPUTraceEvent> floating = collect(
+      [&trace](const VPUTraceEventVisitor &visitor) {
+        trace.writebacksTo(VPUStallRegisterClass::Float, 3, 0, visitor);
+      });
+
+    REQUIRE(sameEvents(integer, {events[0], events[2]}));
+    REQUIRE(sameEvents(floating, {events[1]}));
+  }
+
+  SECTION("Stall spans group consecutive stalls at one instruction")
+  {
+    TemporaryFile file;
+    std::vector<VPUTraceEvent> events;
+    for (std::uint32_t cycle = 10; cycle <= 14; cycle++)
+    {
+      events.push_back(
+        traceEvent(VPUTraceEventType::PipelineStall, cycle, 8));
+      events.push_back(
+        traceEvent(VPUTraceEventType::PipelineWriteback, cycle, 0));
+    }
+    events.push_back(traceEvent(VPUTraceEventType::PipelineStall, 15, 16));
+    events.push_back(traceEvent(VPUTraceEventType::PipelineStall, 20, 8));
+    events.push_back(traceEvent(VPUTraceEventType::PipelineStall, 21, 8));
+    writeTrace(file.path(), events);
+    VPUTraceFile trace(file.path());
+
+    std::vector<VPUTraceStallSpan> spans = trace.stallSpansLongerThan(1);
+    std::vector<VPUTraceStallSpan> longSpans = trace.stallSpansLongerThan(4);
+
+    REQUIRE(spans.size() == 2);
+    REQUIRE(spans[0].instructionAddress == 8);
+    REQUIRE(spans[0].firstCycle == 10);
+    REQUIRE(spans[0].lastCycle == 14);
+    REQUIRE(spans[1].firstCycle == 20);
+    REQUIRE(spans[1].lastCycle == 21);
+    REQUIRE(longSpans.size() == 1);
+    REQUIRE(longSpans[0].firstCycle == 10);
+  }
+
+  SECTION("Missing files and partial records are rejected")
+  {
+    TemporaryFile file;
+    writeTrace(file.path(), {traceEvent(
+      VPUTraceEventType::InstructionIssued, 0, 0)});
+    {
+      std::ofstream output(file.path(), std::ios::binary | std::ios::app);
+      output.put(0);
+    }
+
+    REQUIRE_THROWS_WITH(
+      VPUTraceFile(file.path()),
+      "VU binary trace ends with a partial record.");
+    REQUIRE_THROWS_WITH(
+      VPUTraceFile(file.path() + ".missing"),
+      "Unable to open VU trace file.");
+  }
+}
@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <vector>
+
+#include "catch.hpp"
+#include "vpu/integration/vpu_integration_fixtures.hpp"
+#include "vpu_program_runner.hpp"
+#include "vpu_trace_ring_buffer.hpp"
+
+namespace
+{
+  VPUTraceEvent eventAt(std::uint32_t cycle)
+  {
+    VPUTraceEvent event = {};
+    event.cycle = cycle;
+    return event;
+  }
+}
+
+TEST_CASE("VPU Trace Ring Buffer")
+{
+  SECTION("Only the most recent events are kept in order")
+  {
+    VPUTraceRingBuffer ring(3);
+    for (std::uint32_t cycle = 0; cycle < 5; cycle++)
+    {
+      ring.push(eventAt(cycle));
+    }
+
+    std::vector<VPUTraceEvent> events = ring.events();
+
+    REQUIRE(ring.capacity() == 3);
+    REQUIRE(ring.size() == 3);
+    REQUIRE(ring.droppedEvents() == 2);
+    REQUIRE(events.size() == 3);
+    REQUIRE(events[0].cycle == 2);
+    REQUIRE(events[1].cycle == 3);
+    REQUIRE(events[2].cycle == 4);
+
+    ring.clear();
+    ring.push(eventAt(9));
+    REQUIRE(ring.size() == 1);
+    REQUIRE(ring.droppedEvents() == 0);
+    REQUIRE(ring.events()[0].cycle == 9);
+  }
+
+  SECTION("A ring buffer needs room for at least one event")
+  {
+    REQUIRE_THROWS_WITH(
+      VPUTraceRingBuffer(0),
+      "VU trace ring buffer capacity must be greater than zero.");
+  }
+
+  SECTION("Bounded trace capture keeps the tail of a full capture")
+  {
+    VPUProgramRunConfig config =
+      vpu_integration::integrationFixtures().back().config;
+    config.captureTrace = true;
+    VPU fullVPU;
+    VPUProgramRunResult full = runVPUProgram(&fullVPU, config);
+    config.traceCapacity = 16;
+    VPU boundedVPU;
+
+    VPUProgramRunResult bounded = runVPUProgram(&boundedVPU, config);
+
+    REQUIRE(full.traceEvents.size() > 16);
+    REQUIRE(bounded.traceEvents.size() == 16);
+    REQUIRE(bounded.droppedTraceEvents == full.traceEvents.size() - 16);
+    for (std::size_t index = 0; index < 16; index++)
+    {
+      const VPUTraceEvent &expected =
+        full.traceEvents[full.traceEvents.size() - 16 + index];
+      REQUIRE(bounded.traceEvents[index].type == expected.type);
+      REQUIRE(bounded.traceEvents[index].cycle == expected.cycle);
+      REQUIRE(bounded.traceEvents[index].instructionAddress ==
+        expected.instructionAddress);
+    }
+  }
+}